@@ -1,10 +1,19 @@
 #include "ds18b20.h"
 #include "esp_rom_sys.h"
 #include "esp_log.h"
+#include <string.h>
 
 #define DS18B20_CMD_CONVERT_T     0x44
 #define DS18B20_CMD_READ_SCRATCH  0xBE
+#define DS18B20_CMD_WRITE_SCRATCH 0x4E
 #define DS18B20_CMD_SKIP_ROM      0xCC
+#define DS18B20_CMD_MATCH_ROM     0x55
+#define DS18B20_CMD_SEARCH_ROM    0xF0
+
+#define DS18B20_FAMILY_CODE       0x28
+#define DS18B20_SCRATCHPAD_SIZE   9
+#define DS18B20_CONFIG_FIXED_MASK 0x9F    // config register bits that are not R1:R0
+#define DS18B20_CONFIG_FIXED_BITS 0x1F
 
 static const char *TAG = "DS18B20";
 
@@ -64,12 +73,125 @@ static bool ds18b20_reset(ds18b20_t *dev)
     return presence;
 }
 
+// Dallas/Maxim CRC8 (polynomial x^8 + x^5 + x^4 + 1, reflected 0x8C)
+uint8_t ds18b20_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+    while (len--) {
+        uint8_t in = *data++;
+        for (int i = 0; i < 8; i++) {
+            uint8_t mix = (crc ^ in) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            in >>= 1;
+        }
+    }
+    return crc;
+}
+
+// Address one device: MATCH_ROM when the bus has been enumerated, SKIP_ROM otherwise
+static void ds18b20_select(ds18b20_t *sensor, uint8_t idx)
+{
+    if (sensor->count == 0) {
+        ds18b20_write_byte(sensor, DS18B20_CMD_SKIP_ROM);
+        return;
+    }
+
+    ds18b20_write_byte(sensor, DS18B20_CMD_MATCH_ROM);
+    for (int i = 0; i < DS18B20_ROM_SIZE; i++) {
+        ds18b20_write_byte(sensor, sensor->rom[idx][i]);
+    }
+}
+
+// ------------ ROM search (Maxim AN187) -------------
+//
+// Each pass walks the 64 ROM bits. For every bit all remaining devices answer
+// with the bit and its complement:
+//   0/1 or 1/0 -> every device agrees, follow that bit
+//   0/0        -> discrepancy, take 1 if below the last discrepancy, 0 if past it,
+//                 and repeat the previous choice when it is exactly the last one
+//   1/1        -> nobody answered, abort the pass
+// The deepest 0-branch taken becomes the starting point of the next pass.
+//
+esp_err_t ds18b20_search(ds18b20_t *sensor)
+{
+    if (!sensor) return ESP_ERR_INVALID_ARG;
+
+    uint8_t rom[DS18B20_ROM_SIZE] = {0};
+    int last_discrepancy = 0;
+    bool last_device = false;
+
+    sensor->count = 0;
+
+    while (!last_device && sensor->count < DS18B20_MAX_DEVICES) {
+        if (!ds18b20_reset(sensor)) break;
+
+        ds18b20_write_byte(sensor, DS18B20_CMD_SEARCH_ROM);
+
+        int last_zero = 0;
+        bool aborted = false;
+
+        for (int bit_number = 1; bit_number <= 64; bit_number++) {
+            int byte_idx = (bit_number - 1) / 8;
+            uint8_t mask = 1 << ((bit_number - 1) % 8);
+
+            int id_bit     = ds18b20_read_bit(sensor);
+            int cmp_id_bit = ds18b20_read_bit(sensor);
+
+            if (id_bit && cmp_id_bit) {
+                aborted = true;
+                break;
+            }
+
+            int dir;
+            if (id_bit != cmp_id_bit) {
+                dir = id_bit;
+            } else {
+                if (bit_number < last_discrepancy)
+                    dir = (rom[byte_idx] & mask) ? 1 : 0;
+                else
+                    dir = (bit_number == last_discrepancy);
+
+                if (dir == 0) last_zero = bit_number;
+            }
+
+            if (dir) rom[byte_idx] |= mask;
+            else rom[byte_idx] &= ~mask;
+
+            ds18b20_write_bit(sensor, dir);
+        }
+
+        if (aborted) break;
+
+        last_discrepancy = last_zero;
+        if (last_discrepancy == 0) last_device = true;
+
+        if (ds18b20_crc8(rom, DS18B20_ROM_SIZE - 1) != rom[DS18B20_ROM_SIZE - 1]) {
+            ESP_LOGW(TAG, "ROM CRC mismatch, aborting search");
+            break;
+        }
+
+        if (rom[0] != DS18B20_FAMILY_CODE) {
+            ESP_LOGW(TAG, "Skipping non-DS18B20 device (family 0x%02X)", rom[0]);
+            continue;
+        }
+
+        memcpy(sensor->rom[sensor->count], rom, DS18B20_ROM_SIZE);
+        sensor->count++;
+    }
+
+    sensor->present = sensor->count > 0;
+    return sensor->present ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
 esp_err_t ds18b20_init(ds18b20_t *sensor, gpio_num_t pin)
 {
     if (!sensor) return ESP_ERR_INVALID_ARG;
 
     sensor->pin = pin;
     sensor->present = false;
+    sensor->count = 0;
+    sensor->resolution = 12;   // power-on default
 
     gpio_reset_pin(pin);
     gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
@@ -81,31 +203,46 @@ esp_err_t ds18b20_init(ds18b20_t *sensor, gpio_num_t pin)
         return ESP_OK;   // ← IMPORTANT: do NOT fail init
     }
 
-    ESP_LOGI(TAG, "DS18B20 detected");
+    if (ds18b20_search(sensor) != ESP_OK) {
+        // Something answered the reset but the search failed (noise, foreign device).
+        // Fall back to SKIP_ROM single-sensor mode.
+        sensor->present = true;
+        sensor->count = 0;
+        ESP_LOGW(TAG, "ROM search failed, using SKIP_ROM");
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < sensor->count; i++) {
+        const uint8_t *r = sensor->rom[i];
+        ESP_LOGI(TAG, "DS18B20 #%d ROM %02X%02X%02X%02X%02X%02X%02X%02X",
+                 i, r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7]);
+    }
     return ESP_OK;
 }
 
-esp_err_t ds18b20_read_temperature(ds18b20_t *sensor, float *temperature) {
-    if (!sensor || !temperature) return ESP_ERR_INVALID_ARG;
+// Convert and read the first probe (or the only one in SKIP_ROM mode)
+static esp_err_t ds18b20_convert_read(ds18b20_t *sensor, int16_t *temp_q4)
+{
+    esp_err_t err = ds18b20_start_conversion(sensor);
+    if (err != ESP_OK) return err;
 
-    if (!ds18b20_reset(sensor)) {
-        ESP_LOGE(TAG, "Sensor not found");
-        return ESP_FAIL;
-    }
+    err = ds18b20_wait_conversion(sensor);
+    if (err != ESP_OK) return err;
 
-    ds18b20_write_byte(sensor, DS18B20_CMD_SKIP_ROM);
-    ds18b20_write_byte(sensor, DS18B20_CMD_CONVERT_T);
-    vTaskDelay(pdMS_TO_TICKS(750)); // wait for conversion
+    return ds18b20_read_scratchpad_fixed(sensor, 0, temp_q4);
+}
 
-    if (!ds18b20_reset(sensor)) return ESP_FAIL;
-    ds18b20_write_byte(sensor, DS18B20_CMD_SKIP_ROM);
-    ds18b20_write_byte(sensor, DS18B20_CMD_READ_SCRATCH);
+esp_err_t ds18b20_read_temperature(ds18b20_t *sensor, float *temperature) {
+    if (!sensor || !temperature) return ESP_ERR_INVALID_ARG;
 
-    uint8_t lsb = ds18b20_read_byte(sensor);
-    uint8_t msb = ds18b20_read_byte(sensor);
-    int16_t raw_temp = (msb << 8) | lsb;
+    int16_t q4;
+    esp_err_t err = ds18b20_convert_read(sensor, &q4);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Read failed: %s", esp_err_to_name(err));
+        return err;
+    }
 
-    *temperature = (float)raw_temp / 16.0f;
+    *temperature = (float)q4 / (1 << DS18B20_FRAC_BITS);
     return ESP_OK;
 }
 
@@ -119,26 +256,15 @@ esp_err_t ds18b20_read_temperature_int(ds18b20_t *sensor,
     if (!sensor->present)
         return ESP_ERR_NOT_FOUND;
 
-    if (!ds18b20_reset(sensor)) {
+    int16_t q4;
+    esp_err_t err = ds18b20_convert_read(sensor, &q4);
+    if (err == ESP_ERR_NOT_FOUND) {
         sensor->present = false;   // hot unplug detection
         ESP_LOGW(TAG, "Sensor disappeared");
-        return ESP_ERR_NOT_FOUND;
     }
+    if (err != ESP_OK) return err;
 
-    ds18b20_write_byte(sensor, DS18B20_CMD_SKIP_ROM);
-    ds18b20_write_byte(sensor, DS18B20_CMD_CONVERT_T);
-    vTaskDelay(pdMS_TO_TICKS(750)); // wait conversion
-
-    if (!ds18b20_reset(sensor)) return ESP_FAIL;
-    ds18b20_write_byte(sensor, DS18B20_CMD_SKIP_ROM);
-    ds18b20_write_byte(sensor, DS18B20_CMD_READ_SCRATCH);
-
-    uint8_t lsb = ds18b20_read_byte(sensor);
-    uint8_t msb = ds18b20_read_byte(sensor);
-    int16_t raw_temp = (msb << 8) | lsb;
-
-    *temperature = raw_temp >> 4;  // Divide by 16, truncate fractional part
-
+    *temperature = q4 / (1 << DS18B20_FRAC_BITS);   // whole degrees, toward zero
     return ESP_OK;
 }
 
@@ -153,18 +279,95 @@ esp_err_t ds18b20_start_conversion(ds18b20_t *sensor)
     return ESP_OK;
 }
 
-esp_err_t ds18b20_read_scratchpad_temp(ds18b20_t *sensor, int16_t *temp_out)
+uint32_t ds18b20_conversion_time_ms(uint8_t resolution)
 {
+    // 93.75 ms at 9 bits, doubling per extra bit (datasheet max, rounded up)
+    if (resolution < 9) resolution = 9;
+    if (resolution > 12) resolution = 12;
+    return 94u << (resolution - 9);
+}
+
+esp_err_t ds18b20_set_resolution(ds18b20_t *sensor, uint8_t resolution)
+{
+    if (!sensor || resolution < 9 || resolution > 12) return ESP_ERR_INVALID_ARG;
+
     if (!ds18b20_reset(sensor))
         return ESP_ERR_NOT_FOUND;
 
+    // Broadcast to every probe on the pin: TH, TL (alarms unused), config
     ds18b20_write_byte(sensor, DS18B20_CMD_SKIP_ROM);
+    ds18b20_write_byte(sensor, DS18B20_CMD_WRITE_SCRATCH);
+    ds18b20_write_byte(sensor, 0x7F);
+    ds18b20_write_byte(sensor, 0x80);
+    ds18b20_write_byte(sensor, ((resolution - 9) << 5) | DS18B20_CONFIG_FIXED_BITS);
+
+    sensor->resolution = resolution;
+    return ESP_OK;
+}
+
+// After CONVERT_T a read slot returns 0 while any probe on the pin is still
+// converting (wired-AND) and 1 once all are done. Poll one slot per tick so the
+// task sleeps in between; give up after twice the datasheet conversion time.
+esp_err_t ds18b20_wait_conversion(ds18b20_t *sensor)
+{
+    if (!sensor) return ESP_ERR_INVALID_ARG;
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t limit = pdMS_TO_TICKS(2 * ds18b20_conversion_time_ms(sensor->resolution)) + 1;
+
+    while (!ds18b20_read_bit(sensor)) {
+        if ((xTaskGetTickCount() - start) > limit)
+            return ESP_ERR_TIMEOUT;
+        vTaskDelay(1);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_read_scratchpad_fixed(ds18b20_t *sensor, uint8_t idx, int16_t *temp_q4)
+{
+    if (!sensor || !temp_q4) return ESP_ERR_INVALID_ARG;
+    if (sensor->count && idx >= sensor->count) return ESP_ERR_INVALID_ARG;
+
+    if (!ds18b20_reset(sensor))
+        return ESP_ERR_NOT_FOUND;
+
+    ds18b20_select(sensor, idx);
     ds18b20_write_byte(sensor, DS18B20_CMD_READ_SCRATCH);
 
-    uint8_t lsb = ds18b20_read_byte(sensor);
-    uint8_t msb = ds18b20_read_byte(sensor);
+    uint8_t sp[DS18B20_SCRATCHPAD_SIZE];
+    for (int i = 0; i < DS18B20_SCRATCHPAD_SIZE; i++) {
+        sp[i] = ds18b20_read_byte(sensor);
+    }
 
-    *temp_out = (int16_t)((msb << 8) | lsb) / 16;
+    // A stuck bus passes the CRC too: all zeros (DQ shorted low) has CRC 0. The
+    // config byte is 0RR11111 on every DS18B20, which neither all-zeros nor
+    // all-ones (device not driving the bus) matches.
+    if (ds18b20_crc8(sp, DS18B20_SCRATCHPAD_SIZE - 1) != sp[DS18B20_SCRATCHPAD_SIZE - 1] ||
+        (sp[4] & DS18B20_CONFIG_FIXED_MASK) != DS18B20_CONFIG_FIXED_BITS)
+        return ESP_ERR_INVALID_CRC;
+
+    // Below 12 bits the low fraction bits are undefined; use the probe's own config byte
+    int res = 9 + ((sp[4] >> 5) & 0x03);
+    int16_t raw = (int16_t)((sp[1] << 8) | sp[0]);
+    raw &= ~((1 << (12 - res)) - 1);
+
+    *temp_q4 = raw;
 
     return ESP_OK;
 }
+
+esp_err_t ds18b20_read_scratchpad_temp_idx(ds18b20_t *sensor, uint8_t idx, int16_t *temp_out)
+{
+    int16_t q4;
+    esp_err_t err = ds18b20_read_scratchpad_fixed(sensor, idx, &q4);
+    if (err != ESP_OK) return err;
+
+    *temp_out = q4 / (1 << DS18B20_FRAC_BITS);
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_read_scratchpad_temp(ds18b20_t *sensor, int16_t *temp_out)
+{
+    return ds18b20_read_scratchpad_temp_idx(sensor, 0, temp_out);
+}
@@ -8,18 +8,74 @@
 extern "C" {
 #endif
 
+#define DS18B20_MAX_DEVICES  8    // sensors kept per 1-Wire pin
+#define DS18B20_ROM_SIZE     8    // family code, 48-bit serial, CRC8
+#define DS18B20_FRAC_BITS    4    // fixed-point temperatures are in 1/16 °C
+
 typedef struct {
     gpio_num_t pin;
     bool present;
+    uint8_t resolution;                                  // 9..12 bits, last value written
+    uint8_t count;                                       // devices found by ds18b20_search (0 = SKIP_ROM mode)
+    uint8_t rom[DS18B20_MAX_DEVICES][DS18B20_ROM_SIZE];  // ROM codes in search order
 } ds18b20_t;
 
 
 esp_err_t ds18b20_init(ds18b20_t *sensor, gpio_num_t pin);
+
+/**
+ * @brief Convert, wait for it and read the first probe (ds18b20_read_scratchpad_fixed)
+ */
 esp_err_t ds18b20_read_temperature(ds18b20_t *sensor, float *temperature);
+
+/**
+ * @brief As ds18b20_read_temperature, whole °C rounded toward zero
+ */
 esp_err_t ds18b20_read_temperature_int(ds18b20_t *sensor, int16_t *temperature);
 
+/**
+ * @brief Enumerate every DS18B20 on the pin into sensor->rom[] (called by ds18b20_init)
+ */
+esp_err_t ds18b20_search(ds18b20_t *sensor);
+
+/**
+ * @brief Dallas CRC8 over len bytes (ROM codes and scratchpads end with it)
+ */
+uint8_t ds18b20_crc8(const uint8_t *data, size_t len);
+
+/**
+ * @brief Broadcast CONVERT_T: every sensor on the pin converts in the same window
+ */
 esp_err_t ds18b20_start_conversion(ds18b20_t *sensor);
 
+/**
+ * @brief Write the 9..12 bit resolution to every probe's config register
+ */
+esp_err_t ds18b20_set_resolution(ds18b20_t *sensor, uint8_t resolution);
+
+/**
+ * @brief Worst-case conversion time for a resolution (94, 188, 375, 750 ms)
+ */
+uint32_t ds18b20_conversion_time_ms(uint8_t resolution);
+
+/**
+ * @brief Block (sleeping between read slots) until the conversion completes
+ * @return ESP_ERR_TIMEOUT if the bus never reports done
+ */
+esp_err_t ds18b20_wait_conversion(ds18b20_t *sensor);
+
+/**
+ * @brief Read device idx as fixed point (°C << DS18B20_FRAC_BITS), CRC checked
+ * @return ESP_ERR_INVALID_CRC if the scratchpad is corrupt or the bus is stuck (all 0 / all 1)
+ */
+esp_err_t ds18b20_read_scratchpad_fixed(ds18b20_t *sensor, uint8_t idx, int16_t *temp_q4);
+
+/**
+ * @brief Read device idx (MATCH_ROM) after a conversion, CRC checked
+ * @return ESP_ERR_INVALID_CRC if the scratchpad is corrupt
+ */
+esp_err_t ds18b20_read_scratchpad_temp_idx(ds18b20_t *sensor, uint8_t idx, int16_t *temp_out);
+
 esp_err_t ds18b20_read_scratchpad_temp(ds18b20_t *sensor, int16_t *temp_out);
 
 #ifdef __cplusplus
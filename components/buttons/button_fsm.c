@@ -0,0 +1,74 @@
+#include "button_fsm.h"
+
+void button_fsm_reset(button_fsm_t *fsm)
+{
+    fsm->pressed = false;
+    fsm->long_sent = false;
+    fsm->press_us = 0;
+    fsm->next_repeat_us = 0;
+}
+
+static void emit(button_fsm_out_t *out, button_event_type_t type)
+{
+    if (out->count < BUTTON_FSM_MAX_EVENTS)
+        out->events[out->count++] = type;
+}
+
+// Earliest of the pending long-press and repeat deadlines
+static int64_t next_deadline(const button_fsm_t *fsm, const button_timing_t *t)
+{
+    int64_t next = 0;
+
+    if (!fsm->pressed) return 0;
+
+    if (t->long_us && !fsm->long_sent)
+        next = fsm->press_us + t->long_us;
+
+    if (fsm->next_repeat_us && (next == 0 || fsm->next_repeat_us < next))
+        next = fsm->next_repeat_us;
+
+    return next;
+}
+
+void button_fsm_level(button_fsm_t *fsm, const button_timing_t *t,
+                      bool pressed, int64_t now_us, button_fsm_out_t *out)
+{
+    out->count = 0;
+
+    if (pressed && !fsm->pressed) {
+        fsm->pressed = true;
+        fsm->long_sent = false;
+        fsm->press_us = now_us;
+        fsm->next_repeat_us = t->repeat_delay_us ? now_us + t->repeat_delay_us : 0;
+        emit(out, BUTTON_EVT_PRESS);
+    } else if (!pressed && fsm->pressed) {
+        button_fsm_reset(fsm);
+        emit(out, BUTTON_EVT_RELEASE);
+    }
+
+    out->next_deadline_us = next_deadline(fsm, t);
+}
+
+void button_fsm_timer(button_fsm_t *fsm, const button_timing_t *t,
+                      int64_t now_us, button_fsm_out_t *out)
+{
+    out->count = 0;
+
+    if (fsm->pressed) {
+        if (t->long_us && !fsm->long_sent && now_us >= fsm->press_us + t->long_us) {
+            fsm->long_sent = true;
+            emit(out, BUTTON_EVT_LONG);
+        }
+
+        if (fsm->next_repeat_us && now_us >= fsm->next_repeat_us) {
+            emit(out, BUTTON_EVT_REPEAT);
+            // Catch up without bursting if the timer ran late
+            do {
+                fsm->next_repeat_us += t->repeat_rate_us;
+            } while (t->repeat_rate_us && fsm->next_repeat_us <= now_us);
+            if (!t->repeat_rate_us) fsm->next_repeat_us = 0;
+        }
+    }
+
+    out->next_deadline_us = next_deadline(fsm, t);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pure per-button state machine (no GPIO, no timers) so it can run anywhere.
+// buttons.c feeds it debounced levels and hold-timer expiries and arms the
+// one-shot timer for whatever deadline it asks for.
+
+typedef enum {
+    BUTTON_EVT_PRESS = 0,
+    BUTTON_EVT_LONG,      // held for long_us (once per press)
+    BUTTON_EVT_REPEAT,    // auto-repeat while held
+    BUTTON_EVT_RELEASE,
+} button_event_type_t;
+
+typedef struct {
+    int64_t long_us;          // 0 = no long-press event
+    int64_t repeat_delay_us;  // first repeat after press, 0 = no repeat
+    int64_t repeat_rate_us;
+} button_timing_t;
+
+typedef struct {
+    bool pressed;
+    bool long_sent;
+    int64_t press_us;
+    int64_t next_repeat_us;   // 0 = repeat not scheduled
+} button_fsm_t;
+
+#define BUTTON_FSM_MAX_EVENTS  2
+
+typedef struct {
+    int count;
+    button_event_type_t events[BUTTON_FSM_MAX_EVENTS];
+    int64_t next_deadline_us; // absolute time for the hold timer, 0 = stop it
+} button_fsm_out_t;
+
+void button_fsm_reset(button_fsm_t *fsm);
+
+/**
+ * @brief Debounced level sample at now_us
+ */
+void button_fsm_level(button_fsm_t *fsm, const button_timing_t *t,
+                      bool pressed, int64_t now_us, button_fsm_out_t *out);
+
+/**
+ * @brief Hold timer expired at now_us
+ */
+void button_fsm_timer(button_fsm_t *fsm, const button_timing_t *t,
+                      int64_t now_us, button_fsm_out_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,141 @@
+#include "buttons.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "BUTTONS";
+
+// Edges only start a one-shot: the GPIO interrupt is masked for the debounce
+// window, the debounce callback samples the settled level and feeds the state
+// machine, and a second one-shot drives long-press / repeat. Nothing runs while
+// the buttons are idle.
+typedef struct {
+    bool used;
+    gpio_num_t pin;
+    button_timing_t timing;
+    button_fsm_t fsm;
+    esp_timer_handle_t debounce_timer;
+    esp_timer_handle_t hold_timer;
+} button_slot_t;
+
+static button_slot_t buttons[BUTTONS_MAX];
+static QueueHandle_t event_queue = NULL;
+
+static void post_events(uint8_t id, const button_fsm_out_t *out, int64_t now)
+{
+    for (int i = 0; i < out->count; i++) {
+        button_event_t ev = { .id = id, .type = out->events[i], .time_us = now };
+        if (xQueueSend(event_queue, &ev, 0) != pdTRUE)
+            ESP_LOGW(TAG, "Event queue full, dropped %d/%d", id, ev.type);
+    }
+}
+
+static void arm_hold_timer(button_slot_t *b, int64_t deadline, int64_t now)
+{
+    esp_timer_stop(b->hold_timer);   // ESP_ERR_INVALID_STATE when idle is fine
+    if (deadline) {
+        int64_t wait = deadline - now;
+        esp_timer_start_once(b->hold_timer, wait > 0 ? wait : 1);
+    }
+}
+
+static void IRAM_ATTR button_isr_handler(void *arg)
+{
+    button_slot_t *b = (button_slot_t *)arg;
+    gpio_intr_disable(b->pin);
+    esp_timer_start_once(b->debounce_timer, BUTTON_DEBOUNCE_MS * 1000);
+}
+
+static void debounce_cb(void *arg)
+{
+    button_slot_t *b = (button_slot_t *)arg;
+    uint8_t id = b - buttons;
+    int64_t now = esp_timer_get_time();
+    button_fsm_out_t out;
+
+    bool pressed = (gpio_get_level(b->pin) == 0);
+    button_fsm_level(&b->fsm, &b->timing, pressed, now, &out);
+    post_events(id, &out, now);
+    arm_hold_timer(b, out.next_deadline_us, now);
+
+    gpio_intr_enable(b->pin);
+
+    // An edge that landed while masked would otherwise be lost
+    if ((gpio_get_level(b->pin) == 0) != b->fsm.pressed) {
+        gpio_intr_disable(b->pin);
+        esp_timer_start_once(b->debounce_timer, BUTTON_DEBOUNCE_MS * 1000);
+    }
+}
+
+static void hold_cb(void *arg)
+{
+    button_slot_t *b = (button_slot_t *)arg;
+    uint8_t id = b - buttons;
+    int64_t now = esp_timer_get_time();
+    button_fsm_out_t out;
+
+    button_fsm_timer(&b->fsm, &b->timing, now, &out);
+    post_events(id, &out, now);
+    arm_hold_timer(b, out.next_deadline_us, now);
+}
+
+esp_err_t buttons_init(void)
+{
+    if (event_queue) return ESP_OK;
+
+    event_queue = xQueueCreate(BUTTON_QUEUE_LEN, sizeof(button_event_t));
+    if (!event_queue) return ESP_ERR_NO_MEM;
+
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;   // already installed is fine
+
+    return ESP_OK;
+}
+
+esp_err_t buttons_add(uint8_t id, gpio_num_t pin, const button_timing_t *timing)
+{
+    if (id >= BUTTONS_MAX || !timing || !event_queue) return ESP_ERR_INVALID_ARG;
+
+    button_slot_t *b = &buttons[id];
+    if (b->used) return ESP_ERR_INVALID_STATE;
+
+    b->pin = pin;
+    b->timing = *timing;
+    button_fsm_reset(&b->fsm);
+
+    esp_timer_create_args_t args = {
+        .callback = debounce_cb,
+        .arg = b,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "btn_debounce",
+    };
+    esp_err_t err = esp_timer_create(&args, &b->debounce_timer);
+    if (err != ESP_OK) return err;
+
+    args.callback = hold_cb;
+    args.name = "btn_hold";
+    err = esp_timer_create(&args, &b->hold_timer);
+    if (err != ESP_OK) return err;
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,     // use only external pull-ups
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,        // press and release both matter now
+    };
+    err = gpio_config(&io_conf);
+    if (err != ESP_OK) return err;
+
+    b->used = true;
+    return gpio_isr_handler_add(pin, button_isr_handler, b);
+}
+
+QueueHandle_t buttons_queue(void)
+{
+    return event_queue;
+}
+
+bool buttons_is_pressed(uint8_t id)
+{
+    return id < BUTTONS_MAX && buttons[id].used && buttons[id].fsm.pressed;
+}
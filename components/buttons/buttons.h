@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "button_fsm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUTTONS_MAX            4
+#define BUTTON_DEBOUNCE_MS     30     // edge must stay stable this long
+#define BUTTON_QUEUE_LEN       16
+
+typedef struct {
+    uint8_t id;                // index passed to buttons_add
+    button_event_type_t type;
+    int64_t time_us;           // esp_timer time of the debounced edge / timer expiry
+} button_event_t;
+
+/**
+ * @brief Create the event queue; buttons_add() registers each input
+ */
+esp_err_t buttons_init(void);
+
+/**
+ * @brief Register an active-low input (external pull-up) as button id
+ */
+esp_err_t buttons_add(uint8_t id, gpio_num_t pin, const button_timing_t *timing);
+
+/**
+ * @brief Queue of button_event_t, read by the consumer task
+ */
+QueueHandle_t buttons_queue(void);
+
+/**
+ * @brief Debounced state, for code that needs to know if a button is still down
+ */
+bool buttons_is_pressed(uint8_t id);
+
+#ifdef __cplusplus
+}
+#endif
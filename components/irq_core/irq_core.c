@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include "irq_core.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_intr_alloc.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "IRQ_CORE";
+
+#if (IRQ_CORE_ESP_TIMER == 0 && !(CONFIG_ESP_TIMER_ISR_AFFINITY_CPU0 && CONFIG_ESP_TIMER_TASK_AFFINITY_CPU0)) || \
+    (IRQ_CORE_ESP_TIMER == 1 && !(CONFIG_ESP_TIMER_ISR_AFFINITY_CPU1 && CONFIG_ESP_TIMER_TASK_AFFINITY_CPU1))
+#error "IRQ_CORE_ESP_TIMER does not match the esp_timer ISR/task affinity in sdkconfig"
+#endif
+
+#define CALL_STACK   4096    // driver installs log and allocate
+
+typedef struct {
+    irq_core_fn_t fn;
+    void *arg;
+    esp_err_t err;
+    SemaphoreHandle_t done;
+} call_t;
+
+static void call_task(void *p)
+{
+    call_t *c = p;
+    c->err = c->fn(c->arg);
+    xSemaphoreGive(c->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t irq_core_call(int core, irq_core_fn_t fn, void *arg)
+{
+    if (core == xPortGetCoreID()) return fn(arg);
+
+    call_t c = { .fn = fn, .arg = arg, .err = ESP_FAIL, .done = xSemaphoreCreateBinary() };
+    if (!c.done) return ESP_ERR_NO_MEM;
+
+    if (xTaskCreatePinnedToCore(call_task, "IrqInstall", CALL_STACK, &c, uxTaskPriorityGet(NULL),
+                                NULL, core) != pdPASS) {
+        vSemaphoreDelete(c.done);
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreTake(c.done, portMAX_DELAY);
+    vSemaphoreDelete(c.done);
+
+    if (c.err != ESP_OK) ESP_LOGE(TAG, "Install on core %d failed: %s", core, esp_err_to_name(c.err));
+    return c.err;
+}
+
+void irq_core_dump(void)
+{
+#if IRQ_CORE_DUMP
+    ESP_LOGI(TAG, "Refresh on core %d, GPIO %d, I2C %d, UART %d, esp_timer %d", IRQ_CORE_REFRESH,
+             IRQ_CORE_GPIO, IRQ_CORE_I2C, IRQ_CORE_UART, IRQ_CORE_ESP_TIMER);
+    esp_intr_dump(stdout);
+#endif
+}
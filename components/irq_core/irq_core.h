@@ -0,0 +1,38 @@
+#pragma once
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Where interrupts land. A driver allocates its interrupt on the core that
+// installs it, and app_main runs on core 0 next to refresh_task: an ISR there
+// stretches the lit row it interrupts (a bright line). Drivers are installed
+// through irq_core_call() with the core from the map below instead.
+
+// ------------ CONFIG: interrupt cores ------------
+#define IRQ_CORE_REFRESH     0    // refresh_task (and its flash-write timer ISR)
+#define IRQ_CORE_GPIO        1    // gpio_install_isr_service: buttons
+#define IRQ_CORE_I2C         1    // DS3231 bus
+#define IRQ_CORE_UART        1    // uart_stream
+// esp_timer's ISR and callback task are placed by sdkconfig
+// (CONFIG_ESP_TIMER_ISR_AFFINITY_CPUx, CONFIG_ESP_TIMER_TASK_AFFINITY_CPUx); irq_core.c
+// refuses to build if they disagree with this
+#define IRQ_CORE_ESP_TIMER   1
+#define IRQ_CORE_DUMP        1    // list the allocated interrupts after boot (esp_intr_dump)
+
+typedef esp_err_t (*irq_core_fn_t)(void *arg);
+
+/**
+ * @brief Run fn(arg) on `core` (a short-lived pinned task) and return its result
+ */
+esp_err_t irq_core_call(int core, irq_core_fn_t fn, void *arg);
+
+/**
+ * @brief Log the interrupt table if IRQ_CORE_DUMP (call once the drivers are installed)
+ */
+void irq_core_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
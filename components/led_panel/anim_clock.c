@@ -0,0 +1,47 @@
+#include "anim_clock.h"
+
+#define LEAD_MAX_US   50000     // a frame slower than this is an outlier, not the norm
+
+void anim_clock_begin_frame(anim_clock_t *c, int64_t now_us)
+{
+    c->begin_us = now_us;
+    c->frame_us = now_us + c->lead_us;
+}
+
+void anim_clock_end_frame(anim_clock_t *c, int64_t now_us)
+{
+    int64_t lead = now_us - c->begin_us;
+    if (lead < 0) lead = 0;
+    if (lead > LEAD_MAX_US) lead = LEAD_MAX_US;
+
+    // Exponential average, 1/8 weight per frame
+    c->lead_us += ((int32_t)lead - c->lead_us) / 8;
+}
+
+void anim_linear_start(anim_linear_t *a, int64_t t0_us, fx_t x0, int32_t px_per_s)
+{
+    a->t0_us = t0_us;
+    a->x0 = x0;
+    a->px_per_s = px_per_s;
+}
+
+fx_t anim_linear_at(const anim_linear_t *a, int64_t t_us)
+{
+    // px/s * µs * 2^16 / 10^6, in 64 bits: exact for hours of scrolling
+    int64_t d = (int64_t)a->px_per_s * (t_us - a->t0_us) * FX_ONE / 1000000;
+    return a->x0 + (fx_t)d;
+}
+
+bool anim_blink_on(int64_t t_us, int64_t anchor_us, uint32_t period_us, uint32_t on_us)
+{
+    int64_t phase = (t_us - anchor_us) % period_us;
+    if (phase < 0) phase += period_us;
+    return phase < on_us;
+}
+
+fx_t anim_progress(int64_t t_us, int64_t start_us, uint32_t duration_us)
+{
+    if (t_us <= start_us) return 0;
+    if (duration_us == 0 || t_us >= start_us + duration_us) return FX_ONE;
+    return (fx_t)((t_us - start_us) * FX_ONE / duration_us);
+}
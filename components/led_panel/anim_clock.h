@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Shared animation timebase, no IDF dependencies (builds on the host).
+//
+// Every animation is a function of time, never an accumulated step: positions are
+// evaluated from their start point at the frame's time, so frame jitter moves
+// nothing but the sampling instant. The frame time is the expected scan-out time
+// (frame start + how long drawing and presenting usually take), in µs from
+// esp_timer_get_time(). Positions are 16.16 fixed point pixels.
+
+typedef int32_t fx_t;
+
+#define FX_SHIFT          16
+#define FX_ONE            (1 << FX_SHIFT)
+#define FX_FROM_INT(i)    ((fx_t)((i) * FX_ONE))
+#define FX_TO_INT(f)      ((int)((f) >> FX_SHIFT))     // floor
+
+typedef struct {
+    int64_t frame_us;      // time the current frame is evaluated at
+    int64_t begin_us;      // when the current frame started drawing
+    int32_t lead_us;       // smoothed begin -> present latency
+} anim_clock_t;
+
+/**
+ * @brief Start a frame at now_us; animations of this frame use anim_clock_now()
+ */
+void anim_clock_begin_frame(anim_clock_t *c, int64_t now_us);
+
+/**
+ * @brief The frame was presented at now_us: update the scan-out lead estimate
+ */
+void anim_clock_end_frame(anim_clock_t *c, int64_t now_us);
+
+static inline int64_t anim_clock_now(const anim_clock_t *c)
+{
+    return c->frame_us;
+}
+
+// Constant velocity from x0 at t0
+typedef struct {
+    int64_t t0_us;
+    fx_t x0;
+    int32_t px_per_s;      // signed, e.g. -10 scrolls left
+} anim_linear_t;
+
+void anim_linear_start(anim_linear_t *a, int64_t t0_us, fx_t x0, int32_t px_per_s);
+fx_t anim_linear_at(const anim_linear_t *a, int64_t t_us);
+
+/**
+ * @brief Square wave: on for on_us at the start of every period_us from anchor_us
+ */
+bool anim_blink_on(int64_t t_us, int64_t anchor_us, uint32_t period_us, uint32_t on_us);
+
+/**
+ * @brief 0 .. FX_ONE over [start_us, start_us + duration_us], clamped
+ */
+fx_t anim_progress(int64_t t_us, int64_t start_us, uint32_t duration_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+#include "canvas_convert.h"
+
+static uint32_t spread(uint8_t q, int depth, int channel)
+{
+    uint32_t w = 0;
+    for (int p = 0; p < depth; p++) {
+        if ((q >> p) & 1) w |= (uint32_t)(1u << channel) << (8 * p);
+    }
+    return w;
+}
+
+void canvas_build_luts(canvas_luts_t *l, const uint8_t gamma[256], int depth)
+{
+    for (int v = 0; v < 256; v++) {
+        l->r8[v] = spread(gamma[v], depth, 0);
+        l->g8[v] = spread(gamma[v], depth, 1);
+        l->b8[v] = spread(gamma[v], depth, 2);
+    }
+    // 565 fields expanded to 8 bits the usual way (replicate the top bits)
+    for (int v = 0; v < 32; v++) {
+        uint8_t e = (uint8_t)((v << 3) | (v >> 2));
+        l->r5[v] = spread(gamma[e], depth, 0);
+        l->b5[v] = spread(gamma[e], depth, 2);
+    }
+    for (int v = 0; v < 64; v++) {
+        uint8_t e = (uint8_t)((v << 2) | (v >> 4));
+        l->g6[v] = spread(gamma[e], depth, 1);
+    }
+}
+
+// Plane bytes are 0..7; any of them non-zero -> pixel drawn
+static inline uint32_t add_cover(uint32_t w, uint32_t cover_word)
+{
+    uint32_t any = (w | (w >> 8) | (w >> 16) | (w >> 24)) & 0x0F;
+    return w | (((any + 0x0F) >> 4) * cover_word);
+}
+
+// 4 pixel words (byte p = plane p) -> 4 plane words (byte i = pixel i)
+static inline void transpose4(uint32_t a, uint32_t b, uint32_t c, uint32_t d,
+                              uint32_t o[CANVAS_MAX_DEPTH])
+{
+    uint32_t t0 = (a & 0x00FF00FFu) | ((b & 0x00FF00FFu) << 8);
+    uint32_t t1 = ((a >> 8) & 0x00FF00FFu) | (b & 0xFF00FF00u);
+    uint32_t t2 = (c & 0x00FF00FFu) | ((d & 0x00FF00FFu) << 8);
+    uint32_t t3 = ((c >> 8) & 0x00FF00FFu) | (d & 0xFF00FF00u);
+
+    o[0] = (t0 & 0x0000FFFFu) | (t2 << 16);
+    o[1] = (t1 & 0x0000FFFFu) | (t3 << 16);
+    o[2] = (t0 >> 16) | (t2 & 0xFFFF0000u);
+    o[3] = (t1 >> 16) | (t3 & 0xFFFF0000u);
+}
+
+static inline void store4(uint8_t *const planes[], int depth, int i, const uint32_t o[CANVAS_MAX_DEPTH])
+{
+    for (int p = 0; p < depth; p++) {
+        ((uint32_t *)planes[p])[i >> 2] = o[p];
+    }
+}
+
+void canvas_convert_rgb888(const canvas_luts_t *l, const uint8_t *rgb, int n,
+                           uint8_t *const planes[], int depth, uint8_t cover)
+{
+    const uint32_t cover_word = cover * 0x01010101u;
+    uint32_t w[8], o[CANVAS_MAX_DEPTH];
+
+    for (int i = 0; i < n; i += 8) {
+        int count = (n - i) >= 8 ? 8 : 4;
+        for (int k = 0; k < count; k++, rgb += 3) {
+            w[k] = l->r8[rgb[0]] | l->g8[rgb[1]] | l->b8[rgb[2]];
+            if (cover) w[k] = add_cover(w[k], cover_word);
+        }
+        transpose4(w[0], w[1], w[2], w[3], o);
+        store4(planes, depth, i, o);
+        if (count == 8) {
+            transpose4(w[4], w[5], w[6], w[7], o);
+            store4(planes, depth, i + 4, o);
+        }
+    }
+}
+
+void canvas_convert_rgb565(const canvas_luts_t *l, const uint16_t *px, int n,
+                           uint8_t *const planes[], int depth, uint8_t cover)
+{
+    const uint32_t cover_word = cover * 0x01010101u;
+    uint32_t w[8], o[CANVAS_MAX_DEPTH];
+
+    for (int i = 0; i < n; i += 8) {
+        int count = (n - i) >= 8 ? 8 : 4;
+        for (int k = 0; k < count; k++) {
+            uint16_t c = *px++;
+            w[k] = l->r5[c >> 11] | l->g6[(c >> 5) & 0x3F] | l->b5[c & 0x1F];
+            if (cover) w[k] = add_cover(w[k], cover_word);
+        }
+        transpose4(w[0], w[1], w[2], w[3], o);
+        store4(planes, depth, i, o);
+        if (count == 8) {
+            transpose4(w[4], w[5], w[6], w[7], o);
+            store4(planes, depth, i + 4, o);
+        }
+    }
+}
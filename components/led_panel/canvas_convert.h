@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pure RGB canvas -> bit-plane converter, no IDF dependencies (builds on the host).
+//
+// Each channel value goes through a LUT straight to a "spread" word whose byte p
+// holds that channel's bit for plane p, already at its R/G/B position. OR-ing the
+// three gives one word per pixel with a byte per plane; a 4x4 byte transpose then
+// turns 4 such pixel words into one word per plane (4 pixels each), written
+// aligned. The loop converts 8 pixels per iteration.
+
+#define CANVAS_MAX_DEPTH   4      // planes that fit in one spread word
+
+typedef struct {
+    uint32_t r8[256], g8[256], b8[256];   // RGB888 channels
+    uint32_t r5[32], g6[64], b5[32];      // RGB565 channels
+} canvas_luts_t;
+
+/**
+ * @brief Build the spread tables from an 8-bit -> plane-level gamma table
+ */
+void canvas_build_luts(canvas_luts_t *l, const uint8_t gamma[256], int depth);
+
+/**
+ * @brief Convert n pixels (n % 4 == 0) into depth planes of n bytes each (4-byte aligned).
+ * cover != 0 is OR-ed into every plane byte of pixels that are not black.
+ */
+void canvas_convert_rgb888(const canvas_luts_t *l, const uint8_t *rgb, int n,
+                           uint8_t *const planes[], int depth, uint8_t cover);
+
+void canvas_convert_rgb565(const canvas_luts_t *l, const uint16_t *px, int n,
+                           uint8_t *const planes[], int depth, uint8_t cover);
+
+static inline uint16_t canvas_rgb565(int r8, int g8, int b8)
+{
+    return (uint16_t)(((r8 >> 3) << 11) | ((g8 >> 2) << 5) | (b8 >> 3));
+}
+
+#ifdef __cplusplus
+}
+#endif
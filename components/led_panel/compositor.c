@@ -0,0 +1,250 @@
+#include "compositor.h"
+#include "esp_timer.h"
+#include "dither.h"
+#include "trace.h"
+
+// PLANE_BYTES is a multiple of 4 (led_panel_set_geometry checks the panel width)
+#define PLANE_WORDS   (PLANE_BYTES / 4)
+
+#define WORD_COVER    0x08080808u
+#define WORD_RGB      0x07070707u
+
+// Layer storage (COLOR_DEPTH planes per layer) and the set_pixel target for each layer
+static uint8_t *layer_fb[COMPOSITOR_LAYERS];
+static uint8_t *layer_planes[COMPOSITOR_LAYERS][COLOR_DEPTH];
+
+// Composite of layers [0, base_count): what lies under the first changed layer
+static uint8_t *base_fb = NULL;
+static int base_count = 0;
+
+static bool layer_visible[COMPOSITOR_LAYERS];
+static uint8_t layer_shift[COMPOSITOR_LAYERS];   // plane shift = opacity
+static uint32_t dirty = 0;                       // bit per layer
+
+// Swap count right after our last present; anything else means the front
+// buffer no longer holds our composite
+static uint32_t presented_swap = 0;
+static bool presented = false;
+
+// Scene transition: the outgoing frame, blended over the composite at present
+static uint8_t *trans_fb = NULL;
+static uint8_t *trans_from[COLOR_DEPTH];
+static uint8_t *trans_rank = NULL;          // dissolve order
+static transition_rows_t trans_rows;         // virtual rows for slide/wipe on a segmented wall
+static const transition_rows_t *trans_rows_used = NULL;
+static bool trans_rows_built = false;
+static transition_kind_t trans_kind = TRANSITION_NONE;
+static fx_t trans_progress = 0;
+
+static compositor_stats_t stats;
+
+static void mark_dirty(layer_id_t layer)
+{
+    dirty |= 1u << layer;
+    if ((int)layer < base_count) base_count = 0;   // base has to be rebuilt
+}
+
+esp_err_t compositor_init(void)
+{
+    const size_t bytes = COLOR_DEPTH * PLANE_BYTES;
+
+    for (int l = 0; l < COMPOSITOR_LAYERS; l++) {
+        if (!layer_fb[l]) layer_fb[l] = led_panel_alloc(bytes, LED_MEM_BULK, "compositor layer");
+        if (!layer_fb[l]) return ESP_ERR_NO_MEM;
+        memset(layer_fb[l], 0, bytes);
+    }
+    if (!base_fb) base_fb = led_panel_alloc(bytes, LED_MEM_BULK, "compositor base");
+    if (!base_fb) return ESP_ERR_NO_MEM;
+    memset(base_fb, 0, bytes);
+
+    for (int l = 0; l < COMPOSITOR_LAYERS; l++) {
+        for (int p = 0; p < COLOR_DEPTH; p++) {
+            layer_planes[l][p] = layer_fb[l] + p * PLANE_BYTES;
+        }
+        layer_visible[l] = true;
+        layer_shift[l] = 0;
+    }
+    base_count = 0;
+    dirty = (1u << COMPOSITOR_LAYERS) - 1;
+    presented = false;
+    memset(&stats, 0, sizeof(stats));
+    return ESP_OK;
+}
+
+void compositor_begin(layer_id_t layer, bool clear)
+{
+    if (clear) memset(layer_fb[layer], 0, COLOR_DEPTH * PLANE_BYTES);
+    led_panel_set_target(layer_planes[layer], true);
+    mark_dirty(layer);
+}
+
+void compositor_end(void)
+{
+    led_panel_set_target(NULL, false);
+}
+
+void compositor_set_visible(layer_id_t layer, bool visible)
+{
+    if (layer_visible[layer] == visible) return;
+    layer_visible[layer] = visible;
+    mark_dirty(layer);
+}
+
+void compositor_set_opacity(layer_id_t layer, uint8_t opacity)
+{
+    uint8_t shift;
+    if (opacity == 255)     shift = 0;
+    else if (opacity >= 128) shift = 1;
+    else if (opacity >= 64)  shift = 2;
+    else if (opacity >= 32)  shift = 3;
+    else                     shift = 0xFF;   // hidden
+
+    if (layer_shift[layer] == shift) return;
+    layer_shift[layer] = shift;
+    mark_dirty(layer);
+}
+
+// 4 pixels at a time: where the layer has PIXEL_COVER take its RGB bits,
+// elsewhere keep what is below. src is the layer's plane p + shift (dimming).
+static inline uint32_t blend4(uint32_t below, uint32_t cover, uint32_t src)
+{
+    uint32_t m = ((cover & WORD_COVER) >> 3) * 0xFFu;
+    return (below & ~m) | (src & WORD_RGB & m);
+}
+
+static void merge_layer(int l, uint32_t *const dst[COLOR_DEPTH])
+{
+    if (!layer_visible[l] || layer_shift[l] == 0xFF) return;
+
+    for (int p = 0; p < COLOR_DEPTH; p++) {
+        const uint32_t *cov = (const uint32_t *)layer_planes[l][p];
+        int sp = p + layer_shift[l];
+        uint32_t *d = dst[p];
+
+        if (sp < COLOR_DEPTH) {
+            const uint32_t *src = (const uint32_t *)layer_planes[l][sp];
+            for (int i = 0; i < PLANE_WORDS; i++) d[i] = blend4(d[i], cov[i], src[i]);
+        } else {
+            // Dimmed below the last plane: covered pixels go black
+            for (int i = 0; i < PLANE_WORDS; i++) d[i] = blend4(d[i], cov[i], 0);
+        }
+    }
+}
+
+bool compositor_present(void)
+{
+    bool foreign = !presented || led_panel_swap_count() != presented_swap;
+    if (!dirty && !foreign && trans_kind == TRANSITION_NONE) {
+        stats.skipped++;
+        return false;
+    }
+
+    TRACE_BEGIN(TRACE_PRESENT);
+    int64_t t0 = esp_timer_get_time();
+
+    // Fold unchanged layers below the first changed one into the base, once
+    int first = dirty ? __builtin_ctz(dirty) : COMPOSITOR_LAYERS;
+    uint32_t *base[COLOR_DEPTH];
+    for (int p = 0; p < COLOR_DEPTH; p++) base[p] = (uint32_t *)(base_fb + p * PLANE_BYTES);
+
+    if (base_count == 0) memset(base_fb, 0, COLOR_DEPTH * PLANE_BYTES);
+    while (base_count < first) {
+        merge_layer(base_count, base);
+        base_count++;
+        stats.base_merges++;
+    }
+
+    // Back buffer = base + the layers above it
+    uint32_t *out[COLOR_DEPTH];
+    for (int p = 0; p < COLOR_DEPTH; p++) {
+        out[p] = (uint32_t *)back_planes[p];
+        memcpy(out[p], base[p], PLANE_BYTES);
+    }
+    for (int l = base_count; l < COMPOSITOR_LAYERS; l++) {
+        merge_layer(l, out);
+    }
+
+    if (trans_kind != TRANSITION_NONE) {
+        int64_t t1 = esp_timer_get_time();
+        const transition_geom_t g = {
+            .width = PHY_WIDTH, .height = PHY_HEIGHT, .depth = COLOR_DEPTH, .rank = trans_rank,
+            .rows = trans_rows_used,
+        };
+        transition_apply(&g, trans_kind, trans_progress, trans_from, back_planes);
+        if (trans_progress >= FX_ONE) trans_kind = TRANSITION_NONE;
+
+        uint32_t us = (uint32_t)(esp_timer_get_time() - t1);
+        stats.transition_last_us = us;
+        if (us > stats.transition_max_us) stats.transition_max_us = us;
+    }
+
+    swap_buffers();
+    presented_swap = led_panel_swap_count();
+    presented = true;
+    dirty = 0;
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    stats.presents++;
+    stats.last_us = us;
+    if (us > stats.max_us) stats.max_us = us;
+    TRACE_END(TRACE_PRESENT);
+    return true;
+}
+
+esp_err_t compositor_transition_start(transition_kind_t kind)
+{
+    const size_t bytes = COLOR_DEPTH * PLANE_BYTES;
+
+    if (!trans_fb) {
+        trans_fb = led_panel_alloc(bytes, LED_MEM_BULK, "transition frame");
+        if (!trans_fb) return ESP_ERR_NO_MEM;
+        for (int p = 0; p < COLOR_DEPTH; p++) trans_from[p] = trans_fb + p * PLANE_BYTES;
+    }
+    if (kind == TRANSITION_DISSOLVE && !trans_rank) {
+        trans_rank = led_panel_alloc(PLANE_BYTES, LED_MEM_BULK, "dissolve order");
+        if (!trans_rank) return ESP_ERR_NO_MEM;
+        transition_build_ranks(trans_rank, PLANE_BYTES, (uint32_t)esp_timer_get_time());
+    }
+    if ((kind == TRANSITION_SLIDE || kind == TRANSITION_WIPE) && !trans_rows_built) {
+        // Several panel rows or chains: a virtual row is N_HOR panel-wide pieces of the planes
+        const int segs = VIRT_HEIGHT * N_HOR;
+        uint8_t *buf = led_panel_alloc(segs * sizeof(uint32_t) + 2 * VIRT_WIDTH, LED_MEM_BULK, "transition rows");
+        if (!buf) return ESP_ERR_NO_MEM;
+        trans_rows = (transition_rows_t){
+            .width = VIRT_WIDTH, .height = VIRT_HEIGHT, .seg_width = PANEL_WIDTH,
+            .seg = (const uint32_t *)buf, .line = buf + segs * sizeof(uint32_t),
+        };
+        if (transition_build_rows(&trans_rows, PHY_WIDTH, led_panel_pixel_index)) trans_rows_used = &trans_rows;
+        trans_rows_built = true;
+    }
+
+    // What is on screen: the dithered frame if one is showing, else the front buffer
+    uint8_t **shown = dither_shown_planes();
+    if (!shown) shown = front_planes;
+    for (int p = 0; p < COLOR_DEPTH; p++) memcpy(trans_from[p], shown[p], PLANE_BYTES);
+
+    trans_kind = kind;
+    trans_progress = 0;
+    stats.transitions++;
+    return ESP_OK;
+}
+
+void compositor_transition_progress(fx_t progress)
+{
+    trans_progress = progress;
+}
+
+void compositor_transition_stop(void)
+{
+    trans_kind = TRANSITION_NONE;
+}
+
+bool compositor_transition_active(void)
+{
+    return trans_kind != TRANSITION_NONE;
+}
+
+void compositor_get_stats(compositor_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "led_panel.h"
+#include "transition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bottom to top. Each layer has its own planes in the same layout as front_planes/back_planes;
+// a pixel only covers the layers below it if it was drawn (PIXEL_COVER).
+typedef enum {
+    LAYER_BACKGROUND = 0,   // static art: logo, fixed glyphs
+    LAYER_CONTENT,          // time / date / temperature, redrawn every frame
+    LAYER_OVERLAY,          // menu and short messages
+    COMPOSITOR_LAYERS
+} layer_id_t;
+
+typedef struct {
+    uint32_t presents;       // frames composed and swapped
+    uint32_t skipped;        // compositor_present() calls with nothing to do
+    uint32_t base_merges;    // layers folded into the cached base
+    uint32_t last_us;        // compose time of the last frame
+    uint32_t max_us;
+    uint32_t transitions;    // scene transitions started
+    uint32_t transition_last_us;   // blend time of the last transition frame
+    uint32_t transition_max_us;
+} compositor_stats_t;
+
+/**
+ * @brief Allocate (first call) and clear every layer, all visible at full opacity.
+ * Call after init_planes().
+ */
+esp_err_t compositor_init(void);
+
+/**
+ * @brief Point set_pixel / draw_* at a layer (optionally cleared first) and mark it changed
+ */
+void compositor_begin(layer_id_t layer, bool clear);
+
+/**
+ * @brief Point set_pixel back at the panel back buffer
+ */
+void compositor_end(void);
+
+void compositor_set_visible(layer_id_t layer, bool visible);
+
+/**
+ * @brief Layer intensity in plane space: 255 full, >=128 half, >=64 quarter, >=32 1/8,
+ * 0 hidden. Drawn pixels stay opaque, they are just dimmed.
+ */
+void compositor_set_opacity(layer_id_t layer, uint8_t opacity);
+
+/**
+ * @brief Merge changed layers into the back buffer and swap. Caller holds led_panel_claim().
+ * @return false if nothing changed since the last present (no swap)
+ */
+bool compositor_present(void);
+
+/**
+ * @brief Snapshot what is on screen (dithered frame included) as the outgoing scene;
+ * the next presents blend it into the layers. Allocates the snapshot on first use.
+ */
+esp_err_t compositor_transition_start(transition_kind_t kind);
+
+/**
+ * @brief Transition position for the next present, 0 .. FX_ONE (FX_ONE ends it)
+ */
+void compositor_transition_progress(fx_t progress);
+
+void compositor_transition_stop(void);
+bool compositor_transition_active(void);
+
+void compositor_get_stats(compositor_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,112 @@
+#include "dither.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+
+static const char *TAG = "DITHER";
+
+static dither_tables_t tables;
+static uint8_t *canvas = NULL;   // RGB888, physical layout
+
+// Two sets so a present never rewrites the one being scanned
+static uint8_t *set_mem[2] = { NULL, NULL };
+static uint8_t *set_planes[2][DITHER_SUBFRAMES][COLOR_DEPTH];
+
+static volatile int front_set = -1;         // -1 = not showing
+static volatile uint32_t shown_swap = 0;    // swap count at present time
+static int back_set = 0;
+static int subframe = 0;                    // refresh side only
+
+static dither_stats_t stats;
+
+esp_err_t dither_init(void)
+{
+    if (canvas) return ESP_OK;
+
+    canvas = led_panel_alloc(PLANE_BYTES * 3, LED_MEM_BULK, "dither canvas");
+    set_mem[0] = led_panel_alloc(PLANE_BYTES * DITHER_OUT_BYTES, LED_MEM_BULK, "dither sub-frames");
+    set_mem[1] = led_panel_alloc(PLANE_BYTES * DITHER_OUT_BYTES, LED_MEM_BULK, "dither sub-frames");
+    if (!canvas || !set_mem[0] || !set_mem[1]) {
+        ESP_LOGE(TAG, "No memory for dither buffers");
+        heap_caps_free(canvas);
+        heap_caps_free(set_mem[0]);
+        heap_caps_free(set_mem[1]);
+        canvas = set_mem[0] = set_mem[1] = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int b = 0; b < 2; b++) {
+        for (int s = 0; s < DITHER_SUBFRAMES; s++) {
+            for (int p = 0; p < COLOR_DEPTH; p++) {
+                set_planes[b][s][p] = set_mem[b] + (s * COLOR_DEPTH + p) * PLANE_BYTES;
+            }
+        }
+    }
+
+    dither_build_tables(&tables, DITHER_GAMMA);
+    memset(&stats, 0, sizeof(stats));
+    return ESP_OK;
+}
+
+bool dither_begin(void)
+{
+    if (!canvas) return false;
+    memset(canvas, 0, PLANE_BYTES * 3);
+    led_panel_set_canvas(canvas, CANVAS_RGB888);
+    return true;
+}
+
+void dither_present(void)
+{
+    led_panel_set_canvas(NULL, CANVAS_RGB888);
+
+    int64_t t0 = esp_timer_get_time();
+
+    uint8_t *out[DITHER_OUT_BYTES];
+    for (int i = 0; i < DITHER_OUT_BYTES; i++) {
+        out[i] = set_mem[back_set] + i * PLANE_BYTES;
+    }
+    dither_quantize(&tables, canvas, PHY_WIDTH, PHY_HEIGHT, out);
+
+    shown_swap = led_panel_swap_count();
+    front_set = back_set;
+    back_set ^= 1;
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    stats.presents++;
+    stats.last_us = us;
+    if (us > stats.max_us) stats.max_us = us;
+}
+
+void dither_stop(void)
+{
+    front_set = -1;
+}
+
+bool dither_active(void)
+{
+    // Any swap_buffers() since our present means normal frames took over
+    return front_set >= 0 && shown_swap == led_panel_swap_count();
+}
+
+IRAM_ATTR uint8_t **dither_frame_planes(void)
+{
+    int set = front_set;
+    // Read only here: the drawing side owns front_set
+    if (set < 0 || shown_swap != led_panel_swap_count()) return NULL;
+
+    subframe = (subframe + 1) & (DITHER_SUBFRAMES - 1);
+    stats.subframes++;
+    return set_planes[set][subframe];
+}
+
+uint8_t **dither_shown_planes(void)
+{
+    return dither_active() ? set_planes[front_set][0] : NULL;
+}
+
+void dither_get_stats(dither_stats_t *out)
+{
+    *out = stats;
+}
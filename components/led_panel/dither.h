@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "led_panel.h"
+#include "dither_quant.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Temporal dithering output mode: scenes draw RGB888 into a canvas, the frame is
+// quantized once into DITHER_SUBFRAMES plane sets and refresh_task shows one set
+// per refresh pass. Scan cost stays at COLOR_DEPTH planes; the full cycle is
+// DITHER_SUBFRAMES passes, so keep the refresh rate well above 4x flicker fusion.
+
+#define DITHER_GAMMA   2.2f
+
+#if DITHER_DEPTH != COLOR_DEPTH
+#error "DITHER_DEPTH must match COLOR_DEPTH"
+#endif
+
+typedef struct {
+    uint32_t presents;
+    uint32_t last_us;        // quantize time of the last present
+    uint32_t max_us;
+    uint32_t subframes;      // refresh passes shown from dithered sets
+} dither_stats_t;
+
+/**
+ * @brief Allocate the canvas and two sub-frame sets (27 bytes per pixel, ~54 KB at
+ * 64x32) and build the tables. Call after init_planes().
+ */
+esp_err_t dither_init(void);
+
+/**
+ * @brief Clear the canvas and point set_pixel at it. Caller holds led_panel_claim().
+ * @return false if dither_init() did not succeed
+ */
+bool dither_begin(void);
+
+/**
+ * @brief Quantize the canvas and show it, until the next swap_buffers() or dither_stop()
+ */
+void dither_present(void);
+
+void dither_stop(void);
+bool dither_active(void);
+
+/**
+ * @brief Called by refresh_task once per pass: the planes to scan, or NULL for front_planes
+ */
+uint8_t **dither_frame_planes(void);
+
+/**
+ * @brief First sub-frame of what is on screen, or NULL if dithering is not active
+ */
+uint8_t **dither_shown_planes(void);
+
+void dither_get_stats(dither_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,77 @@
+#include "dither_quant.h"
+#include <string.h>
+#include <math.h>
+
+#if DITHER_FRAC_BITS > 4
+#error "phase comes from a 4x4 Bayer matrix, DITHER_FRAC_BITS must be <= 4"
+#endif
+
+#define FRAC_MASK   (DITHER_SUBFRAMES - 1)
+
+// Start value of each pixel's error accumulator. Neighbours start out of phase,
+// so a flat dim area never blinks all at once.
+static const uint8_t bayer4[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+void dither_build_tables(dither_tables_t *t, float gamma)
+{
+    const int top = DITHER_LEVELS - 1;
+
+    for (int v = 0; v < 256; v++) {
+        float lin = powf(v / 255.0f, gamma) * top;
+        t->level[v] = (uint8_t)(lin + 0.5f);
+    }
+
+    memset(t->pattern, 0, sizeof(t->pattern));
+    for (int level = 0; level < DITHER_LEVELS; level++) {
+        int base = level >> DITHER_FRAC_BITS;
+        int frac = level & FRAC_MASK;
+
+        for (int phase = 0; phase < DITHER_SUBFRAMES; phase++) {
+            uint8_t *bytes = (uint8_t *)t->pattern[level][phase];
+            int acc = phase;
+
+            // The remainder is carried from sub-frame to sub-frame; after a whole
+            // cycle acc is back at phase, so the next swap continues seamlessly
+            for (int s = 0; s < DITHER_SUBFRAMES; s++) {
+                acc += frac;
+                int q = base + (acc >> DITHER_FRAC_BITS);
+                acc &= FRAC_MASK;
+                for (int p = 0; p < DITHER_DEPTH; p++) {
+                    bytes[s * DITHER_DEPTH + p] = (q >> p) & 1;
+                }
+            }
+        }
+    }
+}
+
+void dither_quantize(const dither_tables_t *t, const uint8_t *rgb, int width, int height,
+                     uint8_t *const out[DITHER_OUT_BYTES])
+{
+    int idx = 0;
+    for (int y = 0; y < height; y++) {
+        const uint8_t *bayer_row = bayer4[y & 3];
+
+        for (int x = 0; x < width; x++, idx++, rgb += 3) {
+            int phase = bayer_row[x & 3] >> (4 - DITHER_FRAC_BITS);
+            const uint32_t *pr = t->pattern[t->level[rgb[0]]][phase];
+            const uint32_t *pg = t->pattern[t->level[rgb[1]]][phase];
+            const uint32_t *pb = t->pattern[t->level[rgb[2]]][phase];
+
+            // All sub-frames and planes of one pixel at once, 4 bytes per word
+            uint32_t w[DITHER_OUT_WORDS];
+            for (int k = 0; k < DITHER_OUT_WORDS; k++) {
+                w[k] = pr[k] | (pg[k] << 1) | (pb[k] << 2);
+            }
+
+            const uint8_t *bytes = (const uint8_t *)w;
+            for (int i = 0; i < DITHER_OUT_BYTES; i++) {
+                out[i][idx] = bytes[i];
+            }
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pure quantizer for temporal dithering, no IDF dependencies (builds on the host).
+//
+// Every 8-bit channel maps through gamma to a linear level with DITHER_FRAC_BITS
+// more resolution than the scanned planes. Each swap expands that into
+// DITHER_SUBFRAMES plane sets; over one cycle a pixel shows level >> FRAC
+// (SUBFRAMES - frac) times and one step brighter frac times, so the eye
+// averages to the full level.
+
+// ------------ CONFIG: dithering ------------
+#define DITHER_DEPTH       3                        // scanned planes (= COLOR_DEPTH)
+#define DITHER_FRAC_BITS   2                        // extra perceived bits
+#define DITHER_SUBFRAMES   (1 << DITHER_FRAC_BITS)
+#define DITHER_LEVELS      (((1 << DITHER_DEPTH) - 1) * DITHER_SUBFRAMES + 1)
+
+// Output bytes per pixel (one per sub-frame per plane), packed in 32-bit words
+#define DITHER_OUT_BYTES   (DITHER_SUBFRAMES * DITHER_DEPTH)
+#define DITHER_OUT_WORDS   ((DITHER_OUT_BYTES + 3) / 4)
+
+typedef struct {
+    uint8_t level[256];   // 8-bit channel -> linear level 0..DITHER_LEVELS-1
+    // Per level and start phase: byte (s * DEPTH + p) is the bit shown in
+    // sub-frame s, plane p (0 or 1)
+    uint32_t pattern[DITHER_LEVELS][DITHER_SUBFRAMES][DITHER_OUT_WORDS];
+} dither_tables_t;
+
+/**
+ * @brief Fill the gamma and sub-frame pattern tables
+ */
+void dither_build_tables(dither_tables_t *t, float gamma);
+
+/**
+ * @brief Quantize an RGB888 image (row-major, 3 bytes per pixel) into
+ * DITHER_SUBFRAMES * DITHER_DEPTH planes of width*height bytes each.
+ * out[s * DITHER_DEPTH + p] gets bit0=R, bit1=G, bit2=B like the scan planes.
+ */
+void dither_quantize(const dither_tables_t *t, const uint8_t *rgb, int width, int height,
+                     uint8_t *const out[DITHER_OUT_BYTES]);
+
+#ifdef __cplusplus
+}
+#endif
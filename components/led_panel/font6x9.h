@@ -1095,16 +1095,16 @@ static const uint8_t font6x9[95][9][6] = {
     {0,0,0,0,1,1}
   }, // '{'
   {
-    {0,1,1,0,1,0},
-    {1,0,0,1,0,1},
-    {1,1,0,0,0,1},
-    {1,0,1,0,0,1},
-    {1,0,0,1,0,1},
-    {1,0,0,0,1,1},
-    {1,0,0,0,0,1},
-    {1,0,0,0,0,1},
-	{1,0,0,0,0,1}
-  }, // '|'  //Ñ
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0}
+  }, // '|'  (Ñ is U+00D1 in font6x9_ext.h)
   {
     {1,1,0,0,0,0},
     {0,0,1,1,0,0},
@@ -0,0 +1,183 @@
+#pragma once
+#include <stdint.h>
+
+// font6x9 glyphs outside ASCII, indexed from GLYPH_EXT_FIRST in this order
+// (see glyph_map.c). Accented capitals give up one row to fit the mark.
+static const uint8_t font6x9_ext[16][FONT_HEIGHT][FONT_WIDTH] = {
+  {
+    {0,0,0,1,1,0},
+    {0,1,1,1,1,0},
+    {1,0,0,0,0,1},
+    {1,1,1,1,1,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1}
+  }, // 'Á' U+00C1
+  {
+    {0,0,0,1,1,0},
+    {1,1,1,1,1,1},
+    {1,0,0,0,0,0},
+    {1,1,1,1,1,0},
+    {1,0,0,0,0,0},
+    {1,0,0,0,0,0},
+    {1,0,0,0,0,0},
+    {1,0,0,0,0,0},
+    {1,1,1,1,1,1}
+  }, // 'É' U+00C9
+  {
+    {0,0,0,1,1,0},
+    {0,1,1,1,1,1},
+    {0,0,0,1,0,0},
+    {0,0,0,1,0,0},
+    {0,0,0,1,0,0},
+    {0,0,0,1,0,0},
+    {0,0,0,1,0,0},
+    {0,0,0,1,0,0},
+    {0,1,1,1,1,1}
+  }, // 'Í' U+00CD
+  {
+    {0,0,0,1,1,0},
+    {0,1,1,1,1,0},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {0,1,1,1,1,0}
+  }, // 'Ó' U+00D3
+  {
+    {0,0,0,1,1,0},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {0,1,1,1,1,0}
+  }, // 'Ú' U+00DA
+  {
+    {0,1,1,0,1,0},
+    {1,0,0,1,0,1},
+    {1,1,0,0,0,1},
+    {1,0,1,0,0,1},
+    {1,0,0,1,0,1},
+    {1,0,0,0,1,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1}
+  }, // 'Ñ' U+00D1
+  {
+    {0,1,0,0,1,0},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {0,1,1,1,1,0}
+  }, // 'Ü' U+00DC
+  {
+    {0,0,0,1,1,0},
+    {0,1,1,1,1,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {0,1,1,1,1,1},
+    {0,1,1,1,1,1}
+  }, // 'á' U+00E1
+  {
+    {0,0,0,1,1,0},
+    {0,1,1,1,1,0},
+    {1,0,0,1,1,1},
+    {1,0,0,1,1,1},
+    {1,1,1,0,0,0},
+    {1,1,1,0,0,0},
+    {1,1,1,0,0,0},
+    {0,1,1,1,1,1},
+    {0,1,1,1,1,1}
+  }, // 'é' U+00E9
+  {
+    {0,0,0,1,1,0},
+    {0,0,0,0,0,0},
+    {0,0,0,0,0,0},
+    {1,1,1,1,0,0},
+    {1,1,1,1,0,0},
+    {0,0,1,1,0,0},
+    {0,0,1,1,0,0},
+    {1,1,1,1,1,1},
+    {1,1,1,1,1,1}
+  }, // 'í' U+00ED
+  {
+    {0,0,0,1,1,0},
+    {0,1,1,1,1,0},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {0,1,1,1,1,0},
+    {0,1,1,1,1,0}
+  }, // 'ó' U+00F3
+  {
+    {0,0,0,1,1,0},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {0,1,1,1,1,1},
+    {0,1,1,1,1,1}
+  }, // 'ú' U+00FA
+  {
+    {0,1,1,0,1,0},
+    {1,1,1,1,1,0},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1}
+  }, // 'ñ' U+00F1
+  {
+    {0,1,0,0,1,0},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {1,0,0,0,0,1},
+    {0,1,1,1,1,1},
+    {0,1,1,1,1,1}
+  }, // 'ü' U+00FC
+  {
+    {0,0,0,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,0,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0},
+    {0,0,1,0,0,0}
+  }, // '¡' U+00A1
+  {
+    {0,0,0,0,0,0},
+    {0,0,0,1,0,0},
+    {0,0,0,0,0,0},
+    {0,0,0,1,0,0},
+    {0,0,0,1,0,0},
+    {0,0,1,0,0,0},
+    {0,1,0,0,0,0},
+    {0,1,0,0,0,1},
+    {0,0,1,1,1,0}
+  }, // '¿' U+00BF
+};
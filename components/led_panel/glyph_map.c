@@ -0,0 +1,73 @@
+#include "glyph_map.h"
+
+// Level 2: one 64-entry block per range of code points that has glyphs.
+// ASCII maps to c - 32 as before; U+00B0 reuses font6x9's '*', which is drawn
+// as a degree ring.
+#define F GLYPH_FALLBACK
+
+static const uint8_t block_none[64] = {
+    F, F, F, F, F, F, F, F,
+    F, F, F, F, F, F, F, F,
+    F, F, F, F, F, F, F, F,
+    F, F, F, F, F, F, F, F,
+    F, F, F, F, F, F, F, F,
+    F, F, F, F, F, F, F, F,
+    F, F, F, F, F, F, F, F,
+    F, F, F, F, F, F, F, F,
+};
+
+static const uint8_t block_0000[64] = {
+      F,   F,   F,   F,   F,   F,   F,   F,   // U+0000  . . . . . . . .
+      F,   F,   F,   F,   F,   F,   F,   F,   // U+0008  . . . . . . . .
+      F,   F,   F,   F,   F,   F,   F,   F,   // U+0010  . . . . . . . .
+      F,   F,   F,   F,   F,   F,   F,   F,   // U+0018  . . . . . . . .
+      0,   1,   2,   3,   4,   5,   6,   7,   // U+0020    ! " # $ % & '
+      8,   9,  10,  11,  12,  13,  14,  15,   // U+0028  ( ) * + , - . /
+     16,  17,  18,  19,  20,  21,  22,  23,   // U+0030  0 1 2 3 4 5 6 7
+     24,  25,  26,  27,  28,  29,  30,   F,   // U+0038  8 9 : ; < = > ?
+};
+
+static const uint8_t block_0040[64] = {
+     32,  33,  34,  35,  36,  37,  38,  39,   // U+0040  @ A B C D E F G
+     40,  41,  42,  43,  44,  45,  46,  47,   // U+0048  H I J K L M N O
+     48,  49,  50,  51,  52,  53,  54,  55,   // U+0050  P Q R S T U V W
+     56,  57,  58,  59,  60,  61,  62,  63,   // U+0058  X Y Z [ \ ] ^ _
+     64,  65,  66,  67,  68,  69,  70,  71,   // U+0060  ` a b c d e f g
+     72,  73,  74,  75,  76,  77,  78,  79,   // U+0068  h i j k l m n o
+     80,  81,  82,  83,  84,  85,  86,  87,   // U+0070  p q r s t u v w
+     88,  89,  90,  91,  92,  93,  94,   F,   // U+0078  x y z { | } ~ .
+};
+
+static const uint8_t block_0080[64] = {
+      F,   F,   F,   F,   F,   F,   F,   F,   // U+0080  . . . . . . . .
+      F,   F,   F,   F,   F,   F,   F,   F,   // U+0088  . . . . . . . .
+      F,   F,   F,   F,   F,   F,   F,   F,   // U+0090  . . . . . . . .
+      F,   F,   F,   F,   F,   F,   F,   F,   // U+0098  . . . . . . . .
+      F, 109,   F,   F,   F,   F,   F,   F,   // U+00A0  . ¡ . . . . . .
+      F,   F,   F,   F,   F,   F,   F,   F,   // U+00A8  . . . . . . . .
+     10,   F,   F,   F,   F,   F,   F,   F,   // U+00B0  ° . . . . . . .
+      F,   F,   F,   F,   F,   F,   F, 110,   // U+00B8  . . . . . . . ¿
+};
+
+static const uint8_t block_00c0[64] = {
+      F,  95,   F,   F,   F,   F,   F,   F,   // U+00C0  . Á . . . . . .
+      F,  96,   F,   F,   F,  97,   F,   F,   // U+00C8  . É . . . Í . .
+      F, 100,   F,  98,   F,   F,   F,   F,   // U+00D0  . Ñ . Ó . . . .
+      F,   F,  99,   F, 101,   F,   F,   F,   // U+00D8  . . Ú . Ü . . .
+      F, 102,   F,   F,   F,   F,   F,   F,   // U+00E0  . á . . . . . .
+      F, 103,   F,   F,   F, 104,   F,   F,   // U+00E8  . é . . . í . .
+      F, 107,   F, 105,   F,   F,   F,   F,   // U+00F0  . ñ . ó . . . .
+      F,   F, 106,   F, 108,   F,   F,   F,   // U+00F8  . . ú . ü . . .
+};
+
+// Level 1: block per (code point >> 6) below GLYPH_MAP_LIMIT
+const uint8_t *const glyph_map_blocks[GLYPH_MAP_LIMIT >> 6] = {
+    block_0000, block_0040, block_0080, block_00c0,
+    block_none, block_none, block_none, block_none,
+    block_none, block_none, block_none, block_none,
+    block_none, block_none, block_none, block_none,
+    block_none, block_none, block_none, block_none,
+    block_none, block_none, block_none, block_none,
+    block_none, block_none, block_none, block_none,
+    block_none, block_none, block_none, block_none,
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Code point -> glyph index for the draw_text font, no IDF dependencies (builds
+// on the host). Glyphs 0..94 are ASCII 32..126 (font6x9), GLYPH_EXT_FIRST.. are
+// the extra glyphs of font6x9_ext.h. Two-level table: a block pointer per 64 code
+// points, then a byte per code point; blocks without glyphs share one table, so
+// a lookup is two loads whatever the code point.
+
+#define GLYPH_ASCII_COUNT   95
+#define GLYPH_EXT_FIRST     GLYPH_ASCII_COUNT
+#define GLYPH_EXT_COUNT     16                 // Á É Í Ó Ú Ñ Ü á é í ó ú ñ ü ¡ ¿
+#define GLYPH_FALLBACK      ('?' - 32)
+#define GLYPH_MAP_LIMIT     0x800              // code points covered (1- and 2-byte UTF-8)
+
+extern const uint8_t *const glyph_map_blocks[GLYPH_MAP_LIMIT >> 6];
+
+static inline uint8_t glyph_lookup(uint32_t cp)
+{
+    if (cp >= GLYPH_MAP_LIMIT) return GLYPH_FALLBACK;
+    return glyph_map_blocks[cp >> 6][cp & 63];
+}
+
+/**
+ * @brief Decode one UTF-8 sequence at *s and advance past it. Malformed or
+ * overlong input gives U+FFFD and skips one byte; call only while **s != 0.
+ */
+static inline uint32_t utf8_next(const char **s)
+{
+    const uint8_t *p = (const uint8_t *)*s;
+    uint32_t c = p[0];
+
+    if (c < 0x80) {
+        *s += 1;
+        return c;
+    }
+    if ((c & 0xE0) == 0xC0 && (p[1] & 0xC0) == 0x80) {
+        uint32_t cp = ((c & 0x1F) << 6) | (p[1] & 0x3F);
+        if (cp >= 0x80) {                      // no overlong forms
+            *s += 2;
+            return cp;
+        }
+    } else if ((c & 0xF0) == 0xE0 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80) {
+        uint32_t cp = ((c & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+        if (cp >= 0x800) {
+            *s += 3;
+            return cp;
+        }
+    } else if ((c & 0xF8) == 0xF0 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80 &&
+               (p[3] & 0xC0) == 0x80) {
+        uint32_t cp = ((c & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        if (cp >= 0x10000 && cp <= 0x10FFFF) {
+            *s += 4;
+            return cp;
+        }
+    }
+    *s += 1;
+    return 0xFFFD;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,18 @@
+#include "hub75_bits.h"
+
+void hub75_lut_build(hub75_lut_t *lut, const uint8_t pins[HUB75_DATA_PINS])
+{
+    lut->mask = 0;
+    for (int i = 0; i < HUB75_DATA_PINS; i++) {
+        lut->mask |= 1u << pins[i];
+    }
+
+    // Index bit i (R1 G1 B1 R2 G2 B2) drives pins[i]
+    for (int v = 0; v < 64; v++) {
+        uint32_t set = 0;
+        for (int i = 0; i < HUB75_DATA_PINS; i++) {
+            if ((v >> i) & 1) set |= 1u << pins[i];
+        }
+        lut->set[v] = set;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// GPIO word builder for the HUB75 data lines, no IDF dependencies (builds on the host).
+//
+// One chain has six data pins: R1 G1 B1 (upper half) and R2 G2 B2 (lower half).
+// For each chain a 64-entry table maps (upper plane byte | lower plane byte << 3)
+// straight to the bits to set; the bits to clear are the chain's data mask minus
+// those. With several chains the set words just OR together, so one
+// out_w1ts/out_w1tc pair per clock drives every chain.
+
+#define HUB75_DATA_PINS   6      // R1 G1 B1 R2 G2 B2
+
+typedef struct {
+    uint32_t set[64];
+    uint32_t mask;               // all six data bits of the chain
+} hub75_lut_t;
+
+/**
+ * @brief Build a chain's table. pins[] in R1 G1 B1 R2 G2 B2 order, all < 32.
+ */
+void hub75_lut_build(hub75_lut_t *lut, const uint8_t pins[HUB75_DATA_PINS]);
+
+static inline uint32_t hub75_lut_index(uint8_t upper, uint8_t lower)
+{
+    return (upper & 0x07) | ((lower & 0x07) << 3);
+}
+
+/**
+ * @brief Gather one address row in shift order: per column, per chain, its LUT index.
+ * row_base = the row in the plane, col_off[c] = offset of column c's upper pixel from
+ * it, chain k's pixels chain_off * k further, the lower half lower_off below.
+ * Inline so refresh_task's copy stays in IRAM and the chain loop unrolls.
+ */
+static inline void hub75_stage_row(uint8_t *st, const uint8_t *row_base, const uint32_t *col_off, int cols,
+                                   int chains, uint32_t chain_off, uint32_t lower_off)
+{
+    for (int col = 0; col < cols; col++) {
+        const uint8_t *px = row_base + col_off[col];
+        for (int k = 0; k < chains; k++) {
+            const uint8_t *c = px + k * chain_off;
+            *st++ = hub75_lut_index(c[0], c[lower_off]);
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
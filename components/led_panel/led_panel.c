@@ -1,19 +1,41 @@
 #include "led_panel.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
+#include "driver/gptimer.h"
 //#include "font20x40.h"
 #include "font12x16.h"
 #include "font2x9.h"
 #include "font5x5.h"
 #include "font3x5.h"
 #include "font10x15.h"
+#include "font6x9_ext.h"
+#include "glyph_map.h"
 #include "soc/gpio_struct.h"  // for GPIO register access
-#include "nvs_flash.h"
-#include "nvs.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_attr.h"
+#include "sdkconfig.h"
+#include <stdlib.h>
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dither.h"
+#include "canvas_convert.h"
+#include "scan_pattern.h"
+#include "hub75_bits.h"
+#include "row_plan.h"
+#include "refresh_model.h"
+#include "trace.h"
+
+// The refresh path keeps running while flash is written (see led_panel_flash_begin),
+// so everything it calls must be in IRAM. tools/check_iram.py checks the link map.
+#if !CONFIG_LEDC_CTRL_FUNC_IN_IRAM || !CONFIG_GPTIMER_ISR_CACHE_SAFE
+#error "Needs CONFIG_LEDC_CTRL_FUNC_IN_IRAM and CONFIG_GPTIMER_ISR_CACHE_SAFE (flash-write refresh)"
+#endif
 
 
 // Gamma corrected values for 3-bit PWM (0..7)
-const uint8_t gamma_table[256] = {
+DRAM_ATTR const uint8_t gamma_table[256] = {
     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
@@ -35,106 +57,10 @@ const uint8_t gamma_table[256] = {
 
 
 
-//--------------------------------------------NVS-------------------------------------------------------
-
-void init_nvs_brightness()
-{
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
-}
-
-void save_brightness(uint8_t level)
-{
-    nvs_handle_t nvs_handle;
-    ESP_ERROR_CHECK(nvs_open("settings", NVS_READWRITE, &nvs_handle));
-    ESP_ERROR_CHECK(nvs_set_u8(nvs_handle, "brightness", level));
-    ESP_ERROR_CHECK(nvs_commit(nvs_handle));
-    nvs_close(nvs_handle);
-}
-
-uint8_t load_brightness()
-{
-    nvs_handle_t nvs_handle;
-    uint8_t level = 10; // default 10 if not set
-
-    if (nvs_open("settings", NVS_READONLY, &nvs_handle) == ESP_OK) {
-        nvs_get_u8(nvs_handle, "brightness", &level);
-        nvs_close(nvs_handle);
-    }
-
-    return level;
-}
-
-
-void save_mode(uint8_t value)
-{
-    nvs_handle_t nvs_handle;
-    ESP_ERROR_CHECK(nvs_open("settings", NVS_READWRITE, &nvs_handle));
-    ESP_ERROR_CHECK(nvs_set_u8(nvs_handle, "mode", value));
-    ESP_ERROR_CHECK(nvs_commit(nvs_handle));
-    nvs_close(nvs_handle);
-}
-
-uint8_t load_mode()
-{
-    nvs_handle_t nvs_handle;
-    uint8_t value = 4; // default 0 if not set
-
-    if (nvs_open("settings", NVS_READONLY, &nvs_handle) == ESP_OK) {
-        nvs_get_u8(nvs_handle, "mode", &value);
-        nvs_close(nvs_handle);
-    }
-
-    return value;
-}
-
-
-
-
-
-
-
-
-
-
-
-void save_format(uint8_t format)
-{
-    nvs_handle_t nvs_handle;
-    ESP_ERROR_CHECK(nvs_open("settings", NVS_READWRITE, &nvs_handle));
-    ESP_ERROR_CHECK(nvs_set_u8(nvs_handle, "format", format));
-    ESP_ERROR_CHECK(nvs_commit(nvs_handle));
-    nvs_close(nvs_handle);
-}
-
-uint8_t load_format()
-{
-    nvs_handle_t nvs_handle;
-    uint8_t format = 0; // default 0 if not set
-
-    if (nvs_open("settings", NVS_READONLY, &nvs_handle) == ESP_OK) {
-        nvs_get_u8(nvs_handle, "format", &format);
-        nvs_close(nvs_handle);
-    }
-
-    return format;
-}
-
-
-
-
-
-
-
-
-
-
 //--------------------------------------------------------------------------------------------------------------
 static volatile uint8_t global_brightness = 100;  // 0..100%
+static volatile uint16_t duty_scale = 256;        // Q8, set by refresh_task for the pass length
+static volatile uint16_t refresh_target_hz = REFRESH_TARGET_HZ;
 
 // Initialize OE PWM
 void init_oe_pwm(void)
@@ -164,13 +90,23 @@ void init_oe_pwm(void)
 }
 
 // Update OE duty according to global brightness (0-100%)
-static void update_oe_duty(void)
+static IRAM_ATTR void update_oe_duty(void)
 {
     uint32_t duty = (global_brightness * OE_MAX_DUTY) / 100; // scale 0..100 -> 0..63
+    // Shorter passes (scan fast paths) show each row more often: less duty per row
+    uint32_t scaled = (duty * duty_scale + 128) >> 8;
+    duty = (duty && !scaled) ? 1 : scaled;
     ESP_ERROR_CHECK(ledc_set_duty(OE_SPEED_MODE, OE_CHANNEL, duty));
     ESP_ERROR_CHECK(ledc_update_duty(OE_SPEED_MODE, OE_CHANNEL));
 }
 
+// Duty = 0 -> OE stays HIGH -> panel off
+static IRAM_ATTR void oe_off(void)
+{
+    ledc_set_duty(OE_SPEED_MODE, OE_CHANNEL, 0);
+    ledc_update_duty(OE_SPEED_MODE, OE_CHANNEL);
+}
+
 // Set brightness as percentage (0-100)
 void set_global_brightness(uint8_t percent)
 {
@@ -180,14 +116,311 @@ void set_global_brightness(uint8_t percent)
 }
 //--------------------------------------------------------------------------------------------------------------
 
-void init_planes(void) {
+static const char *TAG = "LED_PANEL";
+
+led_geometry_t led_geom;
+static bool geom_valid = false;
+static bool geom_locked = false;   // tables or buffers are sized from led_geom
+static scan_pattern_t scan;
+
+uint8_t *front_planes[COLOR_DEPTH];
+uint8_t *back_planes [COLOR_DEPTH];
+
+// Storage behind the plane pointers (A/B), COLOR_DEPTH planes each.
+// Heap blocks are word aligned: the compositor merges 4 pixels per 32-bit access
+static uint8_t *fbA = NULL;
+static uint8_t *fbB = NULL;
+
+// Virtual -> physical offset lookups, built by init_planes()
+static uint16_t *x_panel, *x_local;    // per virtual x: panel column, column in panel
+static uint16_t *y_panel;              // per virtual y: panel row * N_HOR
+static uint32_t *y_off;                // per virtual y: row in panel * stride
+static uint32_t *panel_base;           // per linear panel: offset of its top-left pixel
+
+// Where set_pixel writes; back_planes is updated in place by swap_buffers so the
+// default target follows the swap
+static uint8_t **draw_planes = back_planes;
+static uint8_t draw_cover = 0;
+static void *draw_rgb = NULL;      // RGB canvas target, wins over draw_planes
+static canvas_format_t draw_rgb_fmt = CANVAS_RGB888;
+
+static volatile uint32_t swap_count = 0;
+
+static led_refresh_stats_t rstats;
+static volatile bool row_over_reset = false;
+
+// Whoever draws into the back buffer and swaps holds this (drawing_task, uart_stream)
+static SemaphoreHandle_t back_owner = NULL;
+
+// ------------ Geometry -------------
+esp_err_t led_panel_set_geometry(const panel_geometry_t *g)
+{
+    if (geom_locked) return ESP_ERR_INVALID_STATE;
+
+    scan_pattern_t pat;
+    int panels = g->n_hor * g->n_ver;
+    if (g->panel_width == 0 || (g->panel_width % 4) != 0 || panels == 0 || (panels % N_CHAINS) != 0 ||
+        scan_pattern_folded(&pat, g->scan, g->panel_height) != 0 ||
+        scan_validate(&pat, g->panel_width, g->panel_height) != 0) {
+        ESP_LOGE(TAG, "Geometry %ux%u 1/%u, %ux%u panels, %d chains not usable",
+                 g->panel_width, g->panel_height, g->scan, g->n_hor, g->n_ver, N_CHAINS);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    led_geom.g                = *g;
+    led_geom.virt_width       = g->panel_width  * g->n_hor;
+    led_geom.virt_height      = g->panel_height * g->n_ver;
+    led_geom.phys_panels      = panels;
+    led_geom.panels_per_chain = panels / N_CHAINS;
+    led_geom.phy_width        = g->panel_width  * led_geom.panels_per_chain;
+    led_geom.phy_height       = g->panel_height * N_CHAINS;
+    led_geom.plane_bytes      = led_geom.phy_width * led_geom.phy_height;
+    led_geom.addr_bits        = pat.addr_bits;
+    led_geom.scan_cols        = led_geom.phy_width * pat.chunks;
+    scan = pat;
+    geom_valid = true;
+
+    ESP_LOGI(TAG, "Geometry %dx%d (%d panels %ux%u, scan %s, %d chain(s))",
+             led_geom.virt_width, led_geom.virt_height, panels, g->panel_width, g->panel_height,
+             pat.name, N_CHAINS);
+    return ESP_OK;
+}
+
+static void ensure_geometry(void)
+{
+    if (!geom_valid) {
+        // Nothing set, or the stored geometry was rejected: the defaults, before locking
+        const panel_geometry_t def = {
+            .panel_width  = DEFAULT_PANEL_WIDTH,
+            .panel_height = DEFAULT_PANEL_HEIGHT,
+            .scan         = DEFAULT_PANEL_SCAN,
+            .n_hor        = DEFAULT_N_HOR,
+            .n_ver        = DEFAULT_N_VER,
+        };
+        ESP_ERROR_CHECK(led_panel_set_geometry(&def));
+    }
+    geom_locked = true;
+}
+
+void *led_panel_alloc(size_t bytes, led_mem_t where, const char *what)
+{
+    const uint32_t internal = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    const uint32_t psram    = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+    bool bulk_psram = where == LED_MEM_BULK &&
+                      (size_t)COLOR_DEPTH * PLANE_BYTES >= PSRAM_BULK_FRAME_BYTES;
+
+    uint32_t first = bulk_psram ? psram : internal;
+    void *p = heap_caps_calloc(1, bytes, first);
+    bool in_psram = bulk_psram;
+    if (!p) {
+        p = heap_caps_calloc(1, bytes, bulk_psram ? internal : psram);
+        in_psram = !bulk_psram;
+        if (p) {
+            ESP_LOGW(TAG, "%s (%u bytes) placed in %s", what, (unsigned)bytes,
+                     in_psram ? "PSRAM" : "internal RAM");
+        }
+    }
+    if (!p) {
+        ESP_LOGE(TAG, "No memory for %s (%u bytes)", what, (unsigned)bytes);
+        return NULL;
+    }
+
+    if (in_psram) rstats.psram_bytes += bytes;
+    else          rstats.internal_bytes += bytes;
+    return p;
+}
+
+static esp_err_t build_pixel_map(void)
+{
+    x_panel    = malloc(VIRT_WIDTH  * sizeof(uint16_t));
+    x_local    = malloc(VIRT_WIDTH  * sizeof(uint16_t));
+    y_panel    = malloc(VIRT_HEIGHT * sizeof(uint16_t));
+    y_off      = malloc(VIRT_HEIGHT * sizeof(uint32_t));
+    panel_base = malloc(PHYS_PANELS * sizeof(uint32_t));
+    if (!x_panel || !x_local || !y_panel || !y_off || !panel_base) return ESP_ERR_NO_MEM;
+
+    for (int x = 0; x < VIRT_WIDTH; x++) {
+        x_panel[x] = x / PANEL_WIDTH;
+        x_local[x] = x % PANEL_WIDTH;
+    }
+    for (int y = 0; y < VIRT_HEIGHT; y++) {
+        y_panel[y] = (y / PANEL_HEIGHT) * N_HOR;
+        y_off[y]   = (y % PANEL_HEIGHT) * PHY_WIDTH;
+    }
+    for (int i = 0; i < PHYS_PANELS; i++) {
+        int chain = i / PANELS_PER_CHAIN;
+        panel_base[i] = (chain * PANEL_HEIGHT) * PHY_WIDTH + (i % PANELS_PER_CHAIN) * PANEL_WIDTH;
+    }
+    return ESP_OK;
+}
+
+esp_err_t init_planes(void) {
+    ensure_geometry();
+
+    if (!fbA) {
+        fbA = led_panel_alloc(COLOR_DEPTH * PLANE_BYTES, LED_MEM_BULK, "frame buffer A");
+        fbB = led_panel_alloc(COLOR_DEPTH * PLANE_BYTES, LED_MEM_BULK, "frame buffer B");
+        if (!fbA || !fbB) return ESP_ERR_NO_MEM;
+
+        esp_err_t err = build_pixel_map();
+        if (err != ESP_OK) return err;
+    }
+
     for (int p = 0; p < COLOR_DEPTH; ++p) {
-        front_planes[p] = fbA[p];
-        back_planes [p] = fbB[p];
+        front_planes[p] = fbA + p * PLANE_BYTES;
+        back_planes [p] = fbB + p * PLANE_BYTES;
     }
+
+    if (!back_owner) back_owner = xSemaphoreCreateMutex();
+    return back_owner ? ESP_OK : ESP_ERR_NO_MEM;
 }
 
+bool led_panel_claim(TickType_t wait) {
+    return xSemaphoreTake(back_owner, wait) == pdTRUE;
+}
 
+void led_panel_release(void) {
+    xSemaphoreGive(back_owner);
+}
+
+void led_panel_set_target(uint8_t **planes, bool cover) {
+    draw_planes = planes ? planes : back_planes;
+    draw_cover  = (planes && cover) ? PIXEL_COVER : 0;
+}
+
+uint8_t **led_panel_target(uint8_t *cover) {
+    if (cover) *cover = draw_cover;
+    return draw_planes;
+}
+
+void led_panel_set_canvas(void *buf, canvas_format_t fmt) {
+    draw_rgb_fmt = fmt;
+    draw_rgb = buf;
+}
+
+IRAM_ATTR uint32_t led_panel_swap_count(void) {
+    return swap_count;
+}
+
+
+
+// ------------ Scan pattern tables -------------
+// Per shifted column: offset of its upper-half pixel from the start of the
+// address row (row offset of its run * stride + framebuffer x)
+static uint32_t *scan_off = NULL;
+
+// The row being shifted, staged from the planes by stage_row(): per column, per
+// chain, its hub75_lut_index. Internal RAM, so the shift loop never waits on PSRAM.
+static uint8_t *row_stage = NULL;
+static uint32_t addr_set[1 << SCAN_MAX_ADDR_BITS], addr_clr[1 << SCAN_MAX_ADDR_BITS];
+
+// What a pass shows, in order: each entry shifts one address row of one plane
+// and lights it for `units` BASE_US slices
+typedef struct {
+    uint16_t row;
+    uint8_t plane;
+    uint8_t units;
+} scan_slot_t;
+
+typedef struct {
+    scan_slot_t *slot;       // COLOR_DEPTH * PANEL_SCAN entries allocated
+    int n;
+    uint32_t units;          // sum over the slots
+    uint16_t skipped;        // plane rows left out: black
+    uint16_t merged;         // plane rows folded into another plane's shift
+    uint32_t swap;           // swap_count of the frame it was planned from
+} scan_list_t;
+
+// The full list (every row of every plane) works for any frame and is what
+// dither sub-frames and a frame not planned yet are shown with. Fast lists are
+// planned from the front buffer by refresh_task, one address row at a time
+// while rows are lit: one is shown while the other is planned.
+static scan_list_t full_list;
+static scan_list_t fast_lists[2];
+static scan_list_t *fast_ready = NULL;       // last plan completed
+static uint8_t *plan_stage = NULL;           // COLOR_DEPTH staged rows of one address
+static uint8_t *plan_units = NULL;           // per plane * PANEL_SCAN + row, units of the plan
+static uint8_t *plan_src[COLOR_DEPTH];
+static uint32_t plan_swap;
+static int plan_row = -1;                    // next row to plan, -1 = no plan running
+static uint32_t plan_cost_us = 0;            // last plan step
+
+// Data pins per chain, R1 G1 B1 R2 G2 B2
+static const uint8_t chain_pins[N_CHAINS][HUB75_DATA_PINS] = {
+    { PIN_R1, PIN_G1, PIN_B1, PIN_R2, PIN_G2, PIN_B2 },
+#if N_CHAINS >= 2
+    { CHAIN1_R1, CHAIN1_G1, CHAIN1_B1, CHAIN1_R2, CHAIN1_G2, CHAIN1_B2 },
+#endif
+#if N_CHAINS >= 3
+    { CHAIN2_R1, CHAIN2_G1, CHAIN2_B1, CHAIN2_R2, CHAIN2_G2, CHAIN2_B2 },
+#endif
+#if N_CHAINS >= 4
+    { CHAIN3_R1, CHAIN3_G1, CHAIN3_B1, CHAIN3_R2, CHAIN3_G2, CHAIN3_B2 },
+#endif
+};
+static hub75_lut_t chain_lut[N_CHAINS];
+static uint32_t data_mask = 0;   // every chain's data bits
+
+static void init_scan_tables(void)
+{
+    const uint32_t lines[SCAN_MAX_ADDR_BITS] = { BIT_A, BIT_B, BIT_C, BIT_D, BIT_E };
+
+    ensure_geometry();
+
+    scan_col_t *map = malloc(SCAN_COLS * sizeof(scan_col_t));
+    if (!scan_off) scan_off = led_panel_alloc(SCAN_COLS * sizeof(uint32_t), LED_MEM_FAST, "scan map");
+    if (!row_stage) row_stage = led_panel_alloc(SCAN_COLS * N_CHAINS, LED_MEM_FAST, "row stage");
+    if (!full_list.slot) full_list.slot = led_panel_alloc(COLOR_DEPTH * PANEL_SCAN * sizeof(scan_slot_t),
+                                                          LED_MEM_FAST, "scan list");
+    if (!map || !scan_off || !row_stage || !full_list.slot) ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+
+    int cols = scan_build_map(&scan, PANEL_WIDTH, PANEL_HEIGHT, PANELS_PER_CHAIN, map, SCAN_COLS);
+    if (cols != SCAN_COLS) {
+        ESP_LOGE(TAG, "Scan %s does not fit a %dx%d panel", scan.name, PANEL_WIDTH, PANEL_HEIGHT);
+        ESP_ERROR_CHECK(ESP_ERR_INVALID_ARG);
+    }
+    for (int c = 0; c < cols; c++) {
+        scan_off[c] = map[c].y_offset * PHY_WIDTH + map[c].fb_x;
+    }
+    free(map);
+    scan_build_addr(&scan, lines, addr_set, addr_clr);
+
+    full_list.n = 0;
+    full_list.units = 0;
+    for (int plane = 0; plane < COLOR_DEPTH; plane++) {
+        for (int row = 0; row < PANEL_SCAN; row++) {
+            full_list.slot[full_list.n++] = (scan_slot_t){ .row = row, .plane = plane, .units = 1 << plane };
+        }
+        full_list.units += (uint32_t)PANEL_SCAN << plane;
+    }
+
+#if SCAN_FAST_PATHS
+    // Without these the full list is always shown
+    if (!plan_stage) {
+        size_t list_bytes = COLOR_DEPTH * PANEL_SCAN * sizeof(scan_slot_t);
+        plan_stage = led_panel_alloc(COLOR_DEPTH * SCAN_COLS * N_CHAINS, LED_MEM_FAST, "plan stage");
+        plan_units = led_panel_alloc(COLOR_DEPTH * PANEL_SCAN, LED_MEM_FAST, "plan units");
+        fast_lists[0].slot = led_panel_alloc(list_bytes, LED_MEM_FAST, "fast scan list");
+        fast_lists[1].slot = led_panel_alloc(list_bytes, LED_MEM_FAST, "fast scan list");
+        if (!plan_stage || !plan_units || !fast_lists[0].slot || !fast_lists[1].slot) {
+            ESP_LOGW(TAG, "No memory for the scan fast paths, every row is shifted");
+            plan_stage = NULL;
+        }
+    }
+#endif
+
+    data_mask = 0;
+    for (int k = 0; k < N_CHAINS; k++) {
+        for (int i = 0; i < HUB75_DATA_PINS; i++) {
+            if (chain_pins[k][i] >= 32) {
+                ESP_LOGE(TAG, "Chain %d data pin GPIO%d: must be < 32", k, chain_pins[k][i]);
+                ESP_ERROR_CHECK(ESP_ERR_INVALID_ARG);
+            }
+        }
+        hub75_lut_build(&chain_lut[k], chain_pins[k]);
+        data_mask |= chain_lut[k].mask;
+    }
+}
 
 // ------------ Pins init -------------
 void init_pins(void) {
@@ -195,6 +428,15 @@ void init_pins(void) {
                   | (1ULL<<PIN_R2) | (1ULL<<PIN_G2) | (1ULL<<PIN_B2)
                   | (1ULL<<PIN_A)  | (1ULL<<PIN_B)  | (1ULL<<PIN_C)
                   | (1ULL<<PIN_CLK)| (1ULL<<PIN_LAT);
+    for (int k = 1; k < N_CHAINS; k++) {
+        for (int i = 0; i < HUB75_DATA_PINS; i++) mask |= 1ULL << chain_pins[k][i];
+    }
+
+    init_scan_tables();
+
+    // D and E only when the scan needs them (E is a strapping pin)
+    if (led_geom.addr_bits >= 4) mask |= 1ULL<<PIN_D;
+    if (led_geom.addr_bits >= 5) mask |= 1ULL<<PIN_E;
 
     gpio_config_t io_conf = {
         .pin_bit_mask = mask,
@@ -216,12 +458,37 @@ void clear_back_buffer(void) {
     }
 }
 
+// After a swap the back buffer holds the frame before last; bring it up to date
+// so partial (delta) updates can be drawn on top of what is on screen
+void copy_front_to_back(void) {
+    for (int p = 0; p < COLOR_DEPTH; ++p) {
+        memcpy(back_planes[p], front_planes[p], PHY_HEIGHT * PHY_WIDTH);
+    }
+}
+
+// The same for one virtual rect only: undoes a partial draw without touching the
+// rest of the back buffer
+void copy_front_to_back_rect(int x, int y, int w, int h) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > VIRT_WIDTH)  w = VIRT_WIDTH - x;
+    if (y + h > VIRT_HEIGHT) h = VIRT_HEIGHT - y;
+
+    for (int j = y; j < y + h; ++j) {
+        for (int i = x; i < x + w; ++i) {
+            uint32_t k = led_panel_pixel_index(i, j);
+            for (int p = 0; p < COLOR_DEPTH; ++p) back_planes[p][k] = front_planes[p][k];
+        }
+    }
+}
+
 void swap_buffers(void) {
     for (int p = 0; p < COLOR_DEPTH; ++p) {
-        uint8_t (*tmp)[PHY_WIDTH] = front_planes[p];
+        uint8_t *tmp = front_planes[p];
         front_planes[p] = back_planes[p];
         back_planes[p]  = tmp;
     }
+    swap_count++;
 }
 
 // ------------ Virtual->Physical mapping set_pixel -------------
@@ -229,22 +496,34 @@ void swap_buffers(void) {
 // You draw in a virtual grid N_HOR x N_VER:
 // panel_col = x / PANEL_WIDTH
 // panel_row = y / PANEL_HEIGHT
-// phys_panel_index = panel_row * N_HOR + panel_col   (linear horizontal chain)
-// phys_x = phys_panel_index * PANEL_WIDTH + (x % PANEL_WIDTH)
-// phys_y = y % PANEL_HEIGHT
+// phys_panel_index = panel_row * N_HOR + panel_col   (linear order over the chains)
+// chain  = phys_panel_index / PANELS_PER_CHAIN
+// phys_x = (phys_panel_index % PANELS_PER_CHAIN) * PANEL_WIDTH + (x % PANEL_WIDTH)
+// phys_y = chain * PANEL_HEIGHT + (y % PANEL_HEIGHT)
 //
+// The geometry is only known at runtime, so the divisions are precomputed per
+// virtual row/column (build_pixel_map) and a pixel costs four table reads.
+//
+uint32_t led_panel_pixel_index(int x, int y) {
+    return panel_base[y_panel[y] + x_panel[x]] + y_off[y] + x_local[x];
+}
+
 void set_pixel(int x, int y, int r8, int g8, int b8) {
     if ((unsigned)x >= (unsigned)VIRT_WIDTH || (unsigned)y >= (unsigned)VIRT_HEIGHT) return;
 
-    // same mapping as your code:
-    int panel_col       = x / PANEL_WIDTH;
-    int panel_row       = y / PANEL_HEIGHT;
-    int phys_panel_idx  = panel_row * N_HOR + panel_col;
-    int local_x         = x % PANEL_WIDTH;
-    int local_y         = y % PANEL_HEIGHT;
-    int phys_x          = phys_panel_idx * PANEL_WIDTH + local_x;
-    int phys_y          = local_y;
-    if ((unsigned)phys_x >= (unsigned)PHY_WIDTH || (unsigned)phys_y >= (unsigned)PHY_HEIGHT) return;
+    uint32_t i = led_panel_pixel_index(x, y);
+
+    if (draw_rgb) {
+        if (draw_rgb_fmt == CANVAS_RGB565) {
+            ((uint16_t *)draw_rgb)[i] = canvas_rgb565(r8, g8, b8);
+        } else {
+            uint8_t *c = (uint8_t *)draw_rgb + i * 3;
+            c[0] = (uint8_t)r8;
+            c[1] = (uint8_t)g8;
+            c[2] = (uint8_t)b8;
+        }
+        return;
+    }
 
 	// New gamma corrected:
 	uint8_t rQ = gamma_table[r8];
@@ -257,105 +536,543 @@ void set_pixel(int x, int y, int r8, int g8, int b8) {
             (((rQ >> plane) & 1) ? 0x01 : 0) |
             (((gQ >> plane) & 1) ? 0x02 : 0) |
             (((bQ >> plane) & 1) ? 0x04 : 0);
-        back_planes[plane][phys_y][phys_x] = v;
+        draw_planes[plane][i] = v | draw_cover;
+    }
+}
+
+
+// ------------ HUB75 refresh task -------------
+//
+// Row addressing and the column shift order come from the scan pattern tables
+// (init_scan_tables): per address, scan_off[col] says where in the framebuffer
+// each shifted column's upper pixel sits; R2 is lower_offset rows below it.
+//
+// The planes may live in PSRAM, so they are only read by stage_row(), which runs
+// while the previous row is lit and copies the next row into row_stage. The
+// shift loop itself only touches internal RAM.
+//
+// Everything from here to led_panel_get_refresh_stats() is IRAM code on DRAM
+// data: an instruction cache miss into flash would stretch a row, and during a
+// flash write the ISR below must not touch flash at all.
+//
+
+// Gather one address row of one plane, in shift order, as LUT indices
+static IRAM_ATTR void stage_row(uint8_t *st, const uint8_t *plane, int row)
+{
+    const uint32_t stride    = PHY_WIDTH;
+    const uint32_t lower_off = scan.lower_offset * stride;   // R1 -> R2
+    const uint32_t chain_off = PANEL_HEIGHT * stride;        // chain k -> k + 1
+
+    // Same column and rows on every chain, one chain per PANEL_HEIGHT band.
+    // Table entries are validated at init, no bounds checks here
+    hub75_stage_row(st, PLANE_ROW(plane, row), scan_off, SCAN_COLS, N_CHAINS, chain_off, lower_off);
+}
+
+// Address a row and shift a staged row into it (OE must be off)
+static IRAM_ATTR void shift_row(const uint8_t *st, int row)
+{
+    // Set row address A..E
+    GPIO.out_w1ts = addr_set[row];
+    GPIO.out_w1tc = addr_clr[row];
+
+    // Shift out all columns in panel order
+    for (int col = 0; col < SCAN_COLS; col++) {
+        uint32_t set2 = 0;
+        for (int k = 0; k < N_CHAINS; k++) {
+            set2 |= chain_lut[k].set[*st++];
+        }
+
+        GPIO.out_w1ts = set2;
+        GPIO.out_w1tc = data_mask & ~set2;
+
+        // Clock
+        GPIO.out_w1ts = BIT_CLK;
+        GPIO.out_w1tc = BIT_CLK;
     }
+
+    // Latch
+    GPIO.out_w1ts = BIT_LAT;
+    GPIO.out_w1tc = BIT_LAT;
 }
 
+// One pass = all planes once; in dither mode each pass is the next sub-frame
+static IRAM_ATTR uint8_t **pass_planes(void)
+{
+    uint8_t **planes = dither_frame_planes();
+    return planes ? planes : front_planes;
+}
 
-// ------------ HUB75 refresh task (1/4 scan) -------------
+// ------------ Scan fast paths -------------
 //
-// Keeps your column-scanning logic pattern: total_cols = PANEL_WIDTH * PHYS_PANELS * 2
-// panel_index  = col / PANEL_WIDTH  -> 0..(2*PHYS_PANELS-1)
-// panel_in_row = panel_index / 2     (which physical panel in the chain)
-// y1 = (panel_index % 2) ? row : row + scan_rows
-// y2 = y1 + 2*scan_rows
+// A plane row that is all black is not shifted and takes no time; one equal to
+// a lower plane's row is shifted once with it and lit for both weights
+// (row_plan_units). Every pixel keeps its on-time per pass and the pass gets
+// shorter, so sparse frames refresh faster. Rows shown more often would be
+// brighter: the OE duty is scaled by the pass length against a full scan of
+// the same frame.
 //
-void refresh_task(void *arg) {
-    const int scan_rows  = PANEL_HEIGHT / 4;              // e.g., 8 for 32px
-    const int total_cols = PANEL_WIDTH * PHYS_PANELS * 2; // two halves
+// A plan is only used for the frame it was made from (swap_count); the full
+// list is shown until the plan of a new frame is complete.
+
+// Next address row of the plan, the list is built after the last one.
+// Builds into the fast list that is not `shown`. false = nothing to plan
+static IRAM_ATTR bool plan_step(const scan_list_t *shown)
+{
+    const uint32_t row_len = (uint32_t)SCAN_COLS * N_CHAINS;
+
+    if (plan_row < 0) {
+        if (fast_ready && fast_ready->swap == swap_count) return false;
+        plan_swap = swap_count;
+        for (int p = 0; p < COLOR_DEPTH; p++) plan_src[p] = front_planes[p];
+        plan_row = 0;
+    }
+
+    int row = plan_row;
+    uint8_t units[COLOR_DEPTH];
+    for (int p = 0; p < COLOR_DEPTH; p++) stage_row(plan_stage + p * row_len, plan_src[p], row);
+    row_plan_units(plan_stage, COLOR_DEPTH, row_len, units);
+    for (int p = 0; p < COLOR_DEPTH; p++) plan_units[p * PANEL_SCAN + row] = units[p];
+    if (++plan_row < PANEL_SCAN) return true;
+
+    plan_row = -1;
+    if (swap_count != plan_swap) return true;   // swapped while planning: start over
+
+    scan_list_t *l = shown == &fast_lists[0] ? &fast_lists[1] : &fast_lists[0];
+    l->n = 0;
+    l->units = 0;
+    l->skipped = 0;
+    l->merged = 0;
+    for (int p = 0; p < COLOR_DEPTH; p++) {
+        for (int r = 0; r < PANEL_SCAN; r++) {
+            uint8_t u = plan_units[p * PANEL_SCAN + r];
+            if (u) {
+                l->slot[l->n++] = (scan_slot_t){ .row = r, .plane = p, .units = u };
+                l->units += u;
+                continue;
+            }
+            uint8_t folded = 0;   // weights lit by the lower planes' shifts
+            for (int q = 0; q < p; q++) folded |= plan_units[q * PANEL_SCAN + r];
+            if (folded & (1 << p)) l->merged++;
+            else                   l->skipped++;
+        }
+    }
+    l->swap = plan_swap;
+    fast_ready = l;
+    rstats.plans++;
+    return true;
+}
+
+// The list for the next pass: the plan, if it is of the frame about to be shown
+static IRAM_ATTR const scan_list_t *pick_list(uint8_t **planes)
+{
+    if (planes == front_planes && fast_ready && fast_ready->swap == swap_count) return fast_ready;
+    return &full_list;
+}
+
+// ------------ Refresh rate governor -------------
+//
+// With a target rate, passes start on a fixed grid instead of back to back: as
+// many whole passes per target period as fit with slices of at least BASE_US,
+// the slices stretched over the rest, what is left blanked at the end. Each
+// pass is planned from the list it shows, so sparse frames get more repeats.
+// The arithmetic is refresh_model.c's, shared with the capacity planner.
+
+// ------------ Refresh during flash writes -------------
+//
+// A flash write (settings commit) disables the cache and parks the other core
+// in an IRAM loop with non-IRAM interrupts off, so refresh_task cannot run for
+// the few ms it takes (an erase: tens of ms) and the panel froze on one row lit
+// at full duty. Around the write led_panel_flash_begin() parks refresh_task,
+// stages the whole frame into internal RAM and starts a timer whose IRAM-safe
+// ISR scans it; led_panel_flash_end() hands back. Frames over
+// FLASH_SCAN_MAX_BYTES are blanked for the write instead.
+//
+// The time between two lit rows is tracked from begin until refresh_task has
+// lit its first row again: the longest is the refresh gap of that write.
+
+static TaskHandle_t refresh_handle = NULL;   // set once refresh_task is running
+static SemaphoreHandle_t parked = NULL;      // given by refresh_task when it stops
+static volatile bool flash_hold = false;     // refresh_task parks at the next row
+static volatile bool gap_watch = false;
+static volatile int64_t last_lit_us = 0;     // last row lit, task or ISR
+static volatile uint32_t gap_us = 0;         // longest gap of the current write
+
+static gptimer_handle_t scan_timer = NULL;
+static uint8_t *flash_frame = NULL;          // COLOR_DEPTH x PANEL_SCAN staged rows, NULL = blank
+static portMUX_TYPE scan_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool isr_scanning = false;
+static int isr_plane, isr_row, isr_ticks;
+
+static IRAM_ATTR void note_lit(int64_t now)
+{
+    if (gap_watch) {
+        uint32_t gap = (uint32_t)(now - last_lit_us);
+        if (gap > gap_us) gap_us = gap;
+        if (!flash_hold) {
+            // refresh_task is back after a flash write: the gap measurement is complete
+            gap_watch = false;
+            rstats.flash_gap_last_us = gap_us;
+            if (gap_us > rstats.flash_gap_max_us) rstats.flash_gap_max_us = gap_us;
+        }
+    }
+    last_lit_us = now;
+}
+
+// Every BASE_US: the lit row keeps its 1 << plane slices, then the next one is shifted
+static IRAM_ATTR bool flash_scan_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *ev, void *arg)
+{
+    portENTER_CRITICAL_ISR(&scan_lock);
+    if (isr_scanning && --isr_ticks == 0) {
+        const uint32_t row_len = (uint32_t)SCAN_COLS * N_CHAINS;
+
+        oe_off();
+        shift_row(flash_frame + (isr_plane * PANEL_SCAN + isr_row) * row_len, isr_row);
+        update_oe_duty();
+        note_lit(esp_timer_get_time());
+
+        isr_ticks = 1 << isr_plane;
+        if (++isr_row == PANEL_SCAN) {
+            isr_row = 0;
+            if (++isr_plane == COLOR_DEPTH) isr_plane = 0;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&scan_lock);
+    return false;
+}
+
+// Runs on refresh_task, so the timer interrupt lands on core 0 with it
+static void init_flash_scan(void)
+{
+    parked = xSemaphoreCreateBinary();
+    if (!parked) {
+        ESP_LOGE(TAG, "No memory for the flash-write handover");
+        return;
+    }
+    refresh_handle = xTaskGetCurrentTaskHandle();
+
+    size_t bytes = (size_t)COLOR_DEPTH * PANEL_SCAN * SCAN_COLS * N_CHAINS;
+    if (bytes > FLASH_SCAN_MAX_BYTES) {
+        ESP_LOGW(TAG, "Frame copy for flash writes is %u bytes, panel blanks during writes",
+                 (unsigned)bytes);
+        return;
+    }
+
+    // The link map is checked at build time; this catches a config that slipped past it
+    if (!esp_ptr_in_iram(flash_scan_isr) || !esp_ptr_in_iram(shift_row) ||
+        !esp_ptr_in_iram(update_oe_duty) || !esp_ptr_in_iram(ledc_update_duty)) {
+        ESP_LOGE(TAG, "Refresh code is not in IRAM, panel blanks during flash writes");
+        return;
+    }
+
+    uint8_t *frame = led_panel_alloc(bytes, LED_MEM_FAST, "flash scan frame");
+    if (!frame || !esp_ptr_internal(frame)) {
+        ESP_LOGE(TAG, "No internal RAM for the flash scan frame, panel blanks during writes");
+        return;
+    }
+
+    const gptimer_config_t timer_conf = {
+        .clk_src       = GPTIMER_CLK_SRC_DEFAULT,
+        .direction     = GPTIMER_COUNT_UP,
+        .resolution_hz = FLASH_SCAN_TIMER_HZ,
+    };
+    const gptimer_alarm_config_t alarm = {
+        .alarm_count = (uint64_t)BASE_US * FLASH_SCAN_TIMER_HZ / 1000000,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = 1,
+    };
+    const gptimer_event_callbacks_t cbs = { .on_alarm = flash_scan_isr };
+
+    esp_err_t err = gptimer_new_timer(&timer_conf, &scan_timer);
+    if (err == ESP_OK) err = gptimer_set_alarm_action(scan_timer, &alarm);
+    if (err == ESP_OK) err = gptimer_register_event_callbacks(scan_timer, &cbs, NULL);
+    if (err == ESP_OK) err = gptimer_enable(scan_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Flash scan timer: %s, panel blanks during writes", esp_err_to_name(err));
+        return;
+    }
+    flash_frame = frame;
+}
+
+void led_panel_flash_begin(void)
+{
+    if (!refresh_handle) return;   // not scanning yet
+
+    flash_hold = true;             // before gap_watch: refresh_task closes a gap when hold is off
+    gap_us = 0;
+    gap_watch = true;
+    xSemaphoreTake(parked, portMAX_DELAY);   // within one row
+
+    rstats.flash_writes++;
+    if (!flash_frame) {
+        rstats.flash_blanked++;    // refresh_task left OE off
+        return;
+    }
+
+    const uint32_t row_len = (uint32_t)SCAN_COLS * N_CHAINS;
+    uint8_t **planes = pass_planes();
+    duty_scale = 256;              // the ISR scans every row; refresh_task sets it back
+    for (int plane = 0; plane < COLOR_DEPTH; plane++) {
+        for (int row = 0; row < PANEL_SCAN; row++) {
+            stage_row(flash_frame + (plane * PANEL_SCAN + row) * row_len, planes[plane], row);
+        }
+    }
+
+    portENTER_CRITICAL(&scan_lock);
+    isr_plane = 0;
+    isr_row = 0;
+    isr_ticks = 1;                 // first row at the first alarm
+    isr_scanning = true;
+    portEXIT_CRITICAL(&scan_lock);
+
+    gptimer_set_raw_count(scan_timer, 0);
+    gptimer_start(scan_timer);
+}
+
+void led_panel_flash_end(void)
+{
+    if (!refresh_handle || !flash_hold) return;
+
+    if (flash_frame) {
+        gptimer_stop(scan_timer);
+        portENTER_CRITICAL(&scan_lock);    // an ISR already running finishes its row
+        isr_scanning = false;
+        portEXIT_CRITICAL(&scan_lock);
+        oe_off();
+    }
+
+    flash_hold = false;
+    xTaskNotifyGive(refresh_handle);
+}
+
+IRAM_ATTR void refresh_task(void *arg) {
+    const uint32_t row_bytes = (uint32_t)SCAN_COLS * N_CHAINS * 2;   // upper + lower
+
+    init_flash_scan();
+
+    static DRAM_ATTR const uint8_t over_limit[LED_ROW_OVER_BUCKETS - 1] = LED_ROW_OVER_LIMITS;
+
+    uint8_t **planes = pass_planes();
+    const scan_list_t *list = &full_list;
+    stage_row(row_stage, planes[0], 0);
+
+    uint32_t shift16 = 0;                 // time to shift a row in the last pass, 1/16 µs
+    int64_t now = esp_timer_get_time();   // end of the last busy wait
+
+    // Governor grid: pass n of the second starting at grid_epoch ends at
+    // grid_epoch + n s / (target * repeat). 0 = free-running
+    uint32_t grid_hz = 0, grid_repeat = 0, grid_n = 0;
+    int64_t grid_epoch = 0, pass_end = 0;
 
     while (1) {
-        for (int plane = 0; plane < COLOR_DEPTH; ++plane) {
-            int weight = 1 << plane; // binary weight for PWM
-
-            for (int row = 0; row < scan_rows; row++) {
-
-                // OE off while we change address / shift
-				// Duty = max → PWM is always HIGH → OE stays HIGH → panel off
-				ledc_set_duty(OE_SPEED_MODE, OE_CHANNEL, 0);
-				ledc_update_duty(OE_SPEED_MODE, OE_CHANNEL);
-
-                // Set row address ABC
-                uint32_t set_mask = 0, clr_mask = 0;
-                if (row & 0x01) set_mask |= BIT_A; else clr_mask |= BIT_A;
-                if (row & 0x02) set_mask |= BIT_B; else clr_mask |= BIT_B;
-                if (row & 0x04) set_mask |= BIT_C; else clr_mask |= BIT_C;
-                GPIO.out_w1ts = set_mask;
-                GPIO.out_w1tc = clr_mask;
-
-                // Shift out all columns (exactly your logic)
-                for (int col = 0; col < total_cols; col++) {
-                    int panel_index    = col / PANEL_WIDTH;      // 0..(2*PHYS_PANELS-1)
-                    int local_x        = col % PANEL_WIDTH;
-                    int panel_in_chain = panel_index / 2;        // 0..(PHYS_PANELS-1)
-                    int fb_x           = panel_in_chain * PANEL_WIDTH + local_x;
-
-                    uint32_t set2 = 0, clr2 = 0;
-
-                    // Upper/lower halves for this scan step
-                    int y1 = (panel_index % 2) ? row : row + scan_rows;
-                    int y2 = y1 + 2 * scan_rows;
-
-                    uint8_t p1 = 0, p2 = 0;
-                    if ((unsigned)fb_x < (unsigned)PHY_WIDTH) {
-                        if ((unsigned)y1 < (unsigned)PHY_HEIGHT) p1 = front_planes[plane][y1][fb_x];
-                        if ((unsigned)y2 < (unsigned)PHY_HEIGHT) p2 = front_planes[plane][y2][fb_x];
-                    }
-
-                    // Row 1 colors
-                    if (p1 & 0x01) set2 |= BIT_R1; else clr2 |= BIT_R1;
-                    if (p1 & 0x02) set2 |= BIT_G1; else clr2 |= BIT_G1;
-                    if (p1 & 0x04) set2 |= BIT_B1; else clr2 |= BIT_B1;
-
-                    // Row 2 colors
-                    if (p2 & 0x01) set2 |= BIT_R2; else clr2 |= BIT_R2;
-                    if (p2 & 0x02) set2 |= BIT_G2; else clr2 |= BIT_G2;
-                    if (p2 & 0x04) set2 |= BIT_B2; else clr2 |= BIT_B2;
-
-                    GPIO.out_w1ts = set2;
-                    GPIO.out_w1tc = clr2;
-
-                    // Clock
-                    GPIO.out_w1ts = BIT_CLK;
-                    GPIO.out_w1tc = BIT_CLK;
-                }
+        if (row_over_reset) {
+            row_over_reset = false;
+            rstats.row_over_max_us = 0;
+            memset(rstats.row_over_hist, 0, sizeof(rstats.row_over_hist));
+        }
 
-                // Latch
-                GPIO.out_w1ts = BIT_LAT;
-                GPIO.out_w1tc = BIT_LAT;
+        // Black frame: nothing to shift, look again next tick
+        if (list->n == 0) {
+            oe_off();
+            if (flash_hold) {
+                xSemaphoreGive(parked);
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                note_lit(esp_timer_get_time());
+            }
+            rstats.idle_waits++;
+            vTaskDelay(1);
+
+            planes = pass_planes();
+            list = pick_list(planes);
+            if (list->n) stage_row(row_stage, planes[list->slot[0].plane], list->slot[0].row);
+            now = esp_timer_get_time();
+            continue;
+        }
 
-				// Duty = 0 → PWM is always LOW → OE stays LOW → panel on
-				update_oe_duty();
+        // Slice length and pass end: back to back, or on the target's grid
+        uint32_t slice16 = 16 * BASE_US;
+        uint64_t period16 = (uint64_t)list->n * shift16 + (uint64_t)list->units * slice16;
+        uint32_t target = refresh_target_hz;
+        uint32_t repeat = grid_repeat;
+        if (target) {
+            if (!refresh_grid_plan(list->n, list->units, shift16, BASE_US, target, &repeat, &slice16))
+                rstats.target_unmet++;
+            uint32_t per_s = target * repeat;
+            // A new grid from here when it changed or the refresh fell a period behind
+            if (target != grid_hz || repeat != grid_repeat || now - pass_end > 1000000 / per_s) {
+                grid_hz = target;
+                grid_repeat = repeat;
+                grid_epoch = now;
+                grid_n = 0;
+            }
+            pass_end = grid_epoch + (int64_t)++grid_n * 1000000 / per_s;
+            if (grid_n == per_s) {
+                grid_epoch += 1000000;
+                grid_n = 0;
+            }
+            period16 = 16000000ull / per_s;
+        } else {
+            grid_hz = 0;
+            grid_repeat = 0;
+        }
+        uint16_t scale = refresh_duty_scale(period16, slice16, shift16, BASE_US, full_list.n, full_list.units);
+        duty_scale = scale;
+
+        uint32_t late_rows = 0;
+        uint32_t shift_sum = 0;
+        int64_t pass_start = now;
+        bool plan = plan_stage && planes == front_planes;   // not for dither sub-frames
+        const scan_list_t *next_list = list;
+        TRACE_BEGIN(TRACE_REFRESH_PASS);
+        rstats.passes++;
+
+        for (int i = 0; i < list->n; i++) {
+            const scan_slot_t *s = &list->slot[i];
+
+            // A flash write is coming: blank, hand over, restage when it is done
+            if (flash_hold) {
+                oe_off();
+                xSemaphoreGive(parked);
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                duty_scale = scale;
+                stage_row(row_stage, planes[s->plane], s->row);
+                now = esp_timer_get_time();
+            }
 
-                for (int t = 0; t < weight; ++t) { // Enable for weighted time slice
-                    esp_rom_delay_us(BASE_US);    // very short unit, e.g. 20 µs
-                }
+            // OE off while we change address / shift
+            oe_off();
+            shift_row(row_stage, s->row);
+
+			// Duty = 0 → PWM is always LOW → OE stays LOW → panel on
+			update_oe_duty();
+            int64_t t_on = esp_timer_get_time();
+            int64_t t_off = t_on + ((s->units * slice16) >> 4);   // weighted time slice
+            shift_sum += (uint32_t)(t_on - now);
+            note_lit(t_on);
+
+            // Prefetch the next slot while this one is lit; the last one starts the next pass
+            int next = i + 1;
+            if (next == list->n) {
+                next = 0;
+                planes = pass_planes();
+                next_list = pick_list(planes);
+            }
+            if (next_list->n) {
+                stage_row(row_stage, planes[next_list->slot[next].plane], next_list->slot[next].row);
+            }
+
+            int64_t t_staged = esp_timer_get_time();
+            uint32_t us = (uint32_t)(t_staged - t_on);
+            rstats.rows++;
+            rstats.fb_bytes += row_bytes;
+            rstats.prefetch_us += us;
+            if (us > rstats.prefetch_max_us) rstats.prefetch_max_us = us;
+            if (t_staged > t_off) late_rows++;
+
+            // Plan the front frame with what is left of the slot. Not in the last
+            // slot: the next pass may already be on the list it would build into
+            if (plan && next != 0 && t_off - t_staged >= plan_cost_us && plan_step(list)) {
+                plan_cost_us = (uint32_t)(esp_timer_get_time() - t_staged);
+                rstats.plan_us += plan_cost_us;
             }
+
+            while ((now = esp_timer_get_time()) < t_off) { }
+
+            uint32_t over = (uint32_t)(now - t_off);
+            int b = 0;
+            while (b < LED_ROW_OVER_BUCKETS - 1 && over >= over_limit[b]) b++;
+            rstats.row_over_hist[b]++;
+            if (over > rstats.row_over_max_us) rstats.row_over_max_us = over;
+            if (over >= LED_ROW_OVER_TRACE_US) TRACE_INSTANT(TRACE_ROW_OVERRUN, over > 0xFFFF ? 0xFFFF : over);
         }
+
+        // On the grid: blank until the pass's end, or count it late
+        if (grid_hz) {
+            if (now > pass_end) {
+                rstats.target_late++;
+            } else {
+                oe_off();
+                rstats.blank_us += (uint32_t)(pass_end - now);
+                while ((now = esp_timer_get_time()) < pass_end) { }
+            }
+        }
+        rstats.target_hz = grid_hz;
+        rstats.target_repeat = grid_repeat;
+        rstats.slice_ns = slice16 * 1000 / 16;
+
+        shift16 = shift_sum * 16 / list->n;
+        rstats.shift_ns = shift16 * 1000 / 16;
+        rstats.pass_us = (uint32_t)(now - pass_start);
+        rstats.pass_full_us = (full_list.n * shift16 >> 4) + full_list.units * BASE_US;
+        rstats.duty_scale = scale;
+        if (list != &full_list) {
+            rstats.fast_passes++;
+            rstats.rows_skipped += list->skipped;
+            rstats.rows_merged += list->merged;
+        }
+        list = next_list;
+
+        rstats.late += late_rows;
+        TRACE_END(TRACE_REFRESH_PASS);
+        if (late_rows) TRACE_INSTANT(TRACE_REFRESH_LATE, late_rows);
     }
 }
 
+void led_panel_get_refresh_stats(led_refresh_stats_t *out)
+{
+    *out = rstats;
+}
+
+void led_panel_reset_row_overrun(void)
+{
+    row_over_reset = true;
+}
+
+uint32_t led_panel_max_refresh_hz(void)
+{
+    // For the full scan: every new frame is shown with it until it is planned
+    if (!rstats.shift_ns || !full_list.n) return 0;
+    return refresh_max_hz(full_list.n, full_list.units, rstats.shift_ns * 16 / 1000);
+}
+
+esp_err_t led_panel_set_refresh_target(uint16_t hz)
+{
+    refresh_target_hz = hz;
+    if (!hz) return ESP_OK;
+
+    // The reach comes from the measured shift time: wait for refresh_task's first pass
+    uint32_t max;
+    TickType_t start = xTaskGetTickCount();
+    while (!(max = led_panel_max_refresh_hz())) {
+        if (xTaskGetTickCount() - start >= pdMS_TO_TICKS(REFRESH_MEASURE_WAIT_MS)) {
+            ESP_LOGW(TAG, "Refresh target %u Hz set unchecked: no refresh pass measured yet", hz);
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+    if (hz > max) {
+        ESP_LOGW(TAG, "Refresh target %u Hz out of reach for %dx%d 1/%u, %d bits: about %lu Hz at most",
+                 hz, PHY_WIDTH, PHY_HEIGHT, PANEL_SCAN, COLOR_DEPTH, (unsigned long)max);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
 // set_pixel(x, y, r, g, b) is your existing function
 // VIRT_WIDTH, VIRT_HEIGHT are the virtual drawing dimensions
 
-// ----------------- Draw a single character -----------------
-void draw_char(int x, int y, char c, int r, int g, int b) {
-    if (c < 32 || c > 126) c = '?';  // fallback
-    int index = c - 32;
+_Static_assert(TEXT_ADVANCE_2 == FONT_WIDTH_5 + 1, "TEXT_ADVANCE_2 does not match font10x15");
+_Static_assert(TEXT_ADVANCE_5 == FONT_WIDTH_8 + 1, "TEXT_ADVANCE_5 does not match font5x5");
+_Static_assert(TEXT_ADVANCE_6 == FONT_WIDTH_9 + 1, "TEXT_ADVANCE_6 does not match font3x5");
+_Static_assert(sizeof(font6x9_ext) / sizeof(font6x9_ext[0]) == GLYPH_EXT_COUNT,
+               "font6x9_ext.h and glyph_map.c disagree on the extra glyphs");
 
+// ----------------- Draw a single glyph by font index -----------------
+static void draw_glyph(int x, int y, int index, int r, int g, int b) {
+    const uint8_t (*bmp)[FONT_WIDTH] = index < GLYPH_EXT_FIRST ? font6x9[index]
+                                                               : font6x9_ext[index - GLYPH_EXT_FIRST];
     for (int row = 0; row < FONT_HEIGHT; row++) {
         for (int col = 0; col < FONT_WIDTH; col++) {
-            if (font6x9[index][row][col]) {
+            if (bmp[row][col]) {
                 int px = x + col;
                 int py = y + row;
                 if (px >= 0 && px < VIRT_WIDTH && py >= 0 && py < VIRT_HEIGHT) {
@@ -366,21 +1083,36 @@ void draw_char(int x, int y, char c, int r, int g, int b) {
     }
 }
 
-// ----------------- Draw a string with 1-pixel spacing -----------------
+// ----------------- Draw a single character -----------------
+void draw_char(int x, int y, char c, int r, int g, int b) {
+    if (c < 32 || c > 126) c = '?';  // fallback
+    draw_glyph(x, y, c - 32, r, g, b);
+}
+
+// ----------------- Draw pre-resolved glyphs (text_layout_t) -----------------
+void draw_glyphs(int x, int y, const uint8_t *glyph, int n, int r, int g, int b) {
+    for (int i = 0; i < n; i++, x += TEXT_ADVANCE) {
+        if (x + FONT_WIDTH <= 0 || x >= VIRT_WIDTH) continue;   // off screen (scrolling)
+        draw_glyph(x, y, glyph[i], r, g, b);
+    }
+}
+
+// ----------------- Draw a UTF-8 string with 1-pixel spacing -----------------
 void draw_text(int x, int y, const char *text, int r, int g, int b) {
     int cursor_x = x;
     while (*text) {
-        draw_char(cursor_x, y, *text, r, g, b);
+        draw_glyph(cursor_x, y, glyph_lookup(utf8_next(&text)), r, g, b);
         cursor_x += FONT_WIDTH + 1;  // advance cursor by font width + 1 pixel spacing
-        text++;
     }
 }
 
 
 // ----------------- Scroll text horizontally (improved) -----------------
 void scroll_text(const char *text, int y, int r, int g, int b, int speed_ms) {
-    int len = strlen(text);
-    int text_width = len * (FONT_WIDTH + 1); // include spacing
+    // Width in characters, not bytes: a multi-byte UTF-8 sequence is one glyph
+    int len = 0;
+    for (const char *p = text; *p; len++) utf8_next(&p);
+    int text_width = len * TEXT_ADVANCE; // include spacing
 
     // Precompute virtual width including the panel width
     int total_scroll = text_width + VIRT_WIDTH;
@@ -396,10 +1128,11 @@ void scroll_text(const char *text, int y, int r, int g, int b, int speed_ms) {
 
         int cursor_x = VIRT_WIDTH - scroll_x;
         const char *p = text;
-        while (*p) {
-            draw_char(cursor_x, y, *p, r, g, b);
-            cursor_x += FONT_WIDTH + 1;
-            p++;
+        while (*p && cursor_x < VIRT_WIDTH) {
+            uint32_t cp = utf8_next(&p);
+            if (cursor_x + FONT_WIDTH > 0)    // glyphs left of the screen are skipped
+                draw_glyph(cursor_x, y, glyph_lookup(cp), r, g, b);
+            cursor_x += TEXT_ADVANCE;
         }
 
         swap_buffers();
@@ -1,24 +1,70 @@
+#pragma once
 #include <stdint.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_err.h"
 #include "font6x9.h"
 
 
 // ------------ CONFIG: panel + layout ------------
-#define PANEL_WIDTH    64
-#define PANEL_HEIGHT   32    // must be divisible by 4 (1/4 scan)
-#define N_HOR          1     // logical panels horizontally
-#define N_VER          1     // logical panels vertically
+// Defaults only: the installation's geometry is loaded from the settings store
+// at boot and handed to led_panel_set_geometry() before init_pins()/init_planes()
+#define DEFAULT_PANEL_WIDTH    64
+#define DEFAULT_PANEL_HEIGHT   32    // must be 2, 4, 6 or 8 times the scan
+#define DEFAULT_PANEL_SCAN     8     // row addresses: 8 (1/8, A-C), 16 (1/16, A-D), 32 (1/32, A-E)
+#define DEFAULT_N_HOR          1     // logical panels horizontally
+#define DEFAULT_N_VER          1     // logical panels vertically
+#define N_CHAINS               1     // parallel chains sharing CLK/LAT/OE/address (1..4), wiring
+
+#if N_CHAINS < 1 || N_CHAINS > 4
+#error "N_CHAINS must be 1..4"
+#endif
 
-// Virtual drawing size (what you use in set_pixel)
-#define VIRT_WIDTH   (PANEL_WIDTH  * N_HOR)
-#define VIRT_HEIGHT  (PANEL_HEIGHT * N_VER)
-
-// Physical chain: all panels wired as one long horizontal row
-#define PHYS_PANELS  (N_HOR * N_VER)
-#define PHY_WIDTH    (PANEL_WIDTH  * PHYS_PANELS)
-#define PHY_HEIGHT   (PANEL_HEIGHT)
+typedef struct {
+    uint16_t panel_width;
+    uint16_t panel_height;
+    uint8_t  scan;
+    uint8_t  n_hor;
+    uint8_t  n_ver;
+} panel_geometry_t;
+
+// Sizes derived from the geometry; fixed once the buffers are allocated
+typedef struct {
+    panel_geometry_t g;
+    int virt_width, virt_height;   // drawing size (what you use in set_pixel)
+    int phys_panels;
+    int panels_per_chain;
+    int phy_width, phy_height;     // framebuffer; phy_width is the row stride
+    int plane_bytes;               // phy_width * phy_height, multiple of 4
+    int addr_bits;
+    int scan_cols;                 // columns shifted per address per chain
+} led_geometry_t;
+
+extern led_geometry_t led_geom;
+
+#define PANEL_WIDTH       (led_geom.g.panel_width)
+#define PANEL_HEIGHT      (led_geom.g.panel_height)
+#define PANEL_SCAN        (led_geom.g.scan)
+#define N_HOR             (led_geom.g.n_hor)
+#define N_VER             (led_geom.g.n_ver)
+
+// Virtual drawing size
+#define VIRT_WIDTH        (led_geom.virt_width)
+#define VIRT_HEIGHT       (led_geom.virt_height)
+
+// Physical chains: panels in linear order (row-major over the virtual grid) are
+// split evenly over N_CHAINS chains. Chain k owns framebuffer rows
+// [k * PANEL_HEIGHT, (k + 1) * PANEL_HEIGHT), each chain one long horizontal row.
+#define PHYS_PANELS       (led_geom.phys_panels)
+#define PANELS_PER_CHAIN  (led_geom.panels_per_chain)
+#define PHY_WIDTH         (led_geom.phy_width)
+#define PHY_HEIGHT        (led_geom.phy_height)
+#define PLANE_BYTES       (led_geom.plane_bytes)
+#define SCAN_COLS         (led_geom.scan_cols)
+
+// Row y of a flat plane buffer
+#define PLANE_ROW(plane, y)   ((plane) + (y) * PHY_WIDTH)
 
 // ------------ GPIO PINS (adjust as needed) ------------
 #define PIN_R1  GPIO_NUM_2
@@ -33,10 +79,28 @@
 #define PIN_A   GPIO_NUM_15
 #define PIN_B   GPIO_NUM_26
 #define PIN_C   GPIO_NUM_23
+// Chain 0 data pins. Chains 1..3 need CHAINn_R1 .. CHAINn_B2 (all GPIO < 32)
+#define PIN_D   GPIO_NUM_17   // 1/16 and 1/32 scan only
+#define PIN_E   GPIO_NUM_0    // 1/32 scan only. Strapping pin: keep it high-Z/pulled up at reset
 
 
 //temperature sensor GPIO_NUM_27 ( INITIALIZE IN MAIN)
 
+// Extra chains: define the pin group of every chain in use, e.g.
+// #define CHAIN1_R1 GPIO_NUM_x ... #define CHAIN1_B2 GPIO_NUM_x
+#if N_CHAINS >= 2 && !(defined(CHAIN1_R1) && defined(CHAIN1_G1) && defined(CHAIN1_B1) && \
+                       defined(CHAIN1_R2) && defined(CHAIN1_G2) && defined(CHAIN1_B2))
+#error "N_CHAINS >= 2: define CHAIN1_R1, CHAIN1_G1, CHAIN1_B1, CHAIN1_R2, CHAIN1_G2, CHAIN1_B2"
+#endif
+#if N_CHAINS >= 3 && !(defined(CHAIN2_R1) && defined(CHAIN2_G1) && defined(CHAIN2_B1) && \
+                       defined(CHAIN2_R2) && defined(CHAIN2_G2) && defined(CHAIN2_B2))
+#error "N_CHAINS >= 3: define CHAIN2_R1, CHAIN2_G1, CHAIN2_B1, CHAIN2_R2, CHAIN2_G2, CHAIN2_B2"
+#endif
+#if N_CHAINS >= 4 && !(defined(CHAIN3_R1) && defined(CHAIN3_G1) && defined(CHAIN3_B1) && \
+                       defined(CHAIN3_R2) && defined(CHAIN3_G2) && defined(CHAIN3_B2))
+#error "N_CHAINS >= 4: define CHAIN3_R1, CHAIN3_G1, CHAIN3_B1, CHAIN3_R2, CHAIN3_G2, CHAIN3_B2"
+#endif
+
 
 // Precalculate bitmasks for speed
 #define BIT_R1 (1 << PIN_R1)
@@ -49,6 +113,8 @@
 #define BIT_A  (1 << PIN_A)
 #define BIT_B  (1 << PIN_B)
 #define BIT_C  (1 << PIN_C)
+#define BIT_D  (1 << PIN_D)
+#define BIT_E  (1 << PIN_E)
 
 #define BIT_CLK (1 << PIN_CLK)
 #define BIT_LAT (1 << PIN_LAT)
@@ -65,27 +131,59 @@
 #define COLOR_DEPTH   3              // 3 bits per color (0..7). You can try 4 later.
 #define BASE_US       30             // base OE time per LSB slice (tune 15–30us)
 
+// ------------ CONFIG: memory placement ------------
+// Frames (COLOR_DEPTH planes) at least this big put the bulk buffers (A/B planes,
+// compositor layers, canvases) in PSRAM first. refresh_task never shifts from
+// them directly: the next row is staged into internal RAM while OE is on.
+#define PSRAM_BULK_FRAME_BYTES   (48 * 1024)   // ~8 panels of 64x32
+
+// ------------ CONFIG: refresh during flash writes ------------
+// While a settings commit writes flash, an IRAM timer ISR scans a copy of the
+// frame staged in internal RAM (led_panel_flash_begin). Bigger copies blank the
+// panel for the write instead.
+#define FLASH_SCAN_MAX_BYTES     (16 * 1024)   // COLOR_DEPTH * PANEL_SCAN * SCAN_COLS * N_CHAINS
+#define FLASH_SCAN_TIMER_HZ      1000000       // 1 tick = 1 µs, alarms every BASE_US
+
+// ------------ CONFIG: scan fast paths ------------
+// Rows black in a plane are not shifted, rows equal in several planes are shifted
+// once and lit for the summed weight (row_plan.h). Sparse frames refresh faster;
+// the OE duty follows the pass length, so brightness stays. 0 = scan every row.
+#define SCAN_FAST_PATHS          1
+
+// ------------ CONFIG: refresh rate governor ------------
+// 0 = free-running: each pass as fast as the shifts and BASE_US slices allow.
+// A target (e.g. 240 or 960 Hz) puts the passes on a fixed grid of 1/target s:
+// whole passes repeated per period, slices stretched to fill it, the rest
+// blanked, so a camera exposure of n/target s sees no banding. The stored
+// setting (refresh_hz) overrides this default. Limits in refresh_model.h.
+#define REFRESH_TARGET_HZ        0
+#define REFRESH_MEASURE_WAIT_MS  500   // led_panel_set_refresh_target waits this long for the first pass
+
 //buttons
 #define PIN_MENU    GPIO_NUM_33
 #define PIN_UP      GPIO_NUM_32
 #define PIN_DOWN    GPIO_NUM_16
 
-#define DEBOUNCE_MS    500      // minimum time between presses
+#define HOLD_MS        1000     // hold time to enter menu / mode / format
 #define REPEAT_DELAY   500     // initial delay before repeating
 #define REPEAT_RATE    500    // repeat interval while holding
 
 
 // Plane buffers: same physical size, but one per PWM plane
 // Each cell packs R,G,B bits like your old buffer: bit0=R, bit1=G, bit2=B
-static uint8_t (*front_planes[COLOR_DEPTH])[PHY_WIDTH];
-static uint8_t (*back_planes [COLOR_DEPTH])[PHY_WIDTH];
+// bit3 (PIXEL_COVER) is only used in compositor layers: "this pixel was drawn"
+#define PIXEL_RGB_MASK  0x07
+#define PIXEL_COVER     0x08
 
-// Allocate concrete storage (A/B for double buffering)
-static uint8_t fbA[COLOR_DEPTH][PHY_HEIGHT][PHY_WIDTH];
-static uint8_t fbB[COLOR_DEPTH][PHY_HEIGHT][PHY_WIDTH];
+// Flat planes of PLANE_BYTES each, A/B double buffered, allocated by init_planes()
+extern uint8_t *front_planes[COLOR_DEPTH];
+extern uint8_t *back_planes [COLOR_DEPTH];
 
 extern bool stop_flag;
 
+// 8-bit channel -> plane level (0..7)
+extern const uint8_t gamma_table[256];
+
 
 typedef struct {
     const char *text;   // text to scroll (can include '\n' for multiple lines)
@@ -102,6 +200,32 @@ void set_global_brightness(uint8_t level);
 void refresh_task(void *arg);
 void clear_back_buffer(void);
 void swap_buffers(void);
+void copy_front_to_back(void);
+void copy_front_to_back_rect(int x, int y, int w, int h);   // virtual coordinates, clipped
+
+// Redirect set_pixel (and every draw_* built on it) into other plane storage.
+// NULL = back buffer. cover=true also sets PIXEL_COVER on every drawn pixel.
+void led_panel_set_target(uint8_t **planes, bool cover);
+
+// Current plane target of set_pixel, and the cover bits it adds
+uint8_t **led_panel_target(uint8_t *cover);
+
+typedef enum {
+    CANVAS_RGB888 = 0,   // 3 bytes per pixel, R G B
+    CANVAS_RGB565,       // uint16_t per pixel
+} canvas_format_t;
+
+// Redirect set_pixel into a row-major canvas (PHY_WIDTH x PHY_HEIGHT, physical
+// layout, no gamma applied). NULL = back to the plane target.
+void led_panel_set_canvas(void *buf, canvas_format_t fmt);
+
+// Incremented by every swap_buffers(), so a cache of "what is on screen" can tell
+// that someone else presented a frame
+uint32_t led_panel_swap_count(void);
+
+// Exclusive use of the back buffer (drawing + swap). init_planes() creates the lock.
+bool led_panel_claim(TickType_t wait);
+void led_panel_release(void);
 
 
 
@@ -116,6 +240,16 @@ void draw_text(int x, int y, const char *s, int r, int g, int b);
 void scroll_text(const char *text, int y, int r, int g, int b, int speed_ms);
 void draw_char(int x, int y, char c, int r, int g, int b);
 
+// Cursor advance of the draw_text_* fonts (glyph width + 1 pixel spacing), for text_layout_set
+#define TEXT_ADVANCE     (FONT_WIDTH + 1)
+#define TEXT_ADVANCE_2   11    // font10x15
+#define TEXT_ADVANCE_5   6     // font5x5
+#define TEXT_ADVANCE_6   4     // font3x5
+
+// draw_text decodes UTF-8 (glyph_map.h lists what the font covers, the rest shows '?').
+// draw_glyphs takes the font indices of a text_layout_t; glyphs off screen are skipped
+void draw_glyphs(int x, int y, const uint8_t *glyph, int n, int r, int g, int b);
+
 
 
 
@@ -171,26 +305,104 @@ void draw_text_6(int x, int y, const char *text, int r, int g, int b);
 
 
 
-void init_planes(void);
-void draw_bitmap_rgb(int x0, int y0, const uint32_t *bmp, int w, int h);
-void set_global_brightness_pct(uint8_t percent);
+/**
+ * @brief Validate and apply a geometry (call before init_pins). Invalid -> ESP_ERR_INVALID_ARG,
+ * the previous geometry stays.
+ */
+esp_err_t led_panel_set_geometry(const panel_geometry_t *g);
 
-void set_pixel(int x, int y, int r8, int g8, int b8);
+typedef enum {
+    LED_MEM_FAST = 0,   // read in the refresh loop: internal RAM, PSRAM only as a last resort
+    LED_MEM_BULK,       // frame-sized: PSRAM first once a frame reaches PSRAM_BULK_FRAME_BYTES
+} led_mem_t;
 
-void init_nvs_brightness();
-
-void save_brightness(uint8_t level);
-uint8_t load_brightness();
+/**
+ * @brief Zeroed buffer placed by kind; falls back to the other memory with a warning
+ */
+void *led_panel_alloc(size_t bytes, led_mem_t where, const char *what);
 
+#define LED_ROW_OVER_BUCKETS   7
+#define LED_ROW_OVER_LIMITS    { 1, 2, 5, 10, 20, 50 }   // µs, bucket i < limit i; the last is the rest
+#define LED_ROW_OVER_TRACE_US  10                        // rows over this are also trace instants
 
+typedef struct {
+    uint32_t passes;           // refresh passes (all planes once)
+    uint32_t rows;             // rows staged by the prefetch
+    uint64_t fb_bytes;         // framebuffer bytes read by the prefetch
+    uint64_t prefetch_us;      // time spent staging rows (overlaps the OE on-time)
+    uint32_t prefetch_max_us;
+    uint32_t late;             // rows whose prefetch outlasted their on-time: reads limit the refresh rate
+    uint32_t internal_bytes;   // placed by led_panel_alloc
+    uint32_t psram_bytes;
+    uint32_t flash_writes;     // flash writes the refresh was handed over for
+    uint32_t flash_blanked;    // of those, shown blank (no timer scan for this frame)
+    uint32_t flash_gap_max_us; // longest time between two lit rows across a flash write
+    uint32_t flash_gap_last_us;
+    // How far lit rows ran past their slice, measured when the busy wait ends. An
+    // interrupt on the refresh core shows up here as a row lit too long.
+    uint32_t row_over_max_us;
+    uint32_t row_over_hist[LED_ROW_OVER_BUCKETS];   // rows by overrun, see LED_ROW_OVER_LIMITS
+    // Scan fast paths (SCAN_FAST_PATHS)
+    uint32_t fast_passes;      // passes shown from a plan of the frame
+    uint32_t rows_skipped;     // plane rows not shifted: black
+    uint32_t rows_merged;      // plane rows shifted along with a lower plane
+    uint32_t plans;            // frames planned
+    uint64_t plan_us;          // time spent planning (overlaps the OE on-time)
+    uint32_t idle_waits;       // ticks waited on a black frame
+    uint32_t pass_us;          // last pass
+    uint32_t pass_full_us;     // the same pass scanning every row, from its shift time
+    uint32_t shift_ns;         // per shifted row in the last pass, loop overhead included
+    uint16_t duty_scale;       // OE duty of the last pass, /256
+    // Refresh rate governor (REFRESH_TARGET_HZ)
+    uint16_t target_hz;        // grid of the last pass, 0 = free-running
+    uint16_t target_repeat;    // passes per target period
+    uint32_t slice_ns;         // BASE_US slice as stretched to fill the period
+    uint32_t target_unmet;     // passes that did not fit even with REFRESH_MIN_SLICE_US slices
+    uint32_t target_late;      // passes that ended after their place on the grid
+    uint64_t blank_us;         // OE off at pass ends to stay on the grid
+} led_refresh_stats_t;
+
+/**
+ * @brief Framebuffer read bandwidth = fb_bytes / prefetch_us (bytes per µs = MB/s)
+ */
+void led_panel_get_refresh_stats(led_refresh_stats_t *out);
+
+/**
+ * @brief Refresh rate target, 0 = free-running. ESP_ERR_INVALID_SIZE (and a warning) when
+ * a full scan cannot fit its period; it is set anyway and the misses are counted.
+ * Blocks until refresh_task has measured a pass (the reach depends on it);
+ * ESP_ERR_TIMEOUT if none within REFRESH_MEASURE_WAIT_MS, the target set unchecked.
+ */
+esp_err_t led_panel_set_refresh_target(uint16_t hz);
+
+/**
+ * @brief Highest target a full scan of this geometry and depth can meet, from the measured
+ * shift time; 0 before refresh_task has run a pass
+ */
+uint32_t led_panel_max_refresh_hz(void);
+
+/**
+ * @brief Start the row overrun max and histogram over (from the next refresh pass)
+ */
+void led_panel_reset_row_overrun(void);
+
+/**
+ * @brief Around a flash write (settings_flash_guard_t): refresh_task parks and
+ * the timer ISR scans the staged frame until led_panel_flash_end()
+ */
+void led_panel_flash_begin(void);
+void led_panel_flash_end(void);
+
+esp_err_t init_planes(void);
+void draw_bitmap_rgb(int x0, int y0, const uint32_t *bmp, int w, int h);
+void set_global_brightness_pct(uint8_t percent);
 
+void set_pixel(int x, int y, int r8, int g8, int b8);
 
-void save_mode(uint8_t value);
-uint8_t load_mode();
+// Plane offset of virtual pixel (x, y), the cell set_pixel writes. In range only.
+uint32_t led_panel_pixel_index(int x, int y);
 
 
-void save_format(uint8_t value);
-uint8_t load_format();
 
 
 
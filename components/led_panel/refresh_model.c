@@ -0,0 +1,99 @@
+#include <string.h>
+#include "refresh_model.h"
+#include "hub75_bits.h"
+#include "row_plan.h"
+
+bool refresh_grid_plan(uint32_t slots, uint32_t units, uint32_t shift16, uint32_t base_us,
+                       uint32_t target_hz, uint32_t *repeat, uint32_t *slice16)
+{
+    uint64_t budget = 16000000ull * (100 - REFRESH_MARGIN_PCT) / 100 / target_hz;
+    uint64_t shifts = (uint64_t)slots * shift16;
+    uint64_t pass = shifts + 16ull * units * base_us;
+
+    if (shifts + 16ull * units * REFRESH_MIN_SLICE_US > budget) {
+        *repeat = 1;
+        *slice16 = 16 * REFRESH_MIN_SLICE_US;
+        return false;
+    }
+    uint32_t k = budget >= pass ? (uint32_t)(budget / pass) : 1;
+    if (*repeat > k && budget / *repeat >= shifts + 14ull * units * base_us) k = *repeat;
+    *repeat = k;
+    *slice16 = (uint32_t)((budget / k - shifts) / units);
+    return true;
+}
+
+uint16_t refresh_duty_scale(uint64_t period16, uint32_t slice16, uint32_t shift16, uint32_t base_us,
+                            uint32_t full_slots, uint32_t full_units)
+{
+    uint64_t full16 = (uint64_t)full_slots * shift16 + 16ull * full_units * base_us;
+    uint64_t scale = 256 * 16ull * base_us * period16 / (full16 * slice16);
+    return scale > 256 ? 256 : (uint16_t)scale;
+}
+
+uint32_t refresh_max_hz(uint32_t full_slots, uint32_t full_units, uint32_t shift16)
+{
+    uint64_t pass16 = (uint64_t)full_slots * shift16 + 16ull * full_units * REFRESH_MIN_SLICE_US;
+    return (uint32_t)(16000000ull * (100 - REFRESH_MARGIN_PCT) / 100 / pass16);
+}
+
+int refresh_model_plan(const uint8_t *const *planes, int depth, int rows, uint32_t stride,
+                       const uint32_t *col_off, int cols, int chains, uint32_t chain_off,
+                       uint32_t lower_off, bool fast, uint8_t *stage, uint8_t *units)
+{
+    const size_t len = (size_t)cols * chains;
+    uint8_t row_units[8];
+    int shifted = 0;
+
+    for (int row = 0; row < rows; row++) {
+        for (int p = 0; p < depth; p++) {
+            hub75_stage_row(stage + p * len, planes[p] + row * stride, col_off, cols, chains,
+                            chain_off, lower_off);
+            row_units[p] = (uint8_t)(1 << p);
+        }
+        if (fast) row_plan_units(stage, depth, len, row_units);
+        for (int p = 0; p < depth; p++) {
+            units[p * rows + row] = row_units[p];
+            if (row_units[p]) shifted++;
+        }
+    }
+    return shifted;
+}
+
+void refresh_model_pass(const uint8_t *units, int n, uint32_t shift_ns, uint32_t stage_ns,
+                        uint32_t base_us, uint32_t target_hz, refresh_pass_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    for (int i = 0; i < n; i++) {
+        if (!units[i]) continue;
+        out->slots++;
+        out->units += units[i];
+    }
+    out->repeat = 1;
+    if (!out->slots) return;
+
+    uint32_t shift16 = shift_ns * 16 / 1000;
+    uint32_t slice16 = 16 * base_us;
+    if (target_hz) {
+        out->repeat = 0;
+        out->unmet = !refresh_grid_plan(out->slots, out->units, shift16, base_us, target_hz,
+                                        &out->repeat, &slice16);
+    }
+    out->slice_ns = slice16 * 1000 / 16;
+
+    // The busy wait ends at the slice's end or when the next row is staged
+    uint64_t pass = 0;
+    for (int i = 0; i < n; i++) {
+        if (!units[i]) continue;
+        uint32_t lit = units[i] * out->slice_ns;
+        if (stage_ns > lit) out->late++;
+        pass += shift_ns + (stage_ns > lit ? stage_ns : lit);
+    }
+    out->busy_ns = out->slots * (shift_ns + stage_ns);
+
+    if (target_hz) {
+        uint64_t period = 1000000000ull / ((uint64_t)target_hz * out->repeat);
+        if (pass > period) out->unmet = true;
+        else               pass = period;
+    }
+    out->pass_ns = (uint32_t)pass;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Refresh pass arithmetic, no IDF dependencies (builds on the host).
+//
+// refresh_task lays out its passes with the first three (governor grid, OE
+// duty for a pass length). The rest is a model of its loop for walls that do
+// not exist yet: tools/capacity_plan.py builds this file with scan_pattern.c,
+// hub75_bits.h and row_plan.c, so a prediction uses the same scan maps, row
+// gather, fast-path plans and grid as the firmware, with loop costs measured
+// on a device ("#M timing" monitor line).
+//
+// Times with a 16 suffix are in 1/16 µs.
+
+// ------------ CONFIG: refresh rate governor limits ------------
+#define REFRESH_MIN_SLICE_US     8     // shortest slice before a target counts as unmet
+#define REFRESH_MARGIN_PCT       3     // of each period, kept blank for shift time jitter
+
+/**
+ * @brief Passes per target period and the slice filling them: whole passes with slices
+ * of at least base_us, stretched over the rest. repeat: in the count in use, kept while
+ * its slices stay within 1/8 of base_us (no flapping on shift time jitter), out the new.
+ * @return false if one pass does not fit even with REFRESH_MIN_SLICE_US slices (those are
+ * returned, repeat 1)
+ */
+bool refresh_grid_plan(uint32_t slots, uint32_t units, uint32_t shift16, uint32_t base_us,
+                       uint32_t target_hz, uint32_t *repeat, uint32_t *slice16);
+
+/**
+ * @brief OE duty (/256) that lights a pass lasting period16 with slice16 per unit as
+ * bright as a free-running full scan (full_slots rows, full_units slices of base_us)
+ */
+uint16_t refresh_duty_scale(uint64_t period16, uint32_t slice16, uint32_t shift16, uint32_t base_us,
+                            uint32_t full_slots, uint32_t full_units);
+
+/**
+ * @brief Highest target a full scan meets with REFRESH_MIN_SLICE_US slices
+ */
+uint32_t refresh_max_hz(uint32_t full_slots, uint32_t full_units, uint32_t shift16);
+
+/**
+ * @brief BASE_US slices per plane row of a frame, [plane * rows + row], as refresh_task
+ * plans it (fast = SCAN_FAST_PATHS) or 1 << plane for every row
+ * @param planes  depth flat planes, rows addressed as in refresh_task (stride bytes each)
+ * @param col_off per shifted column, offset of its upper pixel (scan_build_map)
+ * @param stage   depth * cols * chains bytes of scratch
+ * @return rows shifted per pass
+ */
+int refresh_model_plan(const uint8_t *const *planes, int depth, int rows, uint32_t stride,
+                       const uint32_t *col_off, int cols, int chains, uint32_t chain_off,
+                       uint32_t lower_off, bool fast, uint8_t *stage, uint8_t *units);
+
+typedef struct {
+    uint32_t slots;          // rows shifted per pass
+    uint32_t units;          // slices lit per pass
+    uint32_t repeat;         // passes per target period, 1 free-running
+    uint32_t slice_ns;
+    uint32_t pass_ns;        // start to start
+    uint32_t busy_ns;        // of which shifting and staging, the rest is busy waiting
+    uint32_t late;           // slots whose staging outlasts their slice
+    bool unmet;              // the target does not fit
+} refresh_pass_t;
+
+/**
+ * @brief One pass as refresh_task runs it: per slot the shift, then the slice or the
+ * staging of the next row, whichever is longer; with a target, on its grid
+ * @param units  per plane row (refresh_model_plan), 0 = not shifted
+ */
+void refresh_model_pass(const uint8_t *units, int n, uint32_t shift_ns, uint32_t stage_ns,
+                        uint32_t base_us, uint32_t target_hz, refresh_pass_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,59 @@
+#include "rgb_canvas.h"
+#include "esp_timer.h"
+
+#define CANVAS_PIXELS   PLANE_BYTES
+
+static canvas_luts_t luts;
+static void *canvas = NULL;
+static canvas_format_t canvas_fmt = CANVAS_RGB565;
+static size_t canvas_bytes = 0;
+
+static rgb_canvas_stats_t stats;
+
+esp_err_t rgb_canvas_init(canvas_format_t fmt)
+{
+    if (canvas) return ESP_OK;
+
+    canvas_bytes = CANVAS_PIXELS * (fmt == CANVAS_RGB565 ? 2 : 3);
+    canvas = led_panel_alloc(canvas_bytes, LED_MEM_BULK, "RGB canvas");
+    if (!canvas) return ESP_ERR_NO_MEM;
+    canvas_fmt = fmt;
+
+    canvas_build_luts(&luts, gamma_table, COLOR_DEPTH);
+    memset(&stats, 0, sizeof(stats));
+    return ESP_OK;
+}
+
+bool rgb_canvas_begin(void)
+{
+    if (!canvas) return false;
+    memset(canvas, 0, canvas_bytes);
+    led_panel_set_canvas(canvas, canvas_fmt);
+    return true;
+}
+
+void rgb_canvas_end(void)
+{
+    led_panel_set_canvas(NULL, canvas_fmt);
+
+    uint8_t cover = 0;
+    uint8_t **planes = led_panel_target(&cover);
+
+    int64_t t0 = esp_timer_get_time();
+
+    if (canvas_fmt == CANVAS_RGB565) {
+        canvas_convert_rgb565(&luts, canvas, CANVAS_PIXELS, planes, COLOR_DEPTH, cover);
+    } else {
+        canvas_convert_rgb888(&luts, canvas, CANVAS_PIXELS, planes, COLOR_DEPTH, cover);
+    }
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    stats.converts++;
+    stats.last_us = us;
+    if (us > stats.max_us) stats.max_us = us;
+}
+
+void rgb_canvas_get_stats(rgb_canvas_stats_t *out)
+{
+    *out = stats;
+}
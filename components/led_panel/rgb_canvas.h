@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "led_panel.h"
+#include "canvas_convert.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// "Draw in RGB, convert at swap": between begin and end set_pixel only stores the
+// colour in a compact canvas; end converts the whole canvas into the current plane
+// target (back buffer or a compositor layer) with the SWAR kernel.
+
+#if COLOR_DEPTH > CANVAS_MAX_DEPTH
+#error "canvas converter packs at most CANVAS_MAX_DEPTH planes per word"
+#endif
+
+typedef struct {
+    uint32_t converts;
+    uint32_t last_us;        // conversion time of the last frame
+    uint32_t max_us;
+} rgb_canvas_stats_t;
+
+/**
+ * @brief Allocate the canvas (RGB565: 4 KB, RGB888: 6 KB at 64x32) and build the LUTs
+ */
+esp_err_t rgb_canvas_init(canvas_format_t fmt);
+
+/**
+ * @brief Clear the canvas and point set_pixel at it
+ * @return false if rgb_canvas_init() did not succeed
+ */
+bool rgb_canvas_begin(void);
+
+/**
+ * @brief Convert the canvas into the plane target that was active at begin, restore set_pixel.
+ * Non-black pixels get that target's cover bit.
+ */
+void rgb_canvas_end(void);
+
+void rgb_canvas_get_stats(rgb_canvas_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+#include <string.h>
+#include "row_plan.h"
+
+static int all_zero(const uint8_t *p, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (p[i]) return 0;
+    }
+    return 1;
+}
+
+void row_plan_units(const uint8_t *staged, int depth, size_t len, uint8_t *units)
+{
+    for (int p = 0; p < depth; p++) {
+        const uint8_t *row = staged + (size_t)p * len;
+        units[p] = 0;
+        if (all_zero(row, len)) continue;
+
+        // Into the lowest shown plane with the same bits, else shown on its own
+        int q = 0;
+        while (q < p && !(units[q] && memcmp(staged + (size_t)q * len, row, len) == 0)) q++;
+        units[q] += (uint8_t)(1 << p);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scan fast paths, no IDF dependencies (builds on the host).
+//
+// One address row is staged once per plane (hub75_lut_index bytes, so the
+// PIXEL_COVER bit never counts). A plane whose row is all zero is not shown:
+// no shift, no slice. A plane whose row equals the row of a lower plane is
+// folded into it: one shift, lit for both weights. Saturated colours
+// (gamma_table[255] = 7) set the same bit in every plane, so they collapse to
+// one shift per row; black rows cost nothing.
+
+/**
+ * @brief BASE_US slices to light each plane's row for, 0 = not shown.
+ * @param staged depth rows of len bytes, plane p at staged + p * len
+ * @param units  depth entries out; units[p] is 1 << p unless folded or empty
+ */
+void row_plan_units(const uint8_t *staged, int depth, size_t len, uint8_t *units);
+
+#ifdef __cplusplus
+}
+#endif
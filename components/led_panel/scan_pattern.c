@@ -0,0 +1,86 @@
+#include "scan_pattern.h"
+#include <stdio.h>
+#include <string.h>
+
+int scan_pattern_folded(scan_pattern_t *pat, int n, int h)
+{
+    int bits;
+    switch (n) {
+        case 8:  bits = 3; break;
+        case 16: bits = 4; break;
+        case 32: bits = 5; break;
+        default: return -1;
+    }
+    int runs = h / (2 * n);
+    if (runs < 1 || runs > SCAN_MAX_CHUNKS || h % (2 * n) != 0) return -1;
+
+    memset(pat, 0, sizeof(*pat));
+    snprintf(pat->name, sizeof(pat->name), "1/%d", n);
+    pat->addr_bits = (uint8_t)bits;
+    pat->addr_rows = (uint8_t)n;
+    pat->chunks = (uint8_t)runs;
+    pat->lower_offset = (uint8_t)(h / 2);
+    for (int c = 0; c < runs; c++) {
+        pat->chunk_y[c] = (int16_t)((runs - 1 - c) * n);
+    }
+    return 0;
+}
+
+int scan_validate(const scan_pattern_t *pat, int panel_width, int panel_height)
+{
+    if (pat->addr_bits > SCAN_MAX_ADDR_BITS) return -1;
+    if (pat->addr_rows == 0 || pat->addr_rows > (1 << pat->addr_bits)) return -1;
+    if (pat->chunks == 0 || pat->chunks > SCAN_MAX_CHUNKS) return -1;
+    if (panel_width <= 0) return -1;
+
+    // Every row of the panel must be driven exactly once per scan cycle
+    uint8_t hit[256] = { 0 };
+    if (panel_height > 256) return -1;
+    for (int row = 0; row < pat->addr_rows; row++) {
+        for (int c = 0; c < pat->chunks; c++) {
+            int y1 = row + pat->chunk_y[c];
+            int y2 = y1 + pat->lower_offset;
+            if (y1 < 0 || y2 >= panel_height) return -1;
+            hit[y1]++;
+            hit[y2]++;
+        }
+    }
+    for (int y = 0; y < panel_height; y++) {
+        if (hit[y] != 1) return -1;
+    }
+    return 0;
+}
+
+int scan_build_map(const scan_pattern_t *pat, int panel_width, int panel_height, int panels,
+                   scan_col_t *map, int map_len)
+{
+    if (scan_validate(pat, panel_width, panel_height) != 0) return -1;
+
+    int cols = panels * pat->chunks * panel_width;
+    if (cols > map_len) return -1;
+
+    // Chain order: all runs of panel 0, then panel 1, ...
+    int i = 0;
+    for (int p = 0; p < panels; p++) {
+        for (int c = 0; c < pat->chunks; c++) {
+            for (int x = 0; x < panel_width; x++, i++) {
+                map[i].fb_x = (uint16_t)(p * panel_width + x);
+                map[i].y_offset = (uint8_t)pat->chunk_y[c];
+            }
+        }
+    }
+    return cols;
+}
+
+void scan_build_addr(const scan_pattern_t *pat, const uint32_t line_bits[SCAN_MAX_ADDR_BITS],
+                     uint32_t *set, uint32_t *clr)
+{
+    for (int row = 0; row < pat->addr_rows; row++) {
+        uint32_t s = 0, c = 0;
+        for (int b = 0; b < pat->addr_bits; b++) {
+            if ((row >> b) & 1) s |= line_bits[b]; else c |= line_bits[b];
+        }
+        set[row] = s;
+        clr[row] = c;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// HUB75 scan-pattern descriptor, no IDF dependencies (builds on the host).
+//
+// Per row address the panel shifts `chunks` runs of a full panel width per
+// physical panel. Chunk c drives framebuffer row (address + chunk_y[c]) on
+// R1/G1/B1 and that row + lower_offset on R2/G2/B2.
+//
+//   scan 1/8,  64x32:  8 addresses A-C,  2 chunks folded { 8, 0 }, lower 16
+//   scan 1/16, 64x32: 16 addresses A-D,  1 chunk,                  lower 16
+//   scan 1/32, 64x64: 32 addresses A-E,  1 chunk,                  lower 32
+
+#define SCAN_MAX_CHUNKS      4
+#define SCAN_MAX_ADDR_BITS   5     // A B C D E
+
+typedef struct {
+    char name[6];                        // "1/16"
+    uint8_t addr_bits;                   // address lines used
+    uint8_t addr_rows;                   // row addresses per scan cycle
+    uint8_t chunks;                      // column runs per panel per address
+    uint8_t lower_offset;                // rows between R1 and R2 data
+    int16_t chunk_y[SCAN_MAX_CHUNKS];    // row offset of each run, in shift order
+} scan_pattern_t;
+
+// One shifted column: where its pixels come from
+typedef struct {
+    uint16_t fb_x;      // framebuffer column
+    uint8_t  y_offset;  // chunk_y of its run
+} scan_col_t;
+
+/**
+ * @brief 1/n scan on an h-row panel, runs folded top to bottom in reverse shift
+ * order (the layout refresh_task always used for 64x32 1/8 panels)
+ * @return 0, or -1 if n is not 8, 16 or 32 or h is not 2, 4, 6 or 8 times n
+ */
+int scan_pattern_folded(scan_pattern_t *pat, int n, int h);
+
+/**
+ * @brief Check a pattern against the panel size
+ * @return 0 if usable, -1 otherwise
+ */
+int scan_validate(const scan_pattern_t *pat, int panel_width, int panel_height);
+
+/**
+ * @brief Fill the per-address shift order for `panels` chained panels
+ * @return columns shifted per address, or -1 if map is too small / pattern invalid
+ */
+int scan_build_map(const scan_pattern_t *pat, int panel_width, int panel_height, int panels,
+                   scan_col_t *map, int map_len);
+
+/**
+ * @brief GPIO set/clear words selecting each row address
+ * @param line_bits output bit of address line A, B, C, D, E (0 for unused lines)
+ */
+void scan_build_addr(const scan_pattern_t *pat, const uint32_t line_bits[SCAN_MAX_ADDR_BITS],
+                     uint32_t *set, uint32_t *clr);
+
+#ifdef __cplusplus
+}
+#endif
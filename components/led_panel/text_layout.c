@@ -0,0 +1,35 @@
+#include "text_layout.h"
+#include "glyph_map.h"
+#include <string.h>
+
+void text_layout_set(text_layout_t *l, uint32_t key, const char *text, int advance,
+                     text_align_t align, int box_x, int box_w)
+{
+    // Whole UTF-8 sequences only, so the copy never ends mid-character
+    const char *p = text;
+    int n = 0;
+    while (*p && n < TEXT_LAYOUT_MAX - 1) {
+        const char *start = p;
+        uint32_t cp = utf8_next(&p);
+        if (p - text > TEXT_LAYOUT_MAX - 1) {
+            p = start;
+            break;
+        }
+        l->glyph[n++] = glyph_lookup(cp);
+    }
+    memcpy(l->text, text, p - text);
+    l->text[p - text] = '\0';
+    l->len = (uint8_t)n;
+
+    // The draw_text_* helpers put one pixel of spacing after every glyph
+    l->width = n ? (int16_t)(n * advance - 1) : 0;
+
+    switch (align) {
+        case TEXT_ALIGN_CENTER: l->x = (int16_t)(box_x + (box_w - l->width) / 2); break;
+        case TEXT_ALIGN_RIGHT:  l->x = (int16_t)(box_x + box_w - l->width);       break;
+        default:                l->x = (int16_t)box_x;                             break;
+    }
+
+    l->key = key;
+    l->valid = true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Layout cache for formatted strings, no IDF dependencies (builds on the host).
+//
+// A scene packs whatever its string depends on (minute, day, temperature, clock
+// format, ...) into a key. While the key is unchanged the formatted text, its
+// glyph indices, width and aligned x are reused; snprintf and the measuring only
+// run when text_layout_stale() says so.
+
+#define TEXT_LAYOUT_MAX   64     // characters, including the terminator
+
+typedef enum {
+    TEXT_ALIGN_LEFT = 0,
+    TEXT_ALIGN_CENTER,
+    TEXT_ALIGN_RIGHT,
+} text_align_t;
+
+typedef struct {
+    uint32_t key;
+    bool valid;
+    uint8_t len;                      // glyphs (UTF-8 characters), not bytes
+    char text[TEXT_LAYOUT_MAX];       // UTF-8
+    uint8_t glyph[TEXT_LAYOUT_MAX];   // draw_text font index per character (glyph_map.h)
+    int16_t width;                    // pixels, without the spacing after the last glyph
+    int16_t x;                        // left edge for the requested alignment
+} text_layout_t;
+
+static inline bool text_layout_stale(const text_layout_t *l, uint32_t key)
+{
+    return !l->valid || l->key != key;
+}
+
+/**
+ * @brief Store text for key and measure it. advance = glyph width + spacing;
+ * the text is aligned inside [box_x, box_x + box_w). Longer text is truncated.
+ */
+void text_layout_set(text_layout_t *l, uint32_t key, const char *text, int advance,
+                     text_align_t align, int box_x, int box_w);
+
+/**
+ * @brief Forget the cached text (next text_layout_stale() is true)
+ */
+static inline void text_layout_reset(text_layout_t *l)
+{
+    l->valid = false;
+}
+
+#ifdef __cplusplus
+}
+#endif
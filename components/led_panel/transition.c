@@ -0,0 +1,166 @@
+#include "transition.h"
+#include <string.h>
+
+#define RANK_LEVELS   128           // 7-bit ranks: byte sums below never carry
+#define WORD_HI       0x80808080u
+
+void transition_build_ranks(uint8_t *rank, int n, uint32_t seed)
+{
+    uint32_t s = seed ? seed : 0x9E3779B9u;
+    for (int i = 0; i < n; i++) {
+        rank[i] = (uint8_t)(i % RANK_LEVELS);
+    }
+    // Fisher-Yates, so every rank is used equally often
+    for (int i = n - 1; i > 0; i--) {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        int j = (int)(s % (uint32_t)(i + 1));
+        uint8_t t = rank[i];
+        rank[i] = rank[j];
+        rank[j] = t;
+    }
+}
+
+static void slide(const transition_geom_t *g, int shift, uint8_t *const from[], uint8_t *const to[])
+{
+    const int w = g->width;
+    for (int p = 0; p < g->depth; p++) {
+        for (int y = 0; y < g->height; y++) {
+            uint8_t *dst = to[p] + y * w;
+            memmove(dst + (w - shift), dst, shift);              // new scene enters on the right
+            memcpy(dst, from[p] + y * w + shift, w - shift);     // old scene leaves on the left
+        }
+    }
+}
+
+bool transition_build_rows(transition_rows_t *rows, int stride, uint32_t (*offset)(int x, int y))
+{
+    const int segs = rows->width / rows->seg_width;
+    bool identity = rows->width == stride;
+    uint32_t *seg = (uint32_t *)rows->seg;
+
+    for (int y = 0; y < rows->height; y++) {
+        for (int s = 0; s < segs; s++) {
+            uint32_t off = offset(s * rows->seg_width, y);
+            seg[y * segs + s] = off;
+            identity = identity && off == (uint32_t)(y * stride + s * rows->seg_width);
+        }
+    }
+    return !identity;
+}
+
+// Virtual row y of plane into line (n pixels from the left), and back
+static void row_get(const transition_rows_t *r, const uint8_t *plane, int y, uint8_t *line, int n)
+{
+    const int segs = r->width / r->seg_width;
+    const uint32_t *seg = r->seg + y * segs;
+    for (int s = 0; n > 0; s++, line += r->seg_width, n -= r->seg_width) {
+        memcpy(line, plane + seg[s], n < r->seg_width ? n : r->seg_width);
+    }
+}
+
+static void row_put(const transition_rows_t *r, uint8_t *plane, int y, const uint8_t *line)
+{
+    const int segs = r->width / r->seg_width;
+    const uint32_t *seg = r->seg + y * segs;
+    for (int s = 0; s < segs; s++, line += r->seg_width) {
+        memcpy(plane + seg[s], line, r->seg_width);
+    }
+}
+
+// SLIDE on a segmented wall: old row from shift on, then the new row's left part
+static void slide_rows(const transition_geom_t *g, int shift, uint8_t *const from[], uint8_t *const to[])
+{
+    const transition_rows_t *r = g->rows;
+    for (int p = 0; p < g->depth; p++) {
+        for (int y = 0; y < r->height; y++) {
+            row_get(r, from[p], y, r->line, r->width);
+            row_get(r, to[p], y, r->line + r->width, shift);
+            row_put(r, to[p], y, r->line + shift);
+        }
+    }
+}
+
+// WIPE on a segmented wall: virtual rows from `rows` down keep the old scene
+static void wipe_rows(const transition_geom_t *g, int rows, uint8_t *const from[], uint8_t *const to[])
+{
+    const transition_rows_t *r = g->rows;
+    const int segs = r->width / r->seg_width;
+    for (int p = 0; p < g->depth; p++) {
+        for (int i = rows * segs; i < r->height * segs; i++) {
+            memcpy(to[p] + r->seg[i], from[p] + r->seg[i], r->seg_width);
+        }
+    }
+}
+
+static void wipe(const transition_geom_t *g, int rows, uint8_t *const from[], uint8_t *const to[])
+{
+    const size_t off = (size_t)rows * g->width;
+    const size_t bytes = (size_t)(g->height - rows) * g->width;
+    for (int p = 0; p < g->depth; p++) {
+        memcpy(to[p] + off, from[p] + off, bytes);
+    }
+}
+
+static void dissolve(const transition_geom_t *g, int level, uint8_t *const from[], uint8_t *const to[])
+{
+    // Per byte, rank + (128 - level) has bit 7 set exactly when rank >= level
+    const uint32_t bias = (uint32_t)(RANK_LEVELS - level) * 0x01010101u;
+    const int words = g->width * g->height / 4;
+    const uint32_t *rank = (const uint32_t *)g->rank;
+
+    for (int p = 0; p < g->depth; p++) {
+        const uint32_t *src = (const uint32_t *)from[p];
+        uint32_t *dst = (uint32_t *)to[p];
+        for (int i = 0; i < words; i++) {
+            uint32_t keep_old = (((rank[i] + bias) & WORD_HI) >> 7) * 0xFFu;
+            dst[i] = (dst[i] & ~keep_old) | (src[i] & keep_old);
+        }
+    }
+}
+
+// Plane p shows plane p + shift (dimming by powers of two); shifted past the
+// last plane is black
+static void dim(const transition_geom_t *g, int shift, uint8_t *const src[], uint8_t *const to[])
+{
+    const size_t bytes = (size_t)g->width * g->height;
+    for (int p = 0; p < g->depth; p++) {
+        if (p + shift < g->depth) {
+            if (src[p + shift] != to[p]) memcpy(to[p], src[p + shift], bytes);
+        } else {
+            memset(to[p], 0, bytes);
+        }
+    }
+}
+
+void transition_apply(const transition_geom_t *g, transition_kind_t kind, fx_t progress,
+                      uint8_t *const from[], uint8_t *const to[])
+{
+    if (progress >= FX_ONE) return;
+    if (progress < 0) progress = 0;
+
+    switch (kind) {
+        case TRANSITION_SLIDE:
+            if (g->rows) slide_rows(g, (int)(((int64_t)progress * g->rows->width) >> FX_SHIFT), from, to);
+            else         slide(g, (int)(((int64_t)progress * g->width) >> FX_SHIFT), from, to);
+            break;
+        case TRANSITION_WIPE:
+            if (g->rows) wipe_rows(g, (int)(((int64_t)progress * g->rows->height) >> FX_SHIFT), from, to);
+            else         wipe(g, (int)(((int64_t)progress * g->height) >> FX_SHIFT), from, to);
+            break;
+        case TRANSITION_DISSOLVE:
+            dissolve(g, (int)(((int64_t)progress * RANK_LEVELS) >> FX_SHIFT), from, to);
+            break;
+        case TRANSITION_FADE: {
+            // Old scene shifts 0..depth (black), then the new one depth-1..1
+            const int steps = 2 * g->depth;
+            int step = (int)(((int64_t)progress * steps) >> FX_SHIFT);
+            if (step <= g->depth) dim(g, step, from, to);
+            else                  dim(g, steps - step, to, to);
+            break;
+        }
+        default:
+            break;
+    }
+}
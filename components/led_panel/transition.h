@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "anim_clock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scene transitions evaluated on plane buffers, no IDF dependencies (builds on
+// the host). The incoming scene's planes are rewritten in place into the frame
+// for a given progress (0 .. FX_ONE), working a whole row or word at a time:
+//
+//   SLIDE     new scene pushes the old one out to the left (row moves)
+//   WIPE      new scene uncovers from the top (row copies)
+//   DISSOLVE  pixels switch in a fixed random order (4 pixels per word, SWAR)
+//   FADE      old scene dims out, new one dims in, by plane shifts
+//
+// Every kind touches each plane byte at most twice (slide on a segmented wall:
+// three times, through a row buffer), whatever the progress, so the cost per
+// frame is fixed by the plane size.
+// Slide and wipe move virtual rows. When the planes are the screen row for row
+// (one panel row on one chain) those are plane rows; otherwise every virtual row
+// is a list of panel-wide segments (transition_rows_t) and they follow it.
+
+typedef enum {
+    TRANSITION_NONE = 0,
+    TRANSITION_SLIDE,
+    TRANSITION_WIPE,
+    TRANSITION_DISSOLVE,
+    TRANSITION_FADE,
+    TRANSITION_KINDS
+} transition_kind_t;
+
+// Virtual rows of a wall whose planes are not laid out like the screen
+typedef struct {
+    int width, height;      // virtual size in pixels
+    int seg_width;          // pixels per segment (the panel width)
+    const uint32_t *seg;    // plane offset of each segment, row by row, width / seg_width per row
+    uint8_t *line;          // 2 * width bytes of scratch for SLIDE
+} transition_rows_t;
+
+typedef struct {
+    int width;              // row stride in pixels, multiple of 4
+    int height;
+    int depth;              // planes
+    const uint8_t *rank;    // DISSOLVE order, width * height bytes of 0..127 (word aligned)
+    const transition_rows_t *rows;   // NULL = plane rows are the virtual rows
+} transition_geom_t;
+
+/**
+ * @brief Fill rank[n] with a shuffled 0..127 order per pixel (xorshift from seed)
+ */
+void transition_build_ranks(uint8_t *rank, int n, uint32_t seed);
+
+/**
+ * @brief Segment table for rows: offset(x, y) is the plane offset of virtual
+ * pixel (x, y). Returns false when every virtual row is already the plane row
+ * y (no table needed, pass rows = NULL).
+ */
+bool transition_build_rows(transition_rows_t *rows, int stride, uint32_t (*offset)(int x, int y));
+
+/**
+ * @brief to[] = the frame at progress between from[] (outgoing) and to[] (incoming).
+ * Planes word aligned; progress FX_ONE leaves to[] unchanged.
+ */
+void transition_apply(const transition_geom_t *g, transition_kind_t kind, fx_t progress,
+                      uint8_t *const from[], uint8_t *const to[]);
+
+#ifdef __cplusplus
+}
+#endif
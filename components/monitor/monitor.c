@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <string.h>
+#include "monitor.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "MONITOR";
+
+#define STATUS_MAX   (MONITOR_MAX_TASKS + 8)
+
+// A task keeps its slot (by handle) so samples and minutes line up
+typedef struct {
+    TaskHandle_t handle;
+    char name[configMAX_TASK_NAME_LEN];
+    int8_t core;
+    uint32_t last_runtime;
+} slot_t;
+
+typedef struct {
+    uint32_t window_us;
+    uint32_t busy_us[MONITOR_MAX_TASKS];
+    uint16_t max_permille[MONITOR_MAX_TASKS];
+    monitor_wake_stats_t wake[MONITOR_WAKES];
+} record_t;
+
+static const char *const wake_names[MONITOR_WAKES] = {
+    [MONITOR_WAKE_DRAW] = "draw",
+    [MONITOR_WAKE_TEMP] = "temp",
+    [MONITOR_WAKE_MENU] = "menu",
+    [MONITOR_WAKE_INPUT] = "input",
+};
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static slot_t slots[MONITOR_MAX_TASKS];
+static int n_slots = 0;
+
+static monitor_wake_stats_t wake_acc[MONITOR_WAKES];   // since the last sample
+static record_t last_sample;
+static record_t minute_acc;
+static record_t minutes[MONITOR_MINUTES];
+static int minute_head = 0;     // next record to write
+static int minute_count = 0;
+
+static void merge(record_t *dst, const record_t *src)
+{
+    dst->window_us += src->window_us;
+    for (int s = 0; s < MONITOR_MAX_TASKS; s++) {
+        dst->busy_us[s] += src->busy_us[s];
+        if (src->max_permille[s] > dst->max_permille[s]) dst->max_permille[s] = src->max_permille[s];
+    }
+    for (int w = 0; w < MONITOR_WAKES; w++) {
+        dst->wake[w].wakeups += src->wake[w].wakeups;
+        dst->wake[w].late_sum_us += src->wake[w].late_sum_us;
+        if (src->wake[w].late_max_us > dst->wake[w].late_max_us)
+            dst->wake[w].late_max_us = src->wake[w].late_max_us;
+        if (src->wake[w].wakeups) dst->wake[w].late_last_us = src->wake[w].late_last_us;
+    }
+}
+
+static void to_window(const record_t *r, monitor_window_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->window_ms = r->window_us / 1000;
+    out->tasks = n_slots;
+    for (int s = 0; s < n_slots; s++) {
+        monitor_task_stats_t *t = &out->task[s];
+        memcpy(t->name, slots[s].name, sizeof(t->name));
+        t->core = slots[s].core;
+        t->cpu_permille = r->window_us ? (uint16_t)((uint64_t)r->busy_us[s] * 1000 / r->window_us) : 0;
+        t->cpu_max_permille = r->max_permille[s];
+    }
+    memcpy(out->wake, r->wake, sizeof(out->wake));
+}
+
+void monitor_wake(monitor_wake_t src, int64_t due_us)
+{
+    int64_t late = esp_timer_get_time() - due_us;
+    if (late < 0) late = 0;
+
+    portENTER_CRITICAL(&lock);
+    monitor_wake_stats_t *w = &wake_acc[src];
+    w->wakeups++;
+    w->late_sum_us += (uint64_t)late;
+    if (late > w->late_max_us) w->late_max_us = (uint32_t)late;
+    w->late_last_us = (uint32_t)late;
+    portEXIT_CRITICAL(&lock);
+}
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && CONFIG_FREERTOS_USE_TRACE_FACILITY
+
+static TaskStatus_t status[STATUS_MAX];
+static uint32_t last_total = 0;
+
+static int slot_for(const TaskStatus_t *t)
+{
+    for (int s = 0; s < n_slots; s++) {
+        if (slots[s].handle == t->xHandle) return s;
+    }
+    if (n_slots == MONITOR_MAX_TASKS) return -1;
+
+    slot_t *s = &slots[n_slots];
+    s->handle = t->xHandle;
+    snprintf(s->name, sizeof(s->name), "%s", t->pcTaskName);
+    BaseType_t core = xTaskGetCoreID(t->xHandle);
+    s->core = core == tskNO_AFFINITY ? -1 : (int8_t)core;
+    s->last_runtime = t->ulRunTimeCounter;   // counts from the next sample
+    return n_slots++;
+}
+
+static void take_sample(void)
+{
+    uint32_t total;
+    UBaseType_t n = uxTaskGetSystemState(status, STATUS_MAX, &total);
+    if (n == 0) {
+        ESP_LOGW(TAG, "More than %d tasks, sample skipped", STATUS_MAX);
+        return;
+    }
+
+    bool primed = last_total != 0;
+    record_t r = { .window_us = total - last_total };
+    last_total = total;
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        int s = slot_for(&status[i]);
+        if (s < 0) continue;
+        r.busy_us[s] += status[i].ulRunTimeCounter - slots[s].last_runtime;
+        slots[s].last_runtime = status[i].ulRunTimeCounter;
+    }
+    for (int s = 0; s < n_slots; s++) {
+        r.max_permille[s] = r.window_us ? (uint16_t)((uint64_t)r.busy_us[s] * 1000 / r.window_us) : 0;
+    }
+
+    portENTER_CRITICAL(&lock);
+    memcpy(r.wake, wake_acc, sizeof(r.wake));
+    memset(wake_acc, 0, sizeof(wake_acc));
+
+    if (primed) {
+        last_sample = r;
+        merge(&minute_acc, &r);
+        if (minute_acc.window_us >= 60 * 1000000u) {
+            minutes[minute_head] = minute_acc;
+            minute_head = (minute_head + 1) % MONITOR_MINUTES;
+            if (minute_count < MONITOR_MINUTES) minute_count++;
+            memset(&minute_acc, 0, sizeof(minute_acc));
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+static void console_write(const char *line, size_t len, void *arg)
+{
+    fwrite(line, 1, len, stdout);
+}
+
+static void monitor_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    const int report_samples = MONITOR_REPORT_S * 1000 / MONITOR_SAMPLE_MS;
+    int reports_in = report_samples;
+
+    while (1) {
+        take_sample();
+
+        if (MONITOR_REPORT_S && --reports_in <= 0) {
+            reports_in = report_samples;
+            monitor_report(1, console_write, NULL);
+        }
+
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(MONITOR_SAMPLE_MS));
+    }
+}
+
+esp_err_t monitor_start(void)
+{
+    take_sample();   // prime the counters
+    if (xTaskCreatePinnedToCore(monitor_task, "Monitor", 3072, NULL, 1, NULL, MONITOR_CORE) != pdPASS)
+        return ESP_ERR_NO_MEM;
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t monitor_start(void)
+{
+    ESP_LOGW(TAG, "Needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS and CONFIG_FREERTOS_USE_TRACE_FACILITY");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
+
+void monitor_get_sample(monitor_window_t *out)
+{
+    portENTER_CRITICAL(&lock);
+    record_t r = last_sample;
+    portEXIT_CRITICAL(&lock);
+    to_window(&r, out);
+}
+
+bool monitor_get_minutes(int minutes_back, monitor_window_t *out)
+{
+    record_t r;
+    memset(&r, 0, sizeof(r));
+
+    portENTER_CRITICAL(&lock);
+    int n = minutes_back < minute_count ? minutes_back : minute_count;
+    for (int i = 1; i <= n; i++) {
+        merge(&r, &minutes[(minute_head - i + MONITOR_MINUTES) % MONITOR_MINUTES]);
+    }
+    portEXIT_CRITICAL(&lock);
+
+    to_window(&r, out);
+    return n > 0;
+}
+
+static void write_window(const char *label, const monitor_window_t *w, monitor_write_t write, void *arg)
+{
+    char line[128];
+    int n = snprintf(line, sizeof(line), "#M %s %lu ms\n", label, (unsigned long)w->window_ms);
+    write(line, n, arg);
+
+    for (int s = 0; s < w->tasks; s++) {
+        const monitor_task_stats_t *t = &w->task[s];
+        n = snprintf(line, sizeof(line), "#M cpu  %-16s core %c %3u.%u%%  max %3u.%u%%\n", t->name,
+                     t->core < 0 ? '*' : '0' + t->core, t->cpu_permille / 10, t->cpu_permille % 10,
+                     t->cpu_max_permille / 10, t->cpu_max_permille % 10);
+        write(line, n, arg);
+    }
+
+    for (int i = 0; i < MONITOR_WAKES; i++) {
+        const monitor_wake_stats_t *k = &w->wake[i];
+        uint32_t per_s10 = w->window_ms ? (uint32_t)((uint64_t)k->wakeups * 10000 / w->window_ms) : 0;
+        uint32_t mean = k->wakeups ? (uint32_t)(k->late_sum_us / k->wakeups) : 0;
+        n = snprintf(line, sizeof(line), "#M wake %-6s %4lu.%lu/s  late mean %6lu us  max %6lu us  last %6lu us\n",
+                     wake_names[i], (unsigned long)(per_s10 / 10), (unsigned long)(per_s10 % 10),
+                     (unsigned long)mean, (unsigned long)k->late_max_us, (unsigned long)k->late_last_us);
+        write(line, n, arg);
+    }
+}
+
+void monitor_report(int minutes_back, monitor_write_t write, void *arg)
+{
+    monitor_window_t w;
+
+    monitor_get_sample(&w);
+    write_window("sample", &w, write, arg);
+
+    if (monitor_get_minutes(minutes_back, &w)) {
+        write_window("minutes", &w, write, arg);
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-task CPU use from the FreeRTOS run-time counters
+// (CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, esp_timer clock), and how late the
+// periodic tasks wake. A low priority task samples every MONITOR_SAMPLE_MS and
+// folds the samples into MONITOR_MINUTES rolling one-minute records.
+
+// ------------ CONFIG: monitor ------------
+#define MONITOR_SAMPLE_MS     1000
+#define MONITOR_MINUTES       15      // minute records kept
+#define MONITOR_MAX_TASKS     16      // tasks tracked, later ones are left out
+#define MONITOR_REPORT_S      0       // report on the console this often, 0 = only on request (the console is off: UART0 carries the stream)
+#define MONITOR_CORE          1       // sampler core (refresh_task owns core 0)
+
+// Periodic wakeups whose lateness is measured
+typedef enum {
+    MONITOR_WAKE_DRAW = 0,    // drawing_task: next frame after the frame delay
+    MONITOR_WAKE_TEMP,        // temp_task: next conversion period
+    MONITOR_WAKE_MENU,        // menu_task: button event -> task running
+    MONITOR_WAKE_INPUT,       // button event -> frame showing its effect swapped in
+    MONITOR_WAKES
+} monitor_wake_t;
+
+typedef struct {
+    uint32_t wakeups;
+    uint32_t late_max_us;
+    uint32_t late_last_us;
+    uint64_t late_sum_us;
+} monitor_wake_stats_t;
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    int8_t core;              // -1 = either core
+    uint16_t cpu_permille;    // share of one core over the window
+    uint16_t cpu_max_permille;  // worst sample in the window
+} monitor_task_stats_t;
+
+typedef struct {
+    uint32_t window_ms;
+    int tasks;
+    monitor_task_stats_t task[MONITOR_MAX_TASKS];
+    monitor_wake_stats_t wake[MONITOR_WAKES];
+} monitor_window_t;
+
+/**
+ * @brief Start the sampler task. ESP_ERR_NOT_SUPPORTED without run-time stats.
+ */
+esp_err_t monitor_start(void);
+
+/**
+ * @brief A periodic task runs at now, it was due at due_us (esp_timer time)
+ */
+void monitor_wake(monitor_wake_t src, int64_t due_us);
+
+/**
+ * @brief The last MONITOR_SAMPLE_MS sample
+ */
+void monitor_get_sample(monitor_window_t *out);
+
+/**
+ * @brief The last `minutes` complete minutes merged (clamped to what is recorded)
+ * @return false if no minute has completed yet
+ */
+bool monitor_get_minutes(int minutes, monitor_window_t *out);
+
+typedef void (*monitor_write_t)(const char *line, size_t len, void *arg);
+
+/**
+ * @brief Write the last sample and the last `minutes` minutes as "#M" text lines
+ */
+void monitor_report(int minutes, monitor_write_t write, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
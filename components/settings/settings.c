@@ -0,0 +1,290 @@
+#include "settings.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_log.h"
+
+#define SETTINGS_NAMESPACE  "settings"
+#define SETTINGS_BLOB_KEY   "cfg"
+
+static const char *TAG = "SETTINGS";
+
+// Stored layout: header first so older/newer firmware can recognize the blob
+typedef struct {
+    uint16_t version;
+    uint16_t size;
+    settings_t data;
+} settings_blob_t;
+
+static const settings_t defaults = {
+    .brightness = 10,
+    .mode       = 4,
+    .format     = 0,
+};
+
+static settings_t current;        // in-RAM copy, what settings_get returns
+static settings_t stored;         // what flash holds, to skip identical writes
+static bool dirty = false;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static SemaphoreHandle_t write_mutex = NULL;
+static TaskHandle_t commit_task = NULL;
+static const settings_backend_t *backend = NULL;
+static const settings_flash_guard_t *volatile flash_guard = NULL;
+static settings_stats_t stats;
+
+//--------------------------------------------NVS backend-------------------------------------------------------
+
+static esp_err_t nvs_load_blob(void *blob, size_t *len)
+{
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(SETTINGS_NAMESPACE, NVS_READONLY, &h);
+    if (err != ESP_OK) return ESP_ERR_NOT_FOUND;
+
+    err = nvs_get_blob(h, SETTINGS_BLOB_KEY, blob, len);
+    nvs_close(h);
+
+    if (err == ESP_ERR_NVS_NOT_FOUND) return ESP_ERR_NOT_FOUND;
+    return err;
+}
+
+static esp_err_t nvs_save_blob(const void *blob, size_t len)
+{
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(SETTINGS_NAMESPACE, NVS_READWRITE, &h);
+    if (err != ESP_OK) return err;
+
+    err = nvs_set_blob(h, SETTINGS_BLOB_KEY, blob, len);
+    if (err == ESP_OK) err = nvs_commit(h);
+    nvs_close(h);
+    return err;
+}
+
+static esp_err_t nvs_load_legacy_u8(const char *key, uint8_t *value)
+{
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(SETTINGS_NAMESPACE, NVS_READONLY, &h);
+    if (err != ESP_OK) return err;
+
+    err = nvs_get_u8(h, key, value);
+    nvs_close(h);
+    return err;
+}
+
+static const settings_backend_t nvs_backend = {
+    .load_blob      = nvs_load_blob,
+    .save_blob      = nvs_save_blob,
+    .load_legacy_u8 = nvs_load_legacy_u8,
+};
+
+static esp_err_t init_nvs_flash(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ret = nvs_flash_erase();
+        if (ret == ESP_OK) ret = nvs_flash_init();
+    }
+    return ret;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+
+static void load_settings(void)
+{
+    settings_blob_t blob;
+    size_t len = sizeof(blob);
+
+    current = defaults;
+
+    esp_err_t err = backend->load_blob(&blob, &len);
+    if (err == ESP_OK && len >= offsetof(settings_blob_t, data) && blob.version == SETTINGS_VERSION) {
+        // A shorter blob from an older layout of the same version: new fields keep defaults
+        size_t n = len - offsetof(settings_blob_t, data);
+        if (n > blob.size) n = blob.size;
+        if (n > sizeof(settings_t)) n = sizeof(settings_t);
+        memcpy(&current, &blob.data, n);
+        stored = current;
+        return;
+    }
+
+    if (err == ESP_OK)
+        ESP_LOGW(TAG, "Settings blob v%u not understood, using defaults", blob.version);
+
+    // First boot with the blob format: pull the old per-key values once
+    if (backend->load_legacy_u8) {
+        backend->load_legacy_u8("brightness", &current.brightness);
+        backend->load_legacy_u8("mode", &current.mode);
+        backend->load_legacy_u8("format", &current.format);
+    }
+
+    // Force the first commit so the blob exists from now on
+    memset(&stored, 0xFF, sizeof(stored));
+    dirty = true;
+}
+
+static esp_err_t commit(void)
+{
+    xSemaphoreTake(write_mutex, portMAX_DELAY);
+
+    portENTER_CRITICAL(&lock);
+    settings_t snapshot = current;
+    dirty = false;
+    portEXIT_CRITICAL(&lock);
+
+    esp_err_t err = ESP_OK;
+
+    if (memcmp(&snapshot, &stored, sizeof(snapshot)) == 0) {
+        stats.skipped++;
+    } else {
+        settings_blob_t blob = {
+            .version = SETTINGS_VERSION,
+            .size    = sizeof(settings_t),
+            .data    = snapshot,
+        };
+
+        const settings_flash_guard_t *guard = flash_guard;
+        if (guard) guard->begin();
+        err = backend->save_blob(&blob, sizeof(blob));
+        if (guard) guard->end();
+        if (err == ESP_OK) {
+            stored = snapshot;
+            stats.commits++;
+        } else {
+            stats.failures++;
+            portENTER_CRITICAL(&lock);
+            dirty = true;   // retry on the next change or flush
+            portEXIT_CRITICAL(&lock);
+            ESP_LOGE(TAG, "Commit failed: %s", esp_err_to_name(err));
+        }
+    }
+
+    xSemaphoreGive(write_mutex);
+    return err;
+}
+
+// Sleeps until a setter wakes it, then waits for SETTINGS_COMMIT_DELAY_MS of quiet
+// (every further change restarts the wait) so a burst of menu presses is one write
+static void settings_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SETTINGS_COMMIT_DELAY_MS)) > 0) {
+        }
+
+        commit();
+    }
+}
+
+static void set_field(uint8_t *field, uint8_t value)
+{
+    portENTER_CRITICAL(&lock);
+    *field = value;
+    dirty = true;
+    portEXIT_CRITICAL(&lock);
+
+    if (commit_task) xTaskNotifyGive(commit_task);
+}
+
+esp_err_t settings_init(const settings_backend_t *custom)
+{
+    // Whatever fails below, settings_get() returns the defaults and the stats
+    // lock exists
+    current = defaults;
+    if (!write_mutex) write_mutex = xSemaphoreCreateMutex();
+    if (!write_mutex) return ESP_ERR_NO_MEM;
+
+    if (custom) {
+        backend = custom;
+    } else {
+        esp_err_t err = init_nvs_flash();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(err));
+            return err;
+        }
+        backend = &nvs_backend;
+    }
+
+    load_settings();
+
+    if (xTaskCreate(settings_task, "SettingsTask", 2048, NULL, 1, &commit_task) != pdPASS)
+        return ESP_ERR_NO_MEM;
+
+    if (dirty) xTaskNotifyGive(commit_task);
+
+    return ESP_OK;
+}
+
+void settings_set_flash_guard(const settings_flash_guard_t *guard)
+{
+    flash_guard = guard;
+}
+
+settings_t settings_get(void)
+{
+    portENTER_CRITICAL(&lock);
+    settings_t copy = current;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
+
+void settings_set_brightness(uint8_t level)
+{
+    set_field(&current.brightness, level);
+}
+
+void settings_set_mode(uint8_t mode)
+{
+    set_field(&current.mode, mode);
+}
+
+void settings_set_format(uint8_t format)
+{
+    set_field(&current.format, format);
+}
+
+void settings_set_geometry(uint8_t panel_width, uint8_t panel_height, uint8_t panel_scan,
+                           uint8_t n_hor, uint8_t n_ver)
+{
+    portENTER_CRITICAL(&lock);
+    current.panel_width  = panel_width;
+    current.panel_height = panel_height;
+    current.panel_scan   = panel_scan;
+    current.n_hor        = n_hor;
+    current.n_ver        = n_ver;
+    dirty = true;
+    portEXIT_CRITICAL(&lock);
+
+    if (commit_task) xTaskNotifyGive(commit_task);
+}
+
+void settings_set_refresh_hz(uint16_t hz)
+{
+    portENTER_CRITICAL(&lock);
+    current.refresh_hz = hz;
+    dirty = true;
+    portEXIT_CRITICAL(&lock);
+
+    if (commit_task) xTaskNotifyGive(commit_task);
+}
+
+esp_err_t settings_flush(void)
+{
+    if (!backend) return ESP_ERR_INVALID_STATE;
+    if (!dirty) return ESP_OK;
+    return commit();
+}
+
+void settings_get_stats(settings_stats_t *out)
+{
+    if (!write_mutex) {
+        *out = stats;
+        return;
+    }
+    xSemaphoreTake(write_mutex, portMAX_DELAY);
+    *out = stats;
+    xSemaphoreGive(write_mutex);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SETTINGS_VERSION          1
+#define SETTINGS_COMMIT_DELAY_MS  2000   // quiet time after the last change before writing flash
+
+// Everything the sign remembers across power cycles
+typedef struct {
+    uint8_t brightness;   // 1..10
+    uint8_t mode;         // display rotation mode
+    uint8_t format;       // 0 = 12h, 1 = 24h
+    // Installation geometry, read once at boot (0 = firmware default)
+    uint8_t panel_width;
+    uint8_t panel_height;
+    uint8_t panel_scan;   // row addresses: 8, 16 or 32
+    uint8_t n_hor;        // panels across
+    uint8_t n_ver;        // panels down
+    uint16_t refresh_hz;  // refresh rate target, read at boot (0 = firmware default)
+} settings_t;
+
+typedef struct {
+    uint32_t commits;     // blob writes that reached flash
+    uint32_t skipped;     // debounced windows that ended with nothing new to write
+    uint32_t failures;
+} settings_stats_t;
+
+// Storage backend. The default one is NVS; a fake can be passed to settings_init.
+typedef struct {
+    // Read the stored blob. ESP_ERR_NOT_FOUND if there is none yet.
+    esp_err_t (*load_blob)(void *blob, size_t *len);
+    esp_err_t (*save_blob)(const void *blob, size_t len);
+    // Read a pre-blob single-byte key (one-time migration). Optional.
+    esp_err_t (*load_legacy_u8)(const char *key, uint8_t *value);
+} settings_backend_t;
+
+// Called around every blob write. A flash write stalls the cache on both cores,
+// so code that must keep running (the panel refresh) hands over to an IRAM path.
+typedef struct {
+    void (*begin)(void);
+    void (*end)(void);
+} settings_flash_guard_t;
+
+/**
+ * @brief Load settings into RAM and start the background commit task
+ * @param backend NULL for NVS (also initializes the NVS partition)
+ */
+esp_err_t settings_init(const settings_backend_t *backend);
+
+/**
+ * @brief Install the write guard (NULL = none). The struct must outlive the settings task.
+ */
+void settings_set_flash_guard(const settings_flash_guard_t *guard);
+
+/**
+ * @brief Copy of the current in-RAM settings (never touches flash)
+ */
+settings_t settings_get(void);
+
+/**
+ * @brief Setters update RAM and schedule a debounced commit; they never block on flash
+ */
+void settings_set_brightness(uint8_t level);
+void settings_set_mode(uint8_t mode);
+void settings_set_format(uint8_t format);
+
+/**
+ * @brief Store a new panel geometry (0 = default for a field); used from the next boot
+ */
+void settings_set_geometry(uint8_t panel_width, uint8_t panel_height, uint8_t panel_scan,
+                           uint8_t n_hor, uint8_t n_ver);
+
+/**
+ * @brief Store a refresh rate target (0 = default); used from the next boot
+ */
+void settings_set_refresh_hz(uint16_t hz);
+
+/**
+ * @brief Write pending changes now (e.g. before a restart)
+ */
+esp_err_t settings_flush(void);
+
+void settings_get_stats(settings_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,138 @@
+#include "temp_pipeline.h"
+#include <string.h>
+#include <stdatomic.h>
+
+// Filter state, owned by the producer task
+static int16_t ring[TEMP_PIPE_WINDOW];
+static int16_t ema_hist[TEMP_PIPE_WINDOW];   // filtered values, for the trend
+static int ring_head = 0;
+static int ring_fill = 0;
+static int32_t ema_q4 = 0;
+
+static temp_change_cb_t change_cb = NULL;
+static void *change_arg = NULL;
+
+// Published reading, guarded by a sequence lock (odd = write in progress)
+static atomic_uint pub_seq = 0;
+static temp_reading_t pub;
+
+void temp_pipeline_init(temp_change_cb_t on_change, void *arg)
+{
+    change_cb = on_change;
+    change_arg = arg;
+    ring_head = 0;
+    ring_fill = 0;
+    ema_q4 = 0;
+    memset(&pub, 0, sizeof(pub));
+    atomic_store(&pub_seq, 0);
+}
+
+static int16_t median_of_ring(void)
+{
+    int16_t tmp[TEMP_PIPE_WINDOW];
+    memcpy(tmp, ring, ring_fill * sizeof(int16_t));
+
+    // Insertion sort, the window is tiny
+    for (int i = 1; i < ring_fill; i++) {
+        int16_t v = tmp[i];
+        int j = i - 1;
+        while (j >= 0 && tmp[j] > v) {
+            tmp[j + 1] = tmp[j];
+            j--;
+        }
+        tmp[j + 1] = v;
+    }
+    return tmp[ring_fill / 2];
+}
+
+static temp_band_t band_of(int16_t c)
+{
+    if (c < TEMP_BAND_COOL_C) return TEMP_BAND_COLD;
+    if (c < TEMP_BAND_WARM_C) return TEMP_BAND_COOL;
+    if (c < TEMP_BAND_HOT_C)  return TEMP_BAND_WARM;
+    return TEMP_BAND_HOT;
+}
+
+// Whole degree to show. Keep the previous one while the filtered value stays
+// within HYST of its [c, c+1) span so noise at an edge doesn't flicker the digit
+// (or the colour, which follows the digit).
+static int16_t display_degree(int16_t q4, int16_t prev, bool had_prev)
+{
+    int16_t c = q4 >> 4;   // floor
+    if (had_prev) {
+        int32_t lo = ((int32_t)prev << 4) - TEMP_PIPE_HYST_Q4;
+        int32_t hi = ((int32_t)(prev + 1) << 4) + TEMP_PIPE_HYST_Q4;
+        if (q4 >= lo && q4 < hi) c = prev;
+    }
+    if (c < TEMP_PIPE_MIN_C) c = TEMP_PIPE_MIN_C;
+    return c;
+}
+
+static void publish(const temp_reading_t *r)
+{
+    unsigned s = atomic_load_explicit(&pub_seq, memory_order_relaxed);
+    atomic_store_explicit(&pub_seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    pub = *r;
+    atomic_store_explicit(&pub_seq, s + 2, memory_order_release);
+}
+
+void temp_pipeline_push(int16_t sample_q4, bool valid)
+{
+    temp_reading_t prev = pub;   // only this task writes pub
+    temp_reading_t next = prev;
+    next.seq = prev.seq + 1;
+
+    if (!valid) {
+        next.valid = false;
+        next.trend = TEMP_TREND_FLAT;
+        ring_head = 0;     // restart the window when the probe comes back
+        ring_fill = 0;
+    } else {
+        ring[ring_head] = sample_q4;
+        int16_t med;
+
+        if (ring_fill < TEMP_PIPE_WINDOW) ring_fill++;
+        med = median_of_ring();
+
+        // Seed the EMA on the first sample instead of ramping from zero
+        if (ring_fill == 1)
+            ema_q4 = (int32_t)med << TEMP_PIPE_EMA_SHIFT;
+        else
+            ema_q4 += med - (ema_q4 >> TEMP_PIPE_EMA_SHIFT);
+
+        next.filtered_q4 = (int16_t)(ema_q4 >> TEMP_PIPE_EMA_SHIFT);
+
+        // Trend over the whole window: oldest filtered value vs. now
+        ema_hist[ring_head] = next.filtered_q4;
+        int oldest = (ring_fill < TEMP_PIPE_WINDOW) ? 0 : (ring_head + 1) % TEMP_PIPE_WINDOW;
+        int delta = next.filtered_q4 - ema_hist[oldest];
+        if (delta >= TEMP_PIPE_TREND_Q4)       next.trend = TEMP_TREND_UP;
+        else if (delta <= -TEMP_PIPE_TREND_Q4) next.trend = TEMP_TREND_DOWN;
+        else                                   next.trend = TEMP_TREND_FLAT;
+
+        ring_head = (ring_head + 1) % TEMP_PIPE_WINDOW;
+
+        next.display_c = display_degree(next.filtered_q4, prev.display_c, prev.valid);
+        next.band = band_of(next.display_c);
+        next.valid = true;
+    }
+
+    publish(&next);
+
+    bool changed = (next.valid != prev.valid) ||
+                   (next.valid && (next.display_c != prev.display_c || next.band != prev.band));
+
+    if (changed && change_cb) change_cb(&next, change_arg);
+}
+
+void temp_pipeline_get(temp_reading_t *out)
+{
+    unsigned s1, s2;
+    do {
+        s1 = atomic_load_explicit(&pub_seq, memory_order_acquire);
+        *out = pub;
+        atomic_thread_fence(memory_order_acquire);
+        s2 = atomic_load_explicit(&pub_seq, memory_order_relaxed);
+    } while ((s1 & 1) || s1 != s2);
+}
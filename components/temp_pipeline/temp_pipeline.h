@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ------------ CONFIG: filter ------------
+#define TEMP_PIPE_WINDOW      5     // ring buffer / median window (samples, odd)
+#define TEMP_PIPE_EMA_SHIFT   2     // EMA weight 1/4 on each new median
+#define TEMP_PIPE_HYST_Q4     6     // 0.375 °C past the edge before the shown degree changes
+#define TEMP_PIPE_TREND_Q4    4     // 0.25 °C over the window counts as rising/falling
+#define TEMP_PIPE_MIN_C      -9     // the display has room for one minus digit
+
+// Colour bands, lower bound in whole °C (same buckets draw_display always used)
+#define TEMP_BAND_COOL_C     10
+#define TEMP_BAND_WARM_C     20
+#define TEMP_BAND_HOT_C      30
+
+typedef enum {
+    TEMP_BAND_COLD = 0,   // < 10   white
+    TEMP_BAND_COOL,       // 10..19 cyan
+    TEMP_BAND_WARM,       // 20..29 orange
+    TEMP_BAND_HOT,        // >= 30  red
+} temp_band_t;
+
+typedef enum {
+    TEMP_TREND_FLAT = 0,
+    TEMP_TREND_UP,
+    TEMP_TREND_DOWN,
+} temp_trend_t;
+
+typedef struct {
+    uint32_t seq;          // bumps on every published sample
+    bool valid;
+    int16_t filtered_q4;   // median + EMA, 1/16 °C
+    int16_t display_c;     // whole degrees shown, with hysteresis
+    temp_band_t band;
+    temp_trend_t trend;
+} temp_reading_t;
+
+// Called from the producer's task when display_c, band or valid changes
+typedef void (*temp_change_cb_t)(const temp_reading_t *reading, void *arg);
+
+void temp_pipeline_init(temp_change_cb_t on_change, void *arg);
+
+/**
+ * @brief Feed one raw sample (1/16 °C). valid=false marks a failed read.
+ */
+void temp_pipeline_push(int16_t sample_q4, bool valid);
+
+/**
+ * @brief Lock-free consistent copy of the last published reading
+ */
+void temp_pipeline_get(temp_reading_t *out);
+
+#ifdef __cplusplus
+}
+#endif
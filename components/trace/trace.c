@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include "trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+
+#if (TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) != 0
+#error "TRACE_RING_EVENTS must be a power of two"
+#endif
+
+typedef struct {
+    uint32_t ts_us;           // esp_timer_get_time(), wraps after 71 minutes
+    uint8_t id;
+    uint8_t phase;
+    uint16_t arg;
+} trace_rec_t;
+
+typedef struct {
+    uint32_t head;            // slots ever reserved; slot = head % TRACE_RING_EVENTS
+    trace_rec_t ev[TRACE_RING_EVENTS];
+} trace_ring_t;
+
+static trace_ring_t rings[portNUM_PROCESSORS];
+static volatile bool paused = false;
+static uint32_t dumps = 0;
+
+// Event name and the track (task) it is drawn on
+static const struct {
+    const char *name;
+    const char *track;
+} trace_names[TRACE_EVENTS] = {
+    [TRACE_REFRESH_PASS] = { "pass",     "refresh_task" },
+    [TRACE_REFRESH_LATE] = { "late",     "refresh_task" },
+    [TRACE_ROW_OVERRUN]  = { "overrun",  "refresh_task" },
+    [TRACE_PRESENT]      = { "present",  "DrawTime" },
+    [TRACE_DRAW_FRAME]   = { "frame",    "DrawTime" },
+    [TRACE_MENU_INPUT]   = { "input",    "MenuTask" },
+    [TRACE_TEMP_CONVERT] = { "convert",  "TempTask" },
+    [TRACE_TEMP_READ]    = { "read",     "TempTask" },
+    [TRACE_UART_CAPTURE] = { "capture",  "UartStream" },
+};
+
+// IRAM: called from refresh_task on every pass
+IRAM_ATTR void trace_event(trace_id_t id, trace_phase_t phase, uint16_t arg)
+{
+    if (paused) return;
+
+    trace_ring_t *r = &rings[esp_cpu_get_core_id()];
+    uint32_t i = __atomic_fetch_add(&r->head, 1, __ATOMIC_RELAXED);
+    trace_rec_t *e = &r->ev[i & (TRACE_RING_EVENTS - 1)];
+
+    e->ts_us = (uint32_t)esp_timer_get_time();
+    e->id = id;
+    e->phase = phase;
+    e->arg = arg;
+}
+
+void trace_dump(trace_write_t write, void *arg)
+{
+    static const char ph[] = { 'B', 'E', 'i' };
+    char line[80];
+    trace_stats_t st;
+
+    trace_get_stats(&st);
+    paused = true;
+    vTaskDelay(1);    // let a writer that saw paused == false finish its slot
+
+    int n = snprintf(line, sizeof(line), "#T-BEGIN %d %lu %lu\n", portNUM_PROCESSORS,
+                     (unsigned long)st.events, (unsigned long)st.overwritten);
+    write(line, n, arg);
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        trace_ring_t *r = &rings[c];
+        uint32_t head = r->head;
+        uint32_t first = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+
+        for (uint32_t i = first; i != head; i++) {
+            const trace_rec_t *e = &r->ev[i & (TRACE_RING_EVENTS - 1)];
+            if (e->id >= TRACE_EVENTS || e->phase > TRACE_PH_INSTANT) continue;
+
+            n = snprintf(line, sizeof(line), "#T %d %lu %c %s %s %u\n", c, (unsigned long)e->ts_us,
+                         ph[e->phase], trace_names[e->id].track, trace_names[e->id].name, e->arg);
+            write(line, n, arg);
+        }
+        r->head = 0;
+    }
+
+    write("#T-END\n", 7, arg);
+    dumps++;
+    paused = false;
+}
+
+void trace_get_stats(trace_stats_t *out)
+{
+    out->events = 0;
+    out->overwritten = 0;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        uint32_t head = rings[c].head;
+        out->events += head;
+        if (head > TRACE_RING_EVENTS) out->overwritten += head - TRACE_RING_EVENTS;
+    }
+    out->dumps = dumps;
+}
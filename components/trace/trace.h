@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timeline recorder: begin/end/instant events with a µs timestamp, one ring per
+// core. Writers never lock: a slot is reserved with an atomic add, so tasks and
+// ISRs on either core can record; the ring overwrites its oldest events.
+// trace_dump() prints the rings as "#T" lines, tools/trace_to_chrome.py turns a
+// log containing them into Chrome trace JSON (chrome://tracing, Perfetto).
+
+// ------------ CONFIG: trace ------------
+#define TRACE_ENABLED        1       // 0 compiles every TRACE_* point out
+#define TRACE_RING_EVENTS    1024    // per core, power of two (8 bytes each)
+
+typedef enum {
+    TRACE_REFRESH_PASS = 0,   // refresh_task: all planes once
+    TRACE_REFRESH_LATE,       // refresh_task, instant: rows of the pass whose prefetch overran
+    TRACE_ROW_OVERRUN,        // refresh_task, instant: µs a row stayed lit past its slice
+    TRACE_PRESENT,            // compositor_present: compose + swap
+    TRACE_DRAW_FRAME,         // drawing_task: one draw_display()
+    TRACE_MENU_INPUT,         // menu_task: one button handled
+    TRACE_TEMP_CONVERT,       // temp_task: 1-Wire convert + wait
+    TRACE_TEMP_READ,          // temp_task: scratchpad reads (bit-banged, busy waits)
+    TRACE_UART_CAPTURE,       // uart_stream task: one capture frame encoded and queued
+    TRACE_EVENTS
+} trace_id_t;
+
+typedef enum {
+    TRACE_PH_BEGIN = 0,
+    TRACE_PH_END,
+    TRACE_PH_INSTANT,
+} trace_phase_t;
+
+typedef struct {
+    uint32_t events;          // recorded since the last dump
+    uint32_t overwritten;     // lost to the ring wrapping before a dump
+    uint32_t dumps;
+} trace_stats_t;
+
+/**
+ * @brief Record an event on the calling core's ring. Use the TRACE_* macros.
+ */
+void trace_event(trace_id_t id, trace_phase_t phase, uint16_t arg);
+
+typedef void (*trace_write_t)(const char *line, size_t len, void *arg);
+
+/**
+ * @brief Pause recording, write every event as a text line, clear the rings, resume
+ */
+void trace_dump(trace_write_t write, void *arg);
+
+void trace_get_stats(trace_stats_t *out);
+
+#if TRACE_ENABLED
+#define TRACE_BEGIN(id)          trace_event((id), TRACE_PH_BEGIN, 0)
+#define TRACE_END(id)            trace_event((id), TRACE_PH_END, 0)
+#define TRACE_INSTANT(id, arg)   trace_event((id), TRACE_PH_INSTANT, (arg))
+#else
+#define TRACE_BEGIN(id)          ((void)0)
+#define TRACE_END(id)            ((void)0)
+#define TRACE_INSTANT(id, arg)   ((void)(arg))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
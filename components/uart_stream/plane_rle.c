@@ -0,0 +1,17 @@
+#include "plane_rle.h"
+
+size_t plane_rle_encode(const uint8_t *src, size_t n, uint8_t *dst)
+{
+    uint8_t *out = dst;
+    size_t i = 0;
+
+    while (i < n) {
+        uint8_t v = src[i] & 0x07;
+        size_t run = 1;
+        while (i + run < n && run < PLANE_RLE_MAX_RUN && (src[i + run] & 0x07) == v) run++;
+
+        *out++ = (uint8_t)(((run - 1) << 3) | v);
+        i += run;
+    }
+    return (size_t)(out - dst);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Run-length coding of plane rows for the capture link, no IDF dependencies
+// (builds on the host).
+//
+// Input bytes are plane cells (RGB bits 0..7, PIXEL_COVER is dropped). Each
+// output byte is one run: bits 0..2 the cell, bits 3..7 the run length - 1
+// (1..32). Text and flat backgrounds shrink 10-30x; noise never grows.
+
+#define PLANE_RLE_MAX_RUN    32
+
+// Worst case output for n input cells
+#define PLANE_RLE_BOUND(n)   (n)
+
+/**
+ * @brief Encode n cells into dst (PLANE_RLE_BOUND(n) bytes). Returns the encoded size.
+ */
+size_t plane_rle_encode(const uint8_t *src, size_t n, uint8_t *dst);
+
+#ifdef __cplusplus
+}
+#endif
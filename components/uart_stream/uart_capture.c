@@ -0,0 +1,199 @@
+#include "uart_capture.h"
+#include "uart_stream.h"
+#include "plane_rle.h"
+#include "led_panel.h"
+#include "dither.h"
+#include "trace.h"
+#include "driver/uart.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "UART_CAPTURE";
+
+// Copy of the planes on screen, and the rows the PC already has (virtual
+// layout, COLOR_DEPTH * VIRT_WIDTH cells per row) for the mirror deltas
+static uint8_t *snap_fb = NULL;
+static uint8_t *snap_planes[COLOR_DEPTH];
+static uint8_t *sent_rows = NULL;
+static uint8_t *row_buf = NULL;
+static uint8_t *rle_buf = NULL;
+
+static volatile bool snapshot_pending = false;
+static volatile int mirror_fps = 0;
+static bool mirror_running = false;
+static int64_t next_mirror_us = 0;
+static int64_t next_key_us = 0;
+static uint16_t frame_seq = 0;
+
+static uart_capture_stats_t stats;
+
+static bool alloc_buffers(void)
+{
+    const size_t cells = COLOR_DEPTH * VIRT_WIDTH;
+
+    if (!snap_fb)   snap_fb   = led_panel_alloc(COLOR_DEPTH * PLANE_BYTES, LED_MEM_BULK, "capture frame");
+    if (!sent_rows) sent_rows = led_panel_alloc(cells * VIRT_HEIGHT, LED_MEM_BULK, "capture rows");
+    if (!row_buf)   row_buf   = led_panel_alloc(cells, LED_MEM_FAST, "capture row");
+    if (!rle_buf)   rle_buf   = led_panel_alloc(PLANE_RLE_BOUND(cells), LED_MEM_FAST, "capture rle");
+    if (!snap_fb || !sent_rows || !row_buf || !rle_buf) return false;
+
+    for (int p = 0; p < COLOR_DEPTH; p++) snap_planes[p] = snap_fb + p * PLANE_BYTES;
+    return true;
+}
+
+// What is on screen: the dithered frame if one is showing, else the front buffer.
+// No lock; if a swap lands during the copy the old front may already be redrawn.
+static void copy_screen(void)
+{
+    for (int tries = 0; tries < UART_CAPTURE_COPY_TRIES; tries++) {
+        uint32_t swaps = led_panel_swap_count();
+        uint8_t **shown = dither_shown_planes();
+        if (!shown) shown = front_planes;
+
+        for (int p = 0; p < COLOR_DEPTH; p++) memcpy(snap_planes[p], shown[p], PLANE_BYTES);
+
+        if (led_panel_swap_count() == swaps) return;
+        stats.torn++;
+    }
+}
+
+static void gather_row(int y)
+{
+    for (int x = 0; x < VIRT_WIDTH; x++) {
+        uint32_t i = led_panel_pixel_index(x, y);
+        for (int p = 0; p < COLOR_DEPTH; p++) {
+            row_buf[p * VIRT_WIDTH + x] = snap_planes[p][i] & PIXEL_RGB_MASK;
+        }
+    }
+}
+
+static void send_header(uint8_t kind, uint8_t flags, uint16_t a, uint16_t b)
+{
+    uint8_t h[UART_CAPTURE_HDR_SIZE] = {
+        UART_CAPTURE_SYNC0, UART_CAPTURE_SYNC1, kind, flags,
+        frame_seq & 0xFF, frame_seq >> 8, a & 0xFF, a >> 8, b & 0xFF, b >> 8,
+        COLOR_DEPTH, 0,
+    };
+    uint16_t crc = uart_stream_crc16(0xFFFF, &h[2], 10);
+    h[12] = crc & 0xFF;
+    h[13] = crc >> 8;
+    uart_write_bytes(UART_STREAM_PORT, h, sizeof(h));
+    stats.wire_bytes += sizeof(h);
+}
+
+static void send_frame(uint8_t flags)
+{
+    const int cells = COLOR_DEPTH * VIRT_WIDTH;
+    int64_t t0 = esp_timer_get_time();
+    int rows = 0;
+
+    TRACE_BEGIN(TRACE_UART_CAPTURE);
+    copy_screen();
+    frame_seq++;
+    send_header(UART_CAPTURE_FRAME, flags, VIRT_WIDTH, VIRT_HEIGHT);
+
+    for (int y = 0; y < VIRT_HEIGHT; y++) {
+        uint8_t *prev = sent_rows + y * cells;
+        gather_row(y);
+        if (!(flags & UART_CAPTURE_FLAG_KEY) && memcmp(prev, row_buf, cells) == 0) continue;
+        memcpy(prev, row_buf, cells);
+
+        size_t n = plane_rle_encode(row_buf, cells, rle_buf);
+        uint16_t crc = uart_stream_crc16(0xFFFF, rle_buf, n);
+        uint8_t tail[2] = { crc & 0xFF, crc >> 8 };
+
+        send_header(UART_CAPTURE_ROW, 0, y, n);
+        uart_write_bytes(UART_STREAM_PORT, rle_buf, n);
+        uart_write_bytes(UART_STREAM_PORT, tail, sizeof(tail));
+
+        rows++;
+        stats.raw_bytes += cells;
+        stats.wire_bytes += n + sizeof(tail);
+    }
+
+    send_header(UART_CAPTURE_END, 0, rows, 0);
+    stats.rows += rows;
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    stats.last_us = us;
+    if (us > stats.max_us) stats.max_us = us;
+    TRACE_END(TRACE_UART_CAPTURE);
+}
+
+void uart_capture_snapshot(void)
+{
+    snapshot_pending = true;
+}
+
+void uart_capture_mirror(int fps)
+{
+    if (fps < 0) fps = 0;
+    if (fps > UART_CAPTURE_MAX_FPS) fps = UART_CAPTURE_MAX_FPS;
+    mirror_fps = fps;
+}
+
+int uart_capture_mirror_fps(void)
+{
+    return mirror_fps;
+}
+
+TickType_t uart_capture_poll(void)
+{
+    int fps = mirror_fps;
+    if (!snapshot_pending && fps == 0) {
+        mirror_running = false;
+        return portMAX_DELAY;
+    }
+
+    if (!alloc_buffers()) {
+        ESP_LOGE(TAG, "No memory for capture, request dropped");
+        snapshot_pending = false;
+        mirror_fps = 0;
+        return portMAX_DELAY;
+    }
+
+    if (snapshot_pending) {
+        snapshot_pending = false;
+        send_frame(UART_CAPTURE_FLAG_KEY | UART_CAPTURE_FLAG_SNAPSHOT);
+        stats.snapshots++;
+    }
+    if (fps == 0) {
+        mirror_running = false;
+        return portMAX_DELAY;
+    }
+
+    int64_t now = esp_timer_get_time();
+    const int64_t period = 1000000 / fps;
+
+    if (!mirror_running) {
+        // The PC starts from nothing: first frame sends every row
+        mirror_running = true;
+        next_mirror_us = now;
+        next_key_us = now;
+        ESP_LOGI(TAG, "Mirror at %d fps", fps);
+    }
+
+    if (now >= next_mirror_us) {
+        bool key = now >= next_key_us;
+        if (key) next_key_us = now + UART_CAPTURE_KEYFRAME_MS * 1000LL;
+
+        send_frame(key ? UART_CAPTURE_FLAG_KEY : 0);
+        stats.mirror_frames++;
+
+        // Skip frames the wire could not keep up with instead of bursting
+        next_mirror_us += period;
+        if (next_mirror_us <= now) next_mirror_us = now + period;
+        now = esp_timer_get_time();
+    }
+
+    // At least a tick: a sub-tick wait must not spin the task
+    int64_t wait_us = next_mirror_us - now;
+    if (wait_us <= 0) return 0;
+    TickType_t ticks = pdMS_TO_TICKS((wait_us + 999) / 1000);
+    return ticks ? ticks : 1;
+}
+
+void uart_capture_get_stats(uart_capture_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Screen capture over the stream UART: what the firmware is showing, for
+// tools/uart_capture.py. Requested with UART_STREAM_CMD frames (uart_stream.h).
+// The planes on screen are copied without any lock (a swap during the copy
+// just retries), then encoded and queued from the uart_stream task on core 1,
+// so the refresh task never waits on a capture or on the wire.
+
+// ------------ CONFIG: capture ------------
+#define UART_CAPTURE_MAX_FPS       25       // mirror rate limit (a full 64x32 key frame is ~1.5 KB)
+#define UART_CAPTURE_KEYFRAME_MS   5000     // mirror resends every row this often, so a lost row heals
+#define UART_CAPTURE_COPY_TRIES    3        // torn copies (swap during the copy) before sending anyway
+
+// ------------ Wire format (device -> PC, little-endian) ------------
+//
+//  off size
+//   0   2   sync 0x5A 0xC3
+//   2   1   kind   (UART_CAPTURE_FRAME / _ROW / _END)
+//   3   1   flags  (FRAME only, UART_CAPTURE_FLAG_*)
+//   4   2   frame seq
+//   6   2   FRAME: virtual width    ROW: y           END: rows sent
+//   8   2   FRAME: virtual height   ROW: RLE bytes   END: 0
+//  10   1   depth  (COLOR_DEPTH)
+//  11   1   0
+//  12   2   CRC16 over bytes 2..11
+//  14   n   ROW only: plane_rle.h runs over the row's cells, plane 0 x = 0..w-1, then plane 1 ...
+//   ..  2   ROW only: CRC16 over the RLE bytes
+//
+// A frame is FRAME, the changed rows (every row with UART_CAPTURE_FLAG_KEY), END.
+//
+#define UART_CAPTURE_SYNC0         0x5A
+#define UART_CAPTURE_SYNC1         0xC3
+#define UART_CAPTURE_HDR_SIZE      14
+
+#define UART_CAPTURE_FRAME         1
+#define UART_CAPTURE_ROW           2
+#define UART_CAPTURE_END           3
+
+#define UART_CAPTURE_FLAG_KEY      0x01     // every row follows
+#define UART_CAPTURE_FLAG_SNAPSHOT 0x02     // answer to UART_STREAM_CMD_SNAPSHOT
+
+typedef struct {
+    uint32_t snapshots;
+    uint32_t mirror_frames;
+    uint32_t rows;            // rows sent
+    uint32_t raw_bytes;       // cells in the rows sent
+    uint32_t wire_bytes;      // headers + RLE actually queued
+    uint32_t torn;            // copies retried because a swap happened during the copy
+    uint32_t last_us;         // copy + encode + queue time of the last frame
+    uint32_t max_us;
+} uart_capture_stats_t;
+
+/**
+ * @brief Send one key frame at the next uart_capture_poll()
+ */
+void uart_capture_snapshot(void);
+
+/**
+ * @brief Mirror the screen at fps (clamped to UART_CAPTURE_MAX_FPS), changed rows only; 0 stops
+ */
+void uart_capture_mirror(int fps);
+
+int uart_capture_mirror_fps(void);
+
+/**
+ * @brief Send what is due. Called by the uart_stream task; returns how long it may block.
+ */
+TickType_t uart_capture_poll(void);
+
+void uart_capture_get_stats(uart_capture_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,408 @@
+#include <stdio.h>
+#include "uart_stream.h"
+#include "uart_capture.h"
+#include "trace.h"
+#include "monitor.h"
+#include "led_panel.h"
+#include "driver/uart.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "UART_STREAM";
+
+// Incremental decoder: bytes go straight from the driver's ring buffer into
+// set_pixel(), no frame-sized staging buffer.
+typedef enum {
+    ST_SYNC0 = 0,
+    ST_SYNC1,
+    ST_HEADER,
+    ST_PIXELS,
+    ST_CRC,
+} rx_state_t;
+
+static struct {
+    rx_state_t state;
+    uint8_t hdr[UART_STREAM_HDR_SIZE];
+    int hdr_len;
+    uint8_t type, flags;
+    uint16_t seq;
+    int x, y, w, h;
+    int cur_x, cur_y;        // next pixel inside the rect
+    int remaining;           // payload bytes still to come
+    uint8_t lo;              // first byte of an RGB565 pixel
+    bool have_lo;
+    uint16_t crc;
+    uint8_t crc_buf[2];
+    int crc_len;
+} rx;
+
+static QueueHandle_t uart_queue = NULL;
+static volatile bool owning_panel = false;
+static int64_t last_rx_us = 0;        // last frame end or payload byte
+static uart_stream_stats_t stats;
+static uint16_t crc_table[256];
+
+static void crc16_init_table(void)
+{
+    for (int i = 0; i < 256; i++) {
+        uint16_t c = i << 8;
+        for (int b = 0; b < 8; b++)
+            c = (c & 0x8000) ? (c << 1) ^ 0x1021 : (c << 1);
+        crc_table[i] = c;
+    }
+}
+
+uint16_t uart_stream_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    while (len--)
+        crc = (crc << 8) ^ crc_table[((crc >> 8) ^ *data++) & 0xFF];
+    return crc;
+}
+
+static void send_ack(uint16_t seq, uart_stream_status_t status)
+{
+    uint8_t ack[5] = { UART_STREAM_SYNC1, UART_STREAM_SYNC0, seq & 0xFF, seq >> 8, status };
+    uart_write_bytes(UART_STREAM_PORT, ack, sizeof(ack));
+}
+
+static bool header_valid(void)
+{
+    uint16_t crc = rx.hdr[14] | (rx.hdr[15] << 8);
+    if (uart_stream_crc16(0xFFFF, &rx.hdr[2], 12) != crc) return false;
+
+    rx.type  = rx.hdr[2];
+    rx.flags = rx.hdr[3];
+    rx.seq   = rx.hdr[4] | (rx.hdr[5] << 8);
+    rx.x     = rx.hdr[6]  | (rx.hdr[7] << 8);
+    rx.y     = rx.hdr[8]  | (rx.hdr[9] << 8);
+    rx.w     = rx.hdr[10] | (rx.hdr[11] << 8);
+    rx.h     = rx.hdr[12] | (rx.hdr[13] << 8);
+
+    if (rx.type == UART_STREAM_FULL)
+        return rx.x == 0 && rx.y == 0 && rx.w == VIRT_WIDTH && rx.h == VIRT_HEIGHT;
+
+    if (rx.type == UART_STREAM_CMD)
+        return rx.w == 0 && rx.h == 0;
+
+    return rx.type == UART_STREAM_RECT && rx.w > 0 && rx.h > 0 &&
+           rx.x + rx.w <= VIRT_WIDTH && rx.y + rx.h <= VIRT_HEIGHT;
+}
+
+static void begin_payload(void)
+{
+    if (!owning_panel) {
+        // Wait for drawing_task to finish its current frame, then keep the back
+        // buffer until the stream goes idle
+        led_panel_claim(portMAX_DELAY);
+        owning_panel = true;
+        copy_front_to_back();
+        ESP_LOGI(TAG, "Stream started");
+    }
+
+    rx.cur_x = rx.x;
+    rx.cur_y = rx.y;
+    rx.remaining = rx.w * rx.h * 2;
+    rx.have_lo = false;
+    rx.crc = 0xFFFF;
+    rx.crc_len = 0;
+    rx.state = ST_PIXELS;
+    last_rx_us = esp_timer_get_time();
+}
+
+static void end_frame(void)
+{
+    uint16_t crc = rx.crc_buf[0] | (rx.crc_buf[1] << 8);
+    last_rx_us = esp_timer_get_time();
+
+    if (crc != rx.crc) {
+        // The rect is already in the back buffer; put back what is on screen
+        // there. Earlier rects waiting for a present were acked and stay.
+        copy_front_to_back_rect(rx.x, rx.y, rx.w, rx.h);
+        stats.bad_crc++;
+        send_ack(rx.seq, UART_STREAM_ACK_BAD_CRC);
+        return;
+    }
+
+    stats.frames++;
+
+    if (rx.type == UART_STREAM_FULL || (rx.flags & UART_STREAM_FLAG_PRESENT)) {
+        swap_buffers();
+        copy_front_to_back();     // deltas build on the frame just shown
+        stats.presented++;
+    }
+
+    send_ack(rx.seq, UART_STREAM_ACK_OK);
+}
+
+static void write_line(const char *line, size_t len, void *arg)
+{
+    uart_write_bytes(UART_STREAM_PORT, line, len);
+}
+
+// Refresh-side lines next to the monitor report: rows lit past their slice since
+// the previous report (interrupts on the refresh core), and the flash-write gap
+static void write_refresh_report(void)
+{
+    static const uint8_t limit[] = LED_ROW_OVER_LIMITS;
+    led_refresh_stats_t rs;
+    char line[160];
+
+    led_panel_get_refresh_stats(&rs);
+    led_panel_reset_row_overrun();
+
+    int n = snprintf(line, sizeof(line), "#M rows overrun max %lu us ", (unsigned long)rs.row_over_max_us);
+    for (int b = 0; b < LED_ROW_OVER_BUCKETS; b++) {
+        if (b < LED_ROW_OVER_BUCKETS - 1)
+            n += snprintf(line + n, sizeof(line) - n, " <%u:%lu", limit[b], (unsigned long)rs.row_over_hist[b]);
+        else
+            n += snprintf(line + n, sizeof(line) - n, " >=%u:%lu\n", limit[b - 1], (unsigned long)rs.row_over_hist[b]);
+    }
+    write_line(line, n, NULL);
+
+    n = snprintf(line, sizeof(line), "#M flash writes %lu  blanked %lu  gap max %lu us  last %lu us\n",
+                 (unsigned long)rs.flash_writes, (unsigned long)rs.flash_blanked,
+                 (unsigned long)rs.flash_gap_max_us, (unsigned long)rs.flash_gap_last_us);
+    write_line(line, n, NULL);
+
+    n = snprintf(line, sizeof(line), "#M scan pass %lu us (every row %lu us)  duty %u/256  fast %lu/%lu"
+                 "  skipped %lu merged %lu  plans %lu\n",
+                 (unsigned long)rs.pass_us, (unsigned long)rs.pass_full_us, rs.duty_scale,
+                 (unsigned long)rs.fast_passes, (unsigned long)rs.passes, (unsigned long)rs.rows_skipped,
+                 (unsigned long)rs.rows_merged, (unsigned long)rs.plans);
+    write_line(line, n, NULL);
+
+    if (rs.target_hz) {
+        n = snprintf(line, sizeof(line), "#M refresh target %u Hz x%u  slice %lu ns  blank %llu us"
+                     "  unmet %lu  late %lu  max %lu Hz\n",
+                     rs.target_hz, rs.target_repeat, (unsigned long)rs.slice_ns, (unsigned long long)rs.blank_us,
+                     (unsigned long)rs.target_unmet, (unsigned long)rs.target_late,
+                     (unsigned long)led_panel_max_refresh_hz());
+    } else {
+        n = snprintf(line, sizeof(line), "#M refresh free-running %lu Hz  max target %lu Hz\n",
+                     rs.pass_us ? (unsigned long)(1000000 / rs.pass_us) : 0UL,
+                     (unsigned long)led_panel_max_refresh_hz());
+    }
+    write_line(line, n, NULL);
+
+    // Calibration for tools/capacity_plan.py
+    n = snprintf(line, sizeof(line), "#M timing panel %ux%u scan %u panels %d chains %d depth %d cols %d"
+                 "  shift %lu ns  stage %lu ns  ram %lu psram %lu\n",
+                 PANEL_WIDTH, PANEL_HEIGHT, PANEL_SCAN, PHYS_PANELS, N_CHAINS, COLOR_DEPTH, SCAN_COLS,
+                 (unsigned long)rs.shift_ns,
+                 rs.rows ? (unsigned long)(rs.prefetch_us * 1000 / rs.rows) : 0UL,
+                 (unsigned long)rs.internal_bytes, (unsigned long)rs.psram_bytes);
+    write_line(line, n, NULL);
+}
+
+static void run_command(void)
+{
+    switch (rx.x) {
+        case UART_STREAM_CMD_SNAPSHOT:
+            uart_capture_snapshot();
+            break;
+
+        case UART_STREAM_CMD_MIRROR:
+            uart_capture_mirror(rx.y);
+            break;
+
+        case UART_STREAM_CMD_TRACE:
+            send_ack(rx.seq, UART_STREAM_ACK_OK);   // before the dump, so the PC isn't left waiting
+            stats.commands++;
+            trace_dump(write_line, NULL);
+            return;
+
+        case UART_STREAM_CMD_MONITOR:
+            send_ack(rx.seq, UART_STREAM_ACK_OK);
+            stats.commands++;
+            monitor_report(rx.y ? rx.y : 1, write_line, NULL);
+            write_refresh_report();
+            return;
+
+        default:
+            send_ack(rx.seq, UART_STREAM_ACK_BAD_COMMAND);
+            return;
+    }
+
+    stats.commands++;
+    send_ack(rx.seq, UART_STREAM_ACK_OK);
+}
+
+static void feed(const uint8_t *data, int len)
+{
+    for (int i = 0; i < len; i++) {
+        uint8_t c = data[i];
+
+        switch (rx.state) {
+            case ST_SYNC0:
+                if (c == UART_STREAM_SYNC0) rx.state = ST_SYNC1;
+                break;
+
+            case ST_SYNC1:
+                if (c == UART_STREAM_SYNC1) {
+                    rx.hdr[0] = UART_STREAM_SYNC0;
+                    rx.hdr[1] = UART_STREAM_SYNC1;
+                    rx.hdr_len = 2;
+                    rx.state = ST_HEADER;
+                } else if (c != UART_STREAM_SYNC0) {
+                    rx.state = ST_SYNC0;
+                }
+                break;
+
+            case ST_HEADER:
+                rx.hdr[rx.hdr_len++] = c;
+                if (rx.hdr_len == UART_STREAM_HDR_SIZE) {
+                    if (!header_valid()) {
+                        stats.bad_header++;
+                        rx.state = ST_SYNC0;
+                    } else if (rx.type == UART_STREAM_CMD) {
+                        run_command();
+                        rx.state = ST_SYNC0;
+                    } else {
+                        begin_payload();
+                    }
+                }
+                break;
+
+            case ST_PIXELS: {
+                // Take every byte of this chunk that belongs to the rect in one go
+                int n = len - i;
+                if (n > rx.remaining) n = rx.remaining;
+                rx.crc = uart_stream_crc16(rx.crc, &data[i], n);
+
+                for (int k = 0; k < n; k++) {
+                    uint8_t b = data[i + k];
+                    if (!rx.have_lo) {
+                        rx.lo = b;
+                        rx.have_lo = true;
+                        continue;
+                    }
+                    rx.have_lo = false;
+
+                    uint16_t px = rx.lo | (b << 8);
+                    int r5 = (px >> 11) & 0x1F, g6 = (px >> 5) & 0x3F, b5 = px & 0x1F;
+                    set_pixel(rx.cur_x, rx.cur_y,
+                              (r5 << 3) | (r5 >> 2), (g6 << 2) | (g6 >> 4), (b5 << 3) | (b5 >> 2));
+
+                    if (++rx.cur_x == rx.x + rx.w) {
+                        rx.cur_x = rx.x;
+                        rx.cur_y++;
+                    }
+                }
+
+                rx.remaining -= n;
+                i += n - 1;
+                last_rx_us = esp_timer_get_time();
+                if (rx.remaining == 0) rx.state = ST_CRC;
+                break;
+            }
+
+            case ST_CRC:
+                rx.crc_buf[rx.crc_len++] = c;
+                if (rx.crc_len == 2) {
+                    end_frame();
+                    rx.state = ST_SYNC0;
+                }
+                break;
+        }
+    }
+}
+
+// A frame that is still arriving keeps the panel: only a sender silent for
+// UART_STREAM_IDLE_MS, mid-frame or between frames, gives it back
+static void release_panel_if_idle(void)
+{
+    if (owning_panel && esp_timer_get_time() - last_rx_us > UART_STREAM_IDLE_MS * 1000LL) {
+        if (rx.state >= ST_PIXELS) {
+            // Stalled inside a payload: put back what is on screen first
+            copy_front_to_back();
+            stats.stalled++;
+        }
+        rx.state = ST_SYNC0;
+        owning_panel = false;
+        led_panel_release();
+        ESP_LOGI(TAG, "Stream idle, panel released (%lu frames, %lu bad crc)",
+                 (unsigned long)stats.frames, (unsigned long)stats.bad_crc);
+    }
+}
+
+static void uart_stream_task(void *arg)
+{
+    static uint8_t chunk[512];
+    uart_event_t event;
+
+    while (1) {
+        TickType_t wait = owning_panel ? pdMS_TO_TICKS(UART_STREAM_IDLE_MS / 4) : portMAX_DELAY;
+        TickType_t capture_wait = uart_capture_poll();
+        if (capture_wait < wait) wait = capture_wait;
+
+        if (xQueueReceive(uart_queue, &event, wait)) {
+            switch (event.type) {
+                case UART_DATA: {
+                    size_t left = event.size;
+                    while (left > 0) {
+                        int n = uart_read_bytes(UART_STREAM_PORT, chunk,
+                                                left < sizeof(chunk) ? left : sizeof(chunk), 0);
+                        if (n <= 0) break;
+                        stats.bytes += n;
+                        feed(chunk, n);
+                        left -= n;
+                    }
+                    break;
+                }
+
+                case UART_FIFO_OVF:
+                case UART_BUFFER_FULL:
+                    // Bytes were lost: drop the partial frame and resync
+                    stats.overflows++;
+                    uart_flush_input(UART_STREAM_PORT);
+                    xQueueReset(uart_queue);
+                    if (rx.state >= ST_PIXELS && owning_panel) copy_front_to_back();
+                    rx.state = ST_SYNC0;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        release_panel_if_idle();
+    }
+}
+
+esp_err_t uart_stream_start(void)
+{
+    crc16_init_table();
+
+    const uart_config_t cfg = {
+        .baud_rate  = UART_STREAM_BAUD,
+        .data_bits  = UART_DATA_8_BITS,
+        .parity     = UART_PARITY_DISABLE,
+        .stop_bits  = UART_STOP_BITS_1,
+        .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    esp_err_t err = uart_driver_install(UART_STREAM_PORT, UART_STREAM_RX_BUF, UART_STREAM_TX_BUF,
+                                        20, &uart_queue, 0);
+    if (err != ESP_OK) return err;
+
+    err = uart_param_config(UART_STREAM_PORT, &cfg);
+    if (err != ESP_OK) return err;
+
+    if (xTaskCreatePinnedToCore(uart_stream_task, "UartStream", 3072, NULL, 3, NULL, 1) != pdPASS)
+        return ESP_ERR_NO_MEM;
+
+    ESP_LOGI(TAG, "Listening on UART%d at %d baud", UART_STREAM_UART, UART_STREAM_BAUD);
+    return ESP_OK;
+}
+
+bool uart_stream_active(void)
+{
+    return owning_panel;
+}
+
+void uart_stream_get_stats(uart_stream_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ------------ CONFIG ------------
+#define UART_STREAM_UART        0           // the USB-UART bridge; the console is off (sdkconfig) so no log byte lands in the stream
+#define UART_STREAM_PORT        ((uart_port_t)UART_STREAM_UART)
+#define UART_STREAM_BAUD        2000000     // up to 3000000 with a good USB-UART bridge
+#define UART_STREAM_RX_BUF      8192        // driver ring buffer
+#define UART_STREAM_TX_BUF      4096        // acks and captures queue here instead of waiting on the wire
+#define UART_STREAM_IDLE_MS     2000        // hand the panel back after this long without a byte of a frame
+
+// Acks, captures (uart_capture.h) and reports share the port with the frames;
+// console logs on it would land inside them on the PC side
+#if CONFIG_ESP_CONSOLE_UART && CONFIG_ESP_CONSOLE_UART_NUM == UART_STREAM_UART
+#error "The console is on the stream UART: set CONFIG_ESP_CONSOLE_NONE or another console UART"
+#endif
+
+// ------------ Wire format (little-endian) ------------
+//
+//  off size
+//   0   2   sync 0xA5 0x5A
+//   2   1   type   (UART_STREAM_FULL / UART_STREAM_RECT / UART_STREAM_CMD)
+//   3   1   flags  (UART_STREAM_FLAG_PRESENT: swap after this rect)
+//   4   2   seq    (echoed in the ack)
+//   6   8   x, y, w, h   (full frames: 0, 0, VIRT_WIDTH, VIRT_HEIGHT)
+//  14   2   CRC16 over bytes 2..13
+//  16 w*h*2 RGB565 pixels, row major
+//   ..  2   CRC16 over the pixels
+//
+// The device answers every frame with 5 bytes: 0x5A 0xA5 seq(2) status.
+//
+// UART_STREAM_CMD frames carry no pixels and no pixel CRC: x is the command,
+// y its argument, w = h = 0. They are acked too and never take the panel.
+//
+#define UART_STREAM_SYNC0       0xA5
+#define UART_STREAM_SYNC1       0x5A
+#define UART_STREAM_HDR_SIZE    16
+
+#define UART_STREAM_FULL        1
+#define UART_STREAM_RECT        2
+#define UART_STREAM_CMD         3
+
+#define UART_STREAM_CMD_SNAPSHOT  1     // send one capture of the screen (uart_capture.h)
+#define UART_STREAM_CMD_MIRROR    2     // y = fps, changed rows only; 0 stops
+#define UART_STREAM_CMD_TRACE     3     // print and clear the timeline rings (trace.h)
+#define UART_STREAM_CMD_MONITOR   4     // print CPU use, wake latency, row overruns, the flash-write gap, the scan pass and the refresh target, y = minutes merged
+
+#define UART_STREAM_FLAG_PRESENT 0x01
+
+typedef enum {
+    UART_STREAM_ACK_OK = 0,
+    UART_STREAM_ACK_BAD_HEADER,
+    UART_STREAM_ACK_BAD_CRC,
+    UART_STREAM_ACK_BAD_COMMAND,
+} uart_stream_status_t;
+
+typedef struct {
+    uint32_t frames;         // good frames/rects
+    uint32_t presented;      // swaps
+    uint32_t bad_header;
+    uint32_t bad_crc;
+    uint32_t commands;
+    uint32_t overflows;      // driver FIFO / ring buffer overruns
+    uint32_t stalled;        // frames dropped after UART_STREAM_IDLE_MS without a payload byte
+    uint32_t bytes;
+} uart_stream_stats_t;
+
+/**
+ * @brief Install the UART driver at UART_STREAM_BAUD and start the receiver task
+ */
+esp_err_t uart_stream_start(void);
+
+/**
+ * @brief True while a PC is streaming (the receiver owns the back buffer)
+ */
+bool uart_stream_active(void);
+
+void uart_stream_get_stats(uart_stream_stats_t *out);
+
+/**
+ * @brief CRC16-CCITT (poly 0x1021, init 0xFFFF) continuing from crc
+ */
+uint16_t uart_stream_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,18 @@
 #include "ds18b20.h"
 #include "led_panel.h"
 #include "ds3231.h"
+#include "temp_pipeline.h"
+#include "settings.h"
+#include "buttons.h"
+#include "uart_stream.h"
+#include "compositor.h"
+#include "dither.h"
+#include "rgb_canvas.h"
+#include "text_layout.h"
+#include "anim_clock.h"
+#include "trace.h"
+#include "monitor.h"
+#include "irq_core.h"
 #include "logo.h"
 #include "freertos/queue.h"
 #include "esp_timer.h"
@@ -12,8 +24,16 @@
 
 #define MENU_TIMEOUT_US   (10 * 1000000)  // 10 seconds
 
-#define UART_NUM        UART_NUM_0
-#define UART_BUF_SIZE   1024
+// 1: scenes draw into an RGB565 canvas that is converted into the content layer
+// at present, instead of set_pixel writing planes one pixel at a time
+#define CONTENT_RGB_CANVAS   0
+
+// Scene changes blend from the old scene over this long (0 = hard cut); the kind
+// (slide, wipe, dissolve, fade) changes with every scene
+#define SCENE_TRANSITION_MS  600
+
+// The scene loops sleep this long after every frame
+#define DRAW_FRAME_MS        50
 
 bool ds18b20_is_present(ds18b20_t *dev)
 {
@@ -30,6 +50,12 @@ static TickType_t temp_timestamp = 0;
 
 
 
+// drawing_task notification bits
+#define NOTIFY_TEMP_CHANGED   (1 << 0)
+#define NOTIFY_INPUT          (1 << 1)
+
+static TaskHandle_t drawing_handle = NULL;
+
 static int menu_active = 0;
 static int64_t last_button_time = 0;
 
@@ -38,12 +64,8 @@ bool stop_flag = false;
 
 bool mode_flag = false;
 
-bool mode_entering = false;
-
 bool format_flag = false;
 
-bool format_entering = false;
-
 
 
 int temporal_brightness = 0;
@@ -54,28 +76,28 @@ int temporal_brightness = 0;
 
 // At top of file (global)
 
+// Animation timebase of draw_display: every animation is evaluated at the frame's
+// expected scan-out time
+static anim_clock_t anim;
+
 typedef struct {
-    char text[64];
-    float x;       // <- float instead of int for subpixel precision
+    text_layout_t text;
+    anim_linear_t x;   // fixed point, from x = 63 leftwards at the scroll speed
     int y;
     uint8_t r, g, b;
     bool active;
     //bool temp;
-    TickType_t last_tick;
-    int speed_px_per_sec;
 } scroll_state_t;
 
 static scroll_state_t scroll_state = {0};
 
-void scroll_start(const char *text, int y,
+void scroll_start(const text_layout_t *text, int y,
                   uint8_t r, uint8_t g, uint8_t b,
                   int speed_px_per_sec) {
-    strncpy(scroll_state.text, text, sizeof(scroll_state.text) - 1);
-    scroll_state.text[sizeof(scroll_state.text) - 1] = '\0';
+    scroll_state.text = *text;
     
     
-    scroll_state.x = 63.0f;  // start as float
-    scroll_state.speed_px_per_sec = speed_px_per_sec;
+    anim_linear_start(&scroll_state.x, anim_clock_now(&anim), FX_FROM_INT(63), -speed_px_per_sec);
     scroll_state.active = true;
     
     //if(scroll_state.temp) {
@@ -91,7 +113,6 @@ void scroll_start(const char *text, int y,
 
     
     //scroll_state.temp = false;
-    scroll_state.last_tick = xTaskGetTickCount();
 }
 
 
@@ -99,24 +120,14 @@ void scroll_start(const char *text, int y,
 void scroll_update(void) {
     if (!scroll_state.active) return;
 
-    TickType_t now = xTaskGetTickCount();
-    TickType_t elapsed_ms = (now - scroll_state.last_tick) * portTICK_PERIOD_MS;
-
-    if (elapsed_ms > 0) {
-        float delta = (scroll_state.speed_px_per_sec * elapsed_ms) / 1000.0f;
-        scroll_state.x -= delta;  // smooth subpixel step
-        scroll_state.last_tick = now;
-    }
+    // draw at integer position, wherever the frame's time puts it
+    int draw_x = FX_TO_INT(anim_linear_at(&scroll_state.x, anim_clock_now(&anim)));
+    draw_glyphs(draw_x, scroll_state.y,
+                scroll_state.text.glyph, scroll_state.text.len,
+                scroll_state.r, scroll_state.g, scroll_state.b);
 
-    // draw at integer position
-    int draw_x = (int)scroll_state.x;
-    draw_text(draw_x, scroll_state.y,
-              scroll_state.text,
-              scroll_state.r, scroll_state.g, scroll_state.b);
-
-    int text_width = strlen(scroll_state.text) * FONT_WIDTH;
+    int text_width = scroll_state.text.len * FONT_WIDTH;
     if (draw_x + text_width + FONT_WIDTH*4 < 0) {
-        scroll_state.x = 63.0f;
         //scroll_state.temp = true;
         scroll_state.active = false;
     }
@@ -156,38 +167,21 @@ typedef enum {
     BTN_DOWN
 } button_t;
 
-static QueueHandle_t button_queue;
-
-static void IRAM_ATTR button_isr_handler(void* arg)
+// Installs the GPIO ISR service: run through irq_core_call(IRQ_CORE_GPIO, ...)
+static esp_err_t init_buttons(void *arg)
 {
-    last_button_time = esp_timer_get_time();  // refresh timeout
-	button_t btn = (button_t)(uint32_t)arg;
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    xQueueSendFromISR(button_queue, &btn, &xHigherPriorityTaskWoken);
-    if (xHigherPriorityTaskWoken) portYIELD_FROM_ISR();
-}
-
-
-static void init_buttons(void)
-{
-    gpio_config_t io_conf = {};
-    io_conf.pin_bit_mask = (1ULL << PIN_MENU) | (1ULL << PIN_UP) | (1ULL << PIN_DOWN);
-    io_conf.mode = GPIO_MODE_INPUT;
-    io_conf.pull_up_en = GPIO_PULLUP_DISABLE;  // use only external pull-ups
-    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-    io_conf.intr_type = GPIO_INTR_NEGEDGE;    // trigger on press (falling edge)
-    gpio_config(&io_conf);
-
-    // Create queue
-    button_queue = xQueueCreate(10, sizeof(button_t));
-
-    // Install ISR service
-    gpio_install_isr_service(0);
-
-    // Add ISR handlers
-    gpio_isr_handler_add(PIN_MENU, button_isr_handler, (void*)(uint32_t)BTN_MENU);
-    gpio_isr_handler_add(PIN_UP,   button_isr_handler, (void*)(uint32_t)BTN_UP);
-    gpio_isr_handler_add(PIN_DOWN, button_isr_handler, (void*)(uint32_t)BTN_DOWN);
+    // Long press is only acted on outside the menu; repeat only inside it (UP/DOWN)
+    const button_timing_t timing = {
+        .long_us         = HOLD_MS * 1000LL,
+        .repeat_delay_us = REPEAT_DELAY * 1000LL,
+        .repeat_rate_us  = REPEAT_RATE * 1000LL,
+    };
+
+    ESP_ERROR_CHECK(buttons_init());
+    ESP_ERROR_CHECK(buttons_add(BTN_MENU, PIN_MENU, &timing));
+    ESP_ERROR_CHECK(buttons_add(BTN_UP,   PIN_UP,   &timing));
+    ESP_ERROR_CHECK(buttons_add(BTN_DOWN, PIN_DOWN, &timing));
+    return ESP_OK;
 }
 
 
@@ -314,9 +308,9 @@ static void handle_menu_button(button_t btn, ds3231_dev_t *rtc)
 				
 				brightness_level = temporal_brightness;				
 								
-				save_brightness(brightness_level);  // <--- save here
+				settings_set_brightness(brightness_level);  // <--- save here (committed in the background)
 					
-				//save_format(clock_format);  // <--- save here
+				//settings_set_format(clock_format);  // <--- save here
 				
 				
 						
@@ -331,101 +325,70 @@ static void handle_menu_button(button_t btn, ds3231_dev_t *rtc)
     }
 }
 
+// Press-to-pixel latency: the event time of the last handled input, cleared by
+// the drawing task once a frame showing its effect has been swapped in. The
+// monitor keeps the last and the worst ("#M wake input").
+static volatile uint32_t input_mark_us = 0;
+static int64_t frame_end_us = 0;
+
+static void note_input(const button_event_t *ev)
+{
+    input_mark_us = (uint32_t)ev->time_us | 1;   // never 0
+    if (drawing_handle)
+        xTaskNotify(drawing_handle, NOTIFY_INPUT, eSetBits);
+}
+
+static void note_frame_presented(void)
+{
+    frame_end_us = esp_timer_get_time();
+
+    uint32_t mark = input_mark_us;
+    if (!mark) return;
+
+    input_mark_us = 0;
+    monitor_wake(MONITOR_WAKE_INPUT, frame_end_us - (uint32_t)((uint32_t)frame_end_us - mark));
+}
+
 static void menu_task(void *arg)
 {
     ds3231_dev_t *rtc = (ds3231_dev_t *)arg;
-
-    static TickType_t press_start[3] = {0,0,0}; 
-    static button_t last_btn = -1;
-    static TickType_t repeat_time = 0;
-    bool menu_entering = false; 
-    bool ignore_release = false; // ✅ new flag
+    QueueHandle_t queue = buttons_queue();
 
     while(1)
     {
-        button_t btn;
-        TickType_t now = xTaskGetTickCount();
+        button_event_t ev;
 
-        if (xQueueReceive(button_queue, &btn, pdMS_TO_TICKS(10))) 
-        {
-            // Debounce
-            if ((now - press_start[btn]) < pdMS_TO_TICKS(DEBOUNCE_MS))
-                continue;
+        // Sleep until an event arrives; only an open menu needs a wakeup for its timeout
+        TickType_t wait = portMAX_DELAY;
+        if (menu_active) {
+            int64_t left_us = MENU_TIMEOUT_US - (esp_timer_get_time() - last_button_time);
+            wait = left_us > 0 ? pdMS_TO_TICKS(left_us / 1000) + 1 : 0;
+        }
 
-            press_start[btn] = now;
-            last_btn = btn;
-            repeat_time = now + pdMS_TO_TICKS(REPEAT_DELAY);
+        if (xQueueReceive(queue, &ev, wait))
+        {
+            button_t btn = (button_t)ev.id;
+            monitor_wake(MONITOR_WAKE_MENU, ev.time_us);
 
             if (!menu_active) {
-                // Require 1s hold to enter menu
-                if (btn == BTN_MENU) {
-                    menu_entering = true;
-                }
-                else if (btn == BTN_UP) {
-                    mode_entering = true;
-                }
-                else if (btn == BTN_DOWN) {
-                    format_entering = true;
-                }
-            } else {
-                // Inside menu
-                if (!(btn == BTN_MENU && ignore_release)) {
+                // Hold to enter menu / change mode / toggle format
+                if (ev.type == BUTTON_EVT_LONG) {
+                    TRACE_BEGIN(TRACE_MENU_INPUT);
                     handle_menu_button(btn, rtc);
+                    TRACE_END(TRACE_MENU_INPUT);
+                    note_input(&ev);
                 }
+            } else if (ev.type == BUTTON_EVT_PRESS ||
+                       (ev.type == BUTTON_EVT_REPEAT && btn != BTN_MENU)) {
+                // Inside menu. The hold that opened it produces no PRESS, so
+                // its release can't advance the menu.
+                last_button_time = esp_timer_get_time();
+                TRACE_BEGIN(TRACE_MENU_INPUT);
+                handle_menu_button(btn, rtc);
+                TRACE_END(TRACE_MENU_INPUT);
+                note_input(&ev);
             }
         }
-        else
-        {
-            // Check hold for entering menu
-            if (menu_entering && !gpio_get_level(PIN_MENU)) {
-                if ((now - press_start[BTN_MENU]) >= pdMS_TO_TICKS(1000)) {
-                    handle_menu_button(BTN_MENU, rtc); // enter menu
-                    menu_entering = false;
-                    ignore_release = true; // ✅ block next release
-                    last_btn = -1;
-                }
-            }
-            
-            // Check hold for entering mode
-            if (mode_entering && !gpio_get_level(PIN_UP)) {
-                if ((now - press_start[BTN_UP]) >= pdMS_TO_TICKS(1000)) {
-                    handle_menu_button(BTN_UP, rtc); // enter menu
-                    mode_entering = false;
-                    ignore_release = true; // ✅ block next release
-                    last_btn = -1;
-                }
-            }
-            
-            // Check hold for entering format
-            if (format_entering && !gpio_get_level(PIN_DOWN)) {
-                if ((now - press_start[BTN_DOWN]) >= pdMS_TO_TICKS(1000)) {
-                    handle_menu_button(BTN_DOWN, rtc); // enter menu
-                    format_entering = false;
-                    ignore_release = true; // ✅ block next release
-                    last_btn = -1;
-                }
-            }
-
-			// When handling auto-repeat
-			if (menu_active && last_btn != -1 && 
-			    (now - press_start[last_btn]) >= pdMS_TO_TICKS(REPEAT_DELAY)) 
-			{
-			    if ((now - repeat_time) >= pdMS_TO_TICKS(REPEAT_RATE)) {
-			        handle_menu_button(last_btn, rtc);
-			        last_button_time = esp_timer_get_time(); // ✅ refresh timeout only on repeat
-			        repeat_time = now;
-			    }
-			}
-        }
-
-        // Reset if all released
-        if (gpio_get_level(PIN_MENU) && gpio_get_level(PIN_UP) && gpio_get_level(PIN_DOWN)) {
-            last_btn = -1;
-            menu_entering = false;
-            mode_entering = false;
-            format_entering = false;
-            ignore_release = false; // ✅ clear block when all buttons released
-        }
 
         // Timeout exit
         if (menu_active) {
@@ -438,8 +401,6 @@ static void menu_task(void *arg)
                 stop_flag = false;
             }
         }
-
-        vTaskDelay(pdMS_TO_TICKS(50));
     }
 }
 
@@ -452,43 +413,74 @@ static void menu_task(void *arg)
 
 static ds18b20_t sensor;
 
-static int16_t current_temp = 0;
-static bool temp_valid = false;
+// Probes on the shared 1-Wire pin, in ROM search order
+typedef struct {
+    const char *name;
+    int16_t temp_q4;   // 1/16 °C (DS18B20_FRAC_BITS)
+    bool valid;
+} temp_probe_t;
+
+static temp_probe_t probes[] = {
+    { "cabinet", 0, false },   // shown on the display
+    { "ambient", 0, false },
+    { "psu",     0, false },
+};
+
+#define N_PROBES  (sizeof(probes) / sizeof(probes[0]))
+
+#define TEMP_RESOLUTION   12     // 9..12 bits: 94 / 188 / 375 / 750 ms per conversion
+#define TEMP_PERIOD_MS    5000
+
+
+// Runs in temp_task, only when the shown degree, colour band or validity changes
+static void on_temp_change(const temp_reading_t *reading, void *arg)
+{
+    if (drawing_handle)
+        xTaskNotify(drawing_handle, NOTIFY_TEMP_CHANGED, eSetBits);
+}
 
 void temp_task(void *arg)
 {
-    const TickType_t period = pdMS_TO_TICKS(5000);
+    const TickType_t period = pdMS_TO_TICKS(TEMP_PERIOD_MS);
     TickType_t last_wake = xTaskGetTickCount();
 
     while (1)
     {
-        int16_t t;
+        // One broadcast conversion serves every probe on the pin
+        TRACE_BEGIN(TRACE_TEMP_CONVERT);
+        bool converted = (ds18b20_start_conversion(&sensor) == ESP_OK) &&
+                         (ds18b20_wait_conversion(&sensor) == ESP_OK);
+        TRACE_END(TRACE_TEMP_CONVERT);
 
-        // Start measurement
-        if (ds18b20_start_conversion(&sensor) == ESP_OK)
+        int n = sensor.count ? sensor.count : 1;   // 0 = single sensor via SKIP_ROM
+
+        TRACE_BEGIN(TRACE_TEMP_READ);
+        for (int i = 0; i < (int)N_PROBES; i++)
         {
-            vTaskDelay(pdMS_TO_TICKS(750)); // conversion time
+            int16_t t;
 
-            if (ds18b20_read_scratchpad_temp(&sensor, &t) == ESP_OK)
+            if (converted && i < n &&
+                ds18b20_read_scratchpad_fixed(&sensor, i, &t) == ESP_OK)
             {
-                current_temp = t;
-
-                if (current_temp < -9)
-                    current_temp = -9;
-
-                temp_valid = true;
+                probes[i].temp_q4 = t;
+                probes[i].valid = true;
             }
             else
             {
-                temp_valid = false;
+                probes[i].valid = false;
             }
         }
-        else
-        {
-            temp_valid = false;
-        }
+
+        TRACE_END(TRACE_TEMP_READ);
+
+        temp_pipeline_push(probes[0].temp_q4, probes[0].valid);
+
+        // Due at the next period boundary (tick resolution); an overrun is due now
+        int32_t ticks_left = (int32_t)(last_wake + period - xTaskGetTickCount());
+        int64_t due_us = esp_timer_get_time() + (int64_t)ticks_left * portTICK_PERIOD_MS * 1000;
 
         vTaskDelayUntil(&last_wake, period);
+        monitor_wake(MONITOR_WAKE_TEMP, due_us);
     }
 }
 
@@ -515,7 +507,7 @@ display_mode_t_0 mode0 = ROTATION;
 
 
 const char *dias_semana[] = {
-    "DOMINGO", "LUNES", "MARTES", "MIERCOLES", "JUEVES", "VIERNES", "SABADO"
+    "DOMINGO", "LUNES", "MARTES", "MIÉRCOLES", "JUEVES", "VIERNES", "SÁBADO"
 };
 
 const char *meses[] = {
@@ -523,134 +515,238 @@ const char *meses[] = {
     "JULIO", "AGOSTO", "SEPTIEMBRE", "OCTUBRE", "NOVIEMBRE", "DICIEMBRE"
 };
 
+// Colour per temp_band_t
+static const uint8_t temp_band_rgb[][3] = {
+    { 255, 255, 255 },   // white
+    {   0, 255, 255 },   // cyan
+    { 255,  65,   0 },   // orange
+    { 255,   0,   0 },   // red
+};
+
+// What the scenes show for the temperature, refreshed only on NOTIFY_TEMP_CHANGED
+static struct {
+    bool valid;
+    int16_t value;
+    int r, g, b;
+} temp_view = { false, 0, 255, 255, 255 };
+
+static void update_temp_view(void)
+{
+    // Clear only our bit; NOTIFY_INPUT may be pending for the menu loop
+    if (!(ulTaskNotifyValueClear(NULL, NOTIFY_TEMP_CHANGED) & NOTIFY_TEMP_CHANGED))
+        return;
+
+    temp_reading_t reading;
+    temp_pipeline_get(&reading);
+
+    temp_view.valid = reading.valid;
+    temp_view.value = reading.display_c;
+    temp_view.r = temp_band_rgb[reading.band][0];
+    temp_view.g = temp_band_rgb[reading.band][1];
+    temp_view.b = temp_band_rgb[reading.band][2];
+}
+
+// ------------ Layout cache keys -------------
+// Each formatted string is rebuilt only when the key of what it shows changes
+
+static int display_hour(const ds3231_time_t *time)
+{
+    if (clock_format) return time->hour;
+    int hour12 = time->hour % 12;
+    return hour12 ? hour12 : 12;
+}
+
+static uint32_t date_key(const ds3231_time_t *time)
+{
+    return ((uint32_t)time->year << 12) | (time->month << 8) | (time->day << 3) |
+           (((time->day_of_week - 1) % 7) & 7);
+}
+
+static uint32_t temp_key(void)
+{
+    return temp_view.valid ? (0x10000u | (uint16_t)temp_view.value) : 0;
+}
+
+// "DIA N MES AAAA", scrolled by the TIME and DATE scenes
+static const text_layout_t *date_line(const ds3231_time_t *time)
+{
+    static text_layout_t date_txt;
+    uint32_t key = date_key(time);
+    if (text_layout_stale(&date_txt, key)) {
+        char buf_date[TEXT_LAYOUT_MAX];
+        snprintf(buf_date, sizeof(buf_date), "%s %d %s %04d",
+                 dias_semana[(time->day_of_week - 1) % 7],
+                 time->day,
+                 meses[time->month - 1],
+                 time->year);
+        text_layout_set(&date_txt, key, buf_date, TEXT_ADVANCE, TEXT_ALIGN_LEFT, 0, 0);
+    }
+    return &date_txt;
+}
+
+// Full-screen overlay (startup, menu, MODO / 24HRS messages) hides the scene layers
+static void overlay_begin(void)
+{
+    led_panel_claim(portMAX_DELAY);
+    compositor_transition_stop();
+    compositor_set_visible(LAYER_BACKGROUND, false);
+    compositor_set_visible(LAYER_CONTENT, false);
+    compositor_set_visible(LAYER_OVERLAY, true);
+    compositor_begin(LAYER_OVERLAY, true);
+}
+
+static void overlay_present(void)
+{
+    compositor_end();
+    compositor_present();
+    led_panel_release();
+    note_frame_presented();
+}
+
+// Static parts of a scene; redrawn only when the scene or the temperature colour changes
+static void draw_background(display_mode_t mode)
+{
+    static int bg_mode = -1;
+    static int bg_r = -1, bg_g = -1, bg_b = -1;
+
+    if ((int)mode == bg_mode && temp_view.r == bg_r && temp_view.g == bg_g && temp_view.b == bg_b)
+        return;
+    bg_mode = mode;
+    bg_r = temp_view.r;
+    bg_g = temp_view.g;
+    bg_b = temp_view.b;
+
+    compositor_begin(LAYER_BACKGROUND, true);
+    switch (mode) {
+        case DISPLAY_LOGO:
+            draw_bitmap_rgb(0,0,logo_bitmap, LOGO_WIDTH, LOGO_HEIGHT);
+            break;
+        case DISPLAY_DATE:
+            draw_text_4(57, 26, "#" , bg_r, bg_g, bg_b); // DEGREE SYMBOL
+            draw_text_6(60 , 26, "$", bg_r, bg_g, bg_b); // CELSIUS
+            break;
+        default:
+            break;
+    }
+    compositor_end();
+}
+
+// The logo's gradients need more than 3 bits: quantize it once into dithered
+// sub-frames and leave it to the refresh task until the next swap
+static bool show_dithered_logo(void)
+{
+    if (dither_active()) return true;
+    if (!dither_begin()) return false;
+    draw_bitmap_rgb(0,0,logo_bitmap, LOGO_WIDTH, LOGO_HEIGHT);
+    dither_present();
+    return true;
+}
+
 void draw_display(display_mode_t mode, ds3231_time_t *time)
 {
-    clear_back_buffer();
-    
-    int r_temp = 0;
-    int g_temp = 0;
-    int b_temp = 0;            
-    
-    if(current_temp < 10)
-    {
-		r_temp = 255; g_temp = 255; b_temp = 255;	// temp in white
-	} else if (current_temp > 9 && current_temp < 20)
-	{
-		r_temp = 0; g_temp = 255; b_temp = 255;  // temp in cyan
-	} else if (current_temp > 19 && current_temp < 30)
-	{
-		r_temp = 255; g_temp = 65; b_temp = 0;  // temp in orange
-	} else
-	{
-		r_temp = 255; g_temp = 0; b_temp = 0;  // temp in red				
-	}
+    // Frame start vs DRAW_FRAME_MS after the last frame (RTC read included);
+    // longer gaps are menu / message pauses, not a late wakeup
+    int64_t start_us = esp_timer_get_time();
+    if (frame_end_us && start_us - frame_end_us < 4 * DRAW_FRAME_MS * 1000)
+        monitor_wake(MONITOR_WAKE_DRAW, frame_end_us + DRAW_FRAME_MS * 1000);
+
+    // A PC stream owns the panel; skip this frame
+    if (!led_panel_claim(0)) return;
+
+    TRACE_BEGIN(TRACE_DRAW_FRAME);
+    anim_clock_begin_frame(&anim, esp_timer_get_time());
+    update_temp_view();
+
+    // Colon blink: on for the even RTC second, phase taken from when that second
+    // started on the animation clock
+    static int last_second = -1;
+    static int64_t even_second_us = 0;
+    if (time->second != last_second) {
+        last_second = time->second;
+        even_second_us = anim_clock_now(&anim) - (time->second % 2) * 1000000LL;
+    }
+    const bool colon_on = anim_blink_on(anim_clock_now(&anim), even_second_us, 2000000, 1000000);
+
+    // Scene change: blend from what is on screen into the new scene
+    static int shown_mode = -1;
+    static int64_t trans_start_us = 0;
+    static transition_kind_t next_kind = TRANSITION_SLIDE;
+    bool scene_changed = (int)mode != shown_mode;
+    bool first_scene = shown_mode < 0;
+    shown_mode = mode;
+
+    if (mode == DISPLAY_LOGO && show_dithered_logo()) {
+        compositor_transition_stop();   // the dithered logo bypasses the compositor: hard cut
+        led_panel_release();
+        TRACE_END(TRACE_DRAW_FRAME);
+        note_frame_presented();
+        return;
+    }
+
+    if (scene_changed && !first_scene && compositor_transition_start(next_kind) == ESP_OK) {
+        trans_start_us = anim_clock_now(&anim);
+        next_kind = next_kind % (TRANSITION_KINDS - 1) + 1;   // take turns
+    }
+    compositor_transition_progress(anim_progress(anim_clock_now(&anim), trans_start_us,
+                                                 SCENE_TRANSITION_MS * 1000));
+    dither_stop();
+
+    compositor_set_visible(LAYER_OVERLAY, false);
+    compositor_set_visible(LAYER_BACKGROUND, true);
+    compositor_set_visible(LAYER_CONTENT, true);
+    draw_background(mode);
+
+    compositor_begin(LAYER_CONTENT, true);
+    bool rgb = CONTENT_RGB_CANVAS && rgb_canvas_begin();
+
+    const int r_temp = temp_view.r;
+    const int g_temp = temp_view.g;
+    const int b_temp = temp_view.b;
 
     switch (mode) {
         case DISPLAY_LOGO:{  
-            // other modes...
-            draw_bitmap_rgb(0,0,logo_bitmap, LOGO_WIDTH, LOGO_HEIGHT);
+            // logo lives in the background layer
             break;
         }
         
-                case DISPLAY_TIME: {	
-            
-            
-            
-            
-            
+        case DISPLAY_TIME: {
             // --- Time ---
-            int hour12 = 0;
-            
-            if (!clock_format){
-				hour12 = time->hour % 12;
-				if (hour12 == 0) hour12 = 12;	
-			} else {
-				hour12 = time->hour;
-			}
-			
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
+            static text_layout_t time_txt;
+            int hour12 = display_hour(time);
+            uint32_t key = (hour12 << 16) | (time->minute << 8) | time->second;
 
-            char buf_time[16];
-            if (hour12 < 10) {
-                snprintf(buf_time, sizeof(buf_time), " %1d:%02d:%02d" ,
-                         hour12, time->minute, time->second);
-            } else {
-                snprintf(buf_time, sizeof(buf_time), "%02d:%02d:%02d" ,
+            if (text_layout_stale(&time_txt, key)) {
+                char buf_time[16];
+                snprintf(buf_time, sizeof(buf_time), hour12 < 10 ? " %1d:%02d:%02d" : "%02d:%02d:%02d",
                          hour12, time->minute, time->second);
+                text_layout_set(&time_txt, key, buf_time, TEXT_ADVANCE, TEXT_ALIGN_LEFT, 4, 0);
             }
-
-            draw_text(4, 1, buf_time, 255, 255, 255); // time in white
+            draw_glyphs(time_txt.x, 1, time_txt.glyph, time_txt.len, 255, 255, 255); // time in white
 
             // --- Temperature ---
-            char buf_temp[16];
-            if (temp_valid) 
-            {
-                
-                snprintf(buf_temp, sizeof(buf_temp), "%d*C", current_temp);                
-                
-            } else 
-            {
-                snprintf(buf_temp, sizeof(buf_temp), "T E");
+            static text_layout_t temp_txt;
+            if (text_layout_stale(&temp_txt, temp_key())) {
+                char buf_temp[16];
+                if (temp_view.valid) {
+                    snprintf(buf_temp, sizeof(buf_temp), "%d°C", temp_view.value);
+                } else {
+                    snprintf(buf_temp, sizeof(buf_temp), "T E");
+                }
+                text_layout_set(&temp_txt, temp_key(), buf_temp, TEXT_ADVANCE, TEXT_ALIGN_LEFT, 20, 0);
             }
-            
-            
-
-			draw_text(20, 22, buf_temp, r_temp, g_temp, b_temp);  				
-			
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
+            draw_glyphs(temp_txt.x, 22, temp_txt.glyph, temp_txt.len, r_temp, g_temp, b_temp);
 
             // --- Date (scrolling) ---
-            int weekday_index = (time->day_of_week - 1) % 7;
-            static char buf_date[64];    
-            //static char last_scrolled_date[64] = "";    
-			snprintf(buf_date, sizeof(buf_date), "%s %d %s %04d",
-			         dias_semana[weekday_index],
-			         time->day,
-			         meses[time->month - 1],
-			         time->year);
-			         
-			         
             if (!scroll_state.active) {
-                scroll_start(buf_date, 12, 0, 255, 0, 10);  
+                scroll_start(date_line(time), 12, 0, 255, 0, 10);
                 // y=8, green, 100 ms per pixel (adjust for speed)
             }
-			         		
-/*
-			// Restart scroll if string changed
-			if (strcmp(buf_date, last_scrolled_date) != 0) {
-			    strcpy(last_scrolled_date, buf_date);
-			    scroll_start(buf_date, 12, 0, 255, 0, 10);  
-			    // y=0, green, 15 px/sec
-			}		
-*/	
+
 			// Update scroll every frame
 			scroll_update();
-            break;        
+            break;
         }
-        
+
 /*
         case DISPLAY_LOGO2:{  
             // other modes...
@@ -660,308 +756,144 @@ void draw_display(display_mode_t mode, ds3231_time_t *time)
 */
       
       
-        case DISPLAY_DATE: { 
-			
-            char buf_hour[5];            
-            char buf_minute[5];            
-            char buf_second[5];            
-            int pos_hour = 0;        
-			bool colon_on = (time->second % 2) == 0;  // blink colon		
-			
-            // --- Time ---
-            int hour12 = 0;
-            
-            if (!clock_format){
-				hour12 = time->hour % 12;
-				if (hour12 == 0) hour12 = 12;	
-				
-				
-				if (time->hour > 11){
-					draw_text_5(51 , 16, "&$", 255, 255, 255); // PM
-				} else {
-					draw_text_5(51 , 16, "#$", 255, 255, 255); // AM
-				}				            
-				
-			} else {
-				hour12 = time->hour;
-				
-			   //------------------------------------------------------------ SECONDS ------------------------------------------					 
-				snprintf(buf_second, sizeof(buf_second), "%02d", time->second);
-				draw_text_5(51 , 16, buf_second, 255, 255, 255); // seconds			                         
-			}   
-			
-			         
- 
- 
- 
-             //------------------------------------------------------------ MINUTES ------------------------------------------
-            snprintf(buf_minute, sizeof(buf_minute), "%02d", time->minute);
- 
- 
- 
- 
-		    pos_hour = 0;                
-            if (time->minute % 10 == 1) pos_hour = 2;
- 
-            
-            if (hour12 < 10) 
-            {
-                //------------------------------------------------------------ HOURS H ------------------------------------------
-                snprintf(buf_hour, sizeof(buf_hour), " %1d", hour12);
-                
-                pos_hour -=1;
-                
-                
-                
-                
-                draw_text_2(pos_hour - 1, 14, buf_hour, 255, 255, 255); // HOUR 
-                       
-            	draw_text_2(27 + pos_hour + 1, 14, buf_minute, 255, 255, 255); // MINUTE 
-                
-                
-                
-                
-                
-            } else 
-            {
-                //------------------------------------------------------------ HOURS HH ------------------------------------------
-                snprintf(buf_hour, sizeof(buf_hour), "%02d", hour12); 
-                
-                //pos_hour = 0;                
-                if (hour12 > 19){
-					pos_hour += 1;
-					if (time->minute % 10 == 1) pos_hour -= 1;
-				} 
-                
-                 
-                
-                
-                draw_text_2(pos_hour, 14, buf_hour, 255, 255, 255); // HOUR         
-            	draw_text_2(27 + pos_hour, 14, buf_minute, 255, 255, 255); // MINUTE 
-                
-                
-                
-            }             
-
- 
+        case DISPLAY_DATE: {
+            int hour12 = display_hour(time);
 
+            if (!clock_format) {
+				draw_text_5(51 , 16, time->hour > 11 ? "&$" : "#$", 255, 255, 255); // PM / AM
+			} else {
+			   //------------------------------------------------------------ SECONDS ------------------------------------------
+				static text_layout_t sec_txt;
+				if (text_layout_stale(&sec_txt, time->second)) {
+					char buf_second[5];
+					snprintf(buf_second, sizeof(buf_second), "%02d", time->second);
+					text_layout_set(&sec_txt, time->second, buf_second, TEXT_ADVANCE_5, TEXT_ALIGN_LEFT, 51, 0);
+				}
+				draw_text_5(sec_txt.x, 16, sec_txt.text, 255, 255, 255); // seconds
+			}
 
+            //------------------------------------------------------- HOURS / MINUTES ---------------------------------------
+            // Hand-kerned: a narrow "1" in the minutes and wide hours shift the whole clock
+            static text_layout_t hour_txt, minute_txt;
+            static int pos_hour = 0;
+            uint32_t key = (hour12 << 8) | time->minute;
+
+            if (text_layout_stale(&hour_txt, key)) {
+                char buf_hour[5];
+                char buf_minute[5];
+                snprintf(buf_minute, sizeof(buf_minute), "%02d", time->minute);
+
+                pos_hour = (time->minute % 10 == 1) ? 2 : 0;
+                int x_hour, x_minute;
+                if (hour12 < 10) {
+                    snprintf(buf_hour, sizeof(buf_hour), " %1d", hour12);
+                    pos_hour -= 1;
+                    x_hour   = pos_hour - 1;
+                    x_minute = 27 + pos_hour + 1;
+                } else {
+                    snprintf(buf_hour, sizeof(buf_hour), "%02d", hour12);
+                    if (hour12 > 19) {
+                        pos_hour += 1;
+                        if (time->minute % 10 == 1) pos_hour -= 1;
+                    }
+                    x_hour   = pos_hour;
+                    x_minute = 27 + pos_hour;
+                }
+                text_layout_set(&hour_txt, key, buf_hour, TEXT_ADVANCE_2, TEXT_ALIGN_LEFT, x_hour, 0);
+                text_layout_set(&minute_txt, key, buf_minute, TEXT_ADVANCE_2, TEXT_ALIGN_LEFT, x_minute, 0);
+            }
+            draw_text_2(hour_txt.x, 14, hour_txt.text, 255, 255, 255);       // HOUR
+            draw_text_2(minute_txt.x, 14, minute_txt.text, 255, 255, 255);   // MINUTE
 
-            
-            
-            
-            
-            
-            
             if (!clock_format) {
 				draw_text_4(23 + pos_hour , 17, colon_on ? "!" : " " , 255, 255, 255); // 	COLON BLINK
 			} else {
-				draw_text_4(23 + pos_hour , 17,  "!" , 255, 255, 255); // COLON FIXED	
+				draw_text_4(23 + pos_hour , 17,  "!" , 255, 255, 255); // COLON FIXED
 			}
-                  
-                   
 
-
-
-
-
-
-
-
-
-
-            
-            //----------------------------------TEMPERATURE SECTION .............!!!!  
-                        // --- Temperature ---
-            char buf_temp[20];
-             if (temp_valid) 
-            {
-                snprintf(buf_temp, sizeof(buf_temp), "%d*", current_temp);
-                
-                
-            }  else 
-            {
-                snprintf(buf_temp, sizeof(buf_temp), "T E");
-                
-            } 
-                       
-            //draw_text_2(43, 15, buf_temp, 255, 0, 0);  // temp in red
-            
-            
-            
-
-            draw_text_6(50 , 26, buf_temp, r_temp, g_temp, b_temp); // TEMPERATURE VALUE         
-            draw_text_4(57, 26, "#" , r_temp, g_temp, b_temp); // DEGREE SYMBOL
-            draw_text_6(60 , 26, "$", r_temp, g_temp, b_temp); // CELSIUS
-
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-
-             
-             
-
-            
-            
+            //----------------------------------TEMPERATURE SECTION .............!!!!
+            static text_layout_t temp_txt;
+            if (text_layout_stale(&temp_txt, temp_key())) {
+                char buf_temp[20];
+                if (temp_view.valid) {
+                    snprintf(buf_temp, sizeof(buf_temp), "%d*", temp_view.value);
+                } else {
+                    snprintf(buf_temp, sizeof(buf_temp), "T E");
+                }
+                text_layout_set(&temp_txt, temp_key(), buf_temp, TEXT_ADVANCE_6, TEXT_ALIGN_LEFT, 50, 0);
+            }
+            draw_text_6(temp_txt.x, 26, temp_txt.text, r_temp, g_temp, b_temp); // TEMPERATURE VALUE
+            // degree symbol and C are in the background layer
 
             // --- Date (scrolling) ---
-            int weekday_index = (time->day_of_week - 1) % 7;
-            static char buf_date[64];   
-            //static char last_scrolled_date[64] = "";     
-			snprintf(buf_date, sizeof(buf_date), "%s %d %s %04d",
-			         dias_semana[weekday_index],
-			         time->day,
-			         meses[time->month - 1],
-			         time->year);
-			         
             if (!scroll_state.active) {
-                scroll_start(buf_date, 2, 0, 0, 255, 10);  
+                scroll_start(date_line(time), 2, 0, 0, 255, 10);
                 // y=8, green, 100 ms per pixel (adjust for speed)
             }
-            
-            
-            
 
-            
-            
-	
 			// Update scroll every frame
-			scroll_update();							
+			scroll_update();
             break;
         }
-        
-        
-
-
 
         case DISPLAY_TEMPERATURE: {
-			
-			
-			
 			//-------------------------------------------------------------- DATE ---------------------------------------------------------------------------
-			
-			
-			
-            int weekday_index = (time->day_of_week - 1) % 7;
-            char buf3[32];
-            
-            int pos_day = 0;
-            
-            
-            snprintf(buf3, sizeof(buf3), "%s",dias_semana[weekday_index]);
-            
-            
-            
-            
-            if (weekday_index == 0 || weekday_index == 5)
-            {
-				pos_day = 1 + 6*1;
-				
-			} else if (weekday_index == 1)
-			{
-				pos_day = 2 + 6*2;
-				
-			} else if (weekday_index == 2 || weekday_index == 4 || weekday_index == 6 )
-			{
-				pos_day = 1 + 9;
-				
-			} else
-			{
-				pos_day = 0;
-			}
-            
-            
-
-            draw_text(1 + pos_day, 1, buf3, 0, 255, 0);
-            
-            
-            
-            
-            
-            char buf4[32];
-            snprintf(buf4, sizeof(buf4), "%02d-%02d-%02d",
-                     time->day,time->month,
-                     time->year-2000);
+            // Day name centred, date below
+            static text_layout_t day_txt, date_txt;
+            uint32_t dkey = date_key(time);
+            if (text_layout_stale(&day_txt, dkey)) {
+                char buf4[32];
+                text_layout_set(&day_txt, dkey, dias_semana[(time->day_of_week - 1) % 7],
+                                TEXT_ADVANCE, TEXT_ALIGN_CENTER, 0, VIRT_WIDTH);
+                snprintf(buf4, sizeof(buf4), "%02d-%02d-%02d",
+                         time->day, time->month, time->year - 2000);
+                text_layout_set(&date_txt, dkey, buf4, TEXT_ADVANCE, TEXT_ALIGN_LEFT, 4, 0);
+            }
+            draw_glyphs(day_txt.x, 1, day_txt.glyph, day_txt.len, 0, 255, 0);
+            draw_glyphs(date_txt.x, 11, date_txt.glyph, date_txt.len, 0, 0, 255);
 
-            draw_text(4, 11, buf4, 0, 0, 255);//x=6            	
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            		
-			
 			            // --- Time ---
-            int hour12 = 0;
-            
-            if (!clock_format){
-				hour12 = time->hour % 12;
-				if (hour12 == 0) hour12 = 12;	
-			} else {
-				hour12 = time->hour;
-			}
-			
-            
-            
-            
-            
-            
-            
-            
-            
-
-            bool colon_on = (time->second % 2) == 0;  // blink colon
-            char buf_time[16];
-            if (hour12 < 10) {
-                snprintf(buf_time, sizeof(buf_time),
-                         colon_on ? " %1d:%02d" : " %1d %02d",
-                         hour12, time->minute);
-            } else {
-                snprintf(buf_time, sizeof(buf_time),
-                         colon_on ? "%02d:%02d" : "%02d %02d",
-                         hour12, time->minute);
+            static text_layout_t time_txt;
+            int hour12 = display_hour(time);
+            uint32_t key = (hour12 << 16) | (time->minute << 8) | colon_on;
+
+            if (text_layout_stale(&time_txt, key)) {
+                char buf_time[16];
+                if (hour12 < 10) {
+                    snprintf(buf_time, sizeof(buf_time),
+                             colon_on ? " %1d:%02d" : " %1d %02d",
+                             hour12, time->minute);
+                } else {
+                    snprintf(buf_time, sizeof(buf_time),
+                             colon_on ? "%02d:%02d" : "%02d %02d",
+                             hour12, time->minute);
+                }
+                text_layout_set(&time_txt, key, buf_time, TEXT_ADVANCE, TEXT_ALIGN_LEFT, 2, 0);
             }
-
-            draw_text(2, 22, buf_time, 255, 255, 255); // time in white
-
+            draw_glyphs(time_txt.x, 22, time_txt.glyph, time_txt.len, 255, 255, 255); // time in white
 
             // ------------------- Temperature ---------------
-            char buf_temp[16];
-            if (temp_valid) {
-                snprintf(buf_temp, sizeof(buf_temp), "%d*", current_temp);
-            } else {
-                snprintf(buf_temp, sizeof(buf_temp), "T E");
+            static text_layout_t temp_txt;
+            if (text_layout_stale(&temp_txt, temp_key())) {
+                char buf_temp[16];
+                if (temp_view.valid) {
+                    snprintf(buf_temp, sizeof(buf_temp), "%d°", temp_view.value);
+                } else {
+                    snprintf(buf_temp, sizeof(buf_temp), "T E");
+                }
+                text_layout_set(&temp_txt, temp_key(), buf_temp, TEXT_ADVANCE, TEXT_ALIGN_LEFT, 43, 0);
             }
-            draw_text(43, 22, buf_temp, r_temp, g_temp, b_temp);  // temp 
+            draw_glyphs(temp_txt.x, 22, temp_txt.glyph, temp_txt.len, r_temp, g_temp, b_temp);  // temp
             break;
         }
     }
-    swap_buffers();
+    if (rgb) rgb_canvas_end();
+    compositor_end();
+    compositor_present();
+    anim_clock_end_frame(&anim, esp_timer_get_time());
+    led_panel_release();
+    TRACE_END(TRACE_DRAW_FRAME);
+    note_frame_presented();
 }
 
 
@@ -976,18 +908,18 @@ void drawing_task(void *arg)
     const int mode_interval_s = 21;
     
     //vTaskDelay(pdMS_TO_TICKS(250));
-	clear_back_buffer();
+	overlay_begin();
 	draw_bitmap_rgb(0,0,logo_bitmap, LOGO_WIDTH, LOGO_HEIGHT);
-	swap_buffers();
+	overlay_present();
 	vTaskDelay(pdMS_TO_TICKS(3000));
 	
 	
 	
 	char buf[32];
-	clear_back_buffer();
+	overlay_begin();
 	snprintf(buf, sizeof(buf), "MODO:%d", mode0);
     draw_text(8, 8, buf, 255, 0, 0);
-	swap_buffers();
+	overlay_present();
 	vTaskDelay(pdMS_TO_TICKS(3000));
 
     while (1) 
@@ -996,7 +928,7 @@ void drawing_task(void *arg)
 
         if (menu_state != MENU_IDLE)
         {
-            clear_back_buffer();
+            overlay_begin();
             // Draw the menu
             char buf[32];
             switch (menu_state)
@@ -1023,14 +955,16 @@ void drawing_task(void *arg)
                     draw_text(0, 8, buf, 255, 0, 0);
                     break;
                 case MENU_YEAR:
-                    snprintf(buf, sizeof(buf), " A|O:%02d", tmp_time.year-2000);
+                    snprintf(buf, sizeof(buf), " AÑO:%02d", tmp_time.year-2000);
                     draw_text(0, 8, buf, 255, 0, 0);
                     break;
                 default: break;
             }
 
-            swap_buffers();
-            vTaskDelay(pdMS_TO_TICKS(100));
+            overlay_present();
+
+            // Redraw as soon as menu_task handles input, else every 100 ms
+            xTaskNotifyWait(0, NOTIFY_INPUT, NULL, pdMS_TO_TICKS(100));
             continue; // skip normal display
         }
 
@@ -1054,7 +988,7 @@ void drawing_task(void *arg)
 					        draw_display(DISPLAY_LOGO, &now);  // called frequently for smooth blinking
 		
 					        // Small delay to avoid blocking CPU and allow colon toggle
-					        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+					        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 					        TickType_t elapsed = 0;
 					        while (elapsed < delay_ms) {
 					            if (stop_flag) break;  // early exit condition
@@ -1078,7 +1012,7 @@ void drawing_task(void *arg)
 					        draw_display(DISPLAY_TIME, &now);  // called frequently for smooth blinking
 		
 					        // Small delay to avoid blocking CPU and allow colon toggle
-					        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+					        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 					        TickType_t elapsed = 0;
 					        while (elapsed < delay_ms) {
 					            if (stop_flag) break;  // early exit condition
@@ -1104,7 +1038,7 @@ void drawing_task(void *arg)
 					        draw_display(DISPLAY_LOGO2, &now);  // called frequently for smooth blinking
 		
 					        // Small delay to avoid blocking CPU and allow colon toggle
-					        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+					        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 					        TickType_t elapsed = 0;
 					        while (elapsed < delay_ms) {
 					            if (stop_flag) break;  // early exit condition
@@ -1130,7 +1064,7 @@ void drawing_task(void *arg)
 					        draw_display(DISPLAY_DATE, &now);  // called frequently for smooth blinking
 		
 					        // Small delay to avoid blocking CPU and allow colon toggle
-					        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+					        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 					        TickType_t elapsed = 0;
 					        while (elapsed < delay_ms) {
 					            if (stop_flag) break;  // early exit condition
@@ -1154,7 +1088,7 @@ void drawing_task(void *arg)
 					        draw_display(DISPLAY_TEMPERATURE, &now);  // called frequently for smooth blinking
 		
 					        // Small delay to avoid blocking CPU and allow colon toggle
-					        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+					        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 					        TickType_t elapsed = 0;
 					        while (elapsed < delay_ms) {
 					            if (stop_flag) break;  // early exit condition
@@ -1183,7 +1117,7 @@ void drawing_task(void *arg)
 			        draw_display(DISPLAY_LOGO, &now);  // called frequently for smooth blinking
 
 			        // Small delay to avoid blocking CPU and allow colon toggle
-			        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+			        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 			        TickType_t elapsed = 0;
 			        while (elapsed < delay_ms) {
 			            if (stop_flag) break;  // early exit condition
@@ -1205,7 +1139,7 @@ void drawing_task(void *arg)
 			        draw_display(DISPLAY_TIME, &now);  // called frequently for smooth blinking
 
 			        // Small delay to avoid blocking CPU and allow colon toggle
-			        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+			        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 			        TickType_t elapsed = 0;
 			        while (elapsed < delay_ms) {
 			            if (stop_flag) break;  // early exit condition
@@ -1228,7 +1162,7 @@ void drawing_task(void *arg)
 			        draw_display(DISPLAY_LOGO, &now);  // called frequently for smooth blinking
 
 			        // Small delay to avoid blocking CPU and allow colon toggle
-			        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+			        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 			        TickType_t elapsed = 0;
 			        while (elapsed < delay_ms) {
 			            if (stop_flag) break;  // early exit condition
@@ -1250,7 +1184,7 @@ void drawing_task(void *arg)
 			        draw_display(DISPLAY_DATE, &now);  // called frequently for smooth blinking
 
 			        // Small delay to avoid blocking CPU and allow colon toggle
-			        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+			        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 			        TickType_t elapsed = 0;
 			        while (elapsed < delay_ms) {
 			            if (stop_flag) break;  // early exit condition
@@ -1273,7 +1207,7 @@ void drawing_task(void *arg)
 			        draw_display(DISPLAY_LOGO, &now);  // called frequently for smooth blinking
 
 			        // Small delay to avoid blocking CPU and allow colon toggle
-			        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+			        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 			        TickType_t elapsed = 0;
 			        while (elapsed < delay_ms) {
 			            if (stop_flag) break;  // early exit condition
@@ -1295,7 +1229,7 @@ void drawing_task(void *arg)
 			        draw_display(DISPLAY_TEMPERATURE, &now);  // called frequently for smooth blinking
 
 			        // Small delay to avoid blocking CPU and allow colon toggle
-			        TickType_t delay_ms = 50; // update every 50ms (20Hz)
+			        TickType_t delay_ms = DRAW_FRAME_MS; // update every 50ms (20Hz)
 			        TickType_t elapsed = 0;
 			        while (elapsed < delay_ms) {
 			            if (stop_flag) break;  // early exit condition
@@ -1314,10 +1248,10 @@ void drawing_task(void *arg)
 			format_flag = false;
 			stop_flag = false;			
 			clock_format = 1 - clock_format;  // always toggles 0↔1					
-			save_format(clock_format);			
-			clear_back_buffer();			
+			settings_set_format(clock_format);			
+			overlay_begin();
             draw_text(1 , 8, !clock_format ? "24HRS:OFF" : "24HRS:ON" , 255, 0, 0);                       
-			swap_buffers();
+			overlay_present();
 			vTaskDelay(pdMS_TO_TICKS(1000));			
 		}				
 				
@@ -1327,13 +1261,13 @@ void drawing_task(void *arg)
 			mode_flag = false;
 			stop_flag = false;
 			mode0++;
-			save_mode(mode0);
+			settings_set_mode(mode0);
 			
 			char buf[32];
-			clear_back_buffer();
+			overlay_begin();
 			snprintf(buf, sizeof(buf), "MODO:%d", mode0);
             draw_text(8, 8, buf, 255, 0, 0);
-			swap_buffers();
+			overlay_present();
 			vTaskDelay(pdMS_TO_TICKS(1000));
 			
 		} 		
@@ -1346,18 +1280,51 @@ void drawing_task(void *arg)
 }
 
 
+// Settings commits hand the panel over to the IRAM scan while flash is written
+static const settings_flash_guard_t panel_flash_guard = {
+	.begin = led_panel_flash_begin,
+	.end   = led_panel_flash_end,
+};
+
+// Driver installs for irq_core_call: the interrupt lands on the core that runs them
+static esp_err_t install_rtc(void *rtc)
+{
+	return init_ds3231(rtc);
+}
+
+static esp_err_t install_uart_stream(void *arg)
+{
+	return uart_stream_start();
+}
+
 // ---------------- example usage in app_main ----------------
 void app_main(void)
 {
+	if (settings_init(NULL) != ESP_OK) {
+		ESP_LOGW("MAIN", "Settings store unavailable, using defaults");
+	}
+
+	settings_t cfg = settings_get();
+
+	// Panel geometry must be set before anything sizes tables or buffers from it
+	panel_geometry_t geom = {
+		.panel_width  = cfg.panel_width  ? cfg.panel_width  : DEFAULT_PANEL_WIDTH,
+		.panel_height = cfg.panel_height ? cfg.panel_height : DEFAULT_PANEL_HEIGHT,
+		.scan         = cfg.panel_scan   ? cfg.panel_scan   : DEFAULT_PANEL_SCAN,
+		.n_hor        = cfg.n_hor        ? cfg.n_hor        : DEFAULT_N_HOR,
+		.n_ver        = cfg.n_ver        ? cfg.n_ver        : DEFAULT_N_VER,
+	};
+	if (led_panel_set_geometry(&geom) != ESP_OK) {
+		ESP_LOGW("MAIN", "Stored panel geometry rejected, using defaults");
+	}
+
     init_pins();
 
 	init_oe_pwm();           // initialize OE PWM
 	//set_global_brightness(100);  // 50% brightness
-
-	init_nvs_brightness();
 	
 	
-	brightness_level = load_brightness();
+	brightness_level = cfg.brightness;
 	
 	if (brightness_level > 10) brightness_level = 10;
 	
@@ -1366,19 +1333,19 @@ void app_main(void)
 	
 	
 	
-	mode0 = load_mode(); 
+	mode0 = cfg.mode; 
 	
 	if (mode0 > 4) mode0 = 4;
 	
 	
-	clock_format = load_format();
+	clock_format = cfg.format;
 	
 	
 	if (clock_format > 1) clock_format = 0; 
 
 
     ds3231_dev_t rtc;
-    ESP_ERROR_CHECK(init_ds3231(&rtc));
+    ESP_ERROR_CHECK(irq_core_call(IRQ_CORE_I2C, install_rtc, &rtc));
 
     //ds18b20_init(&sensor, GPIO_NUM_27); // Use GPIO4 with 4.7kΩ pull-up resistor
     
@@ -1386,6 +1353,10 @@ void app_main(void)
     ESP_LOGW("MAIN", "DS18B20 init issue");
 }
 
+    if (sensor.present && ds18b20_set_resolution(&sensor, TEMP_RESOLUTION) != ESP_OK) {
+        ESP_LOGW("MAIN", "DS18B20 resolution not set");
+    }
+
 	ds3231_time_t now;
 	ds3231_get_time(&rtc, &now);
 
@@ -1395,28 +1366,45 @@ void app_main(void)
     	ESP_ERROR_CHECK(ds3231_set_time(&rtc, &set_time));
 	}
 
-	init_planes();
+	ESP_ERROR_CHECK(init_planes());   // both buffers start cleared
+	ESP_ERROR_CHECK(compositor_init());
+	if (dither_init() != ESP_OK) {
+		ESP_LOGW("MAIN", "Dithering unavailable, logo shown at 3 bits");
+	}
+	if (CONTENT_RGB_CANVAS && rgb_canvas_init(CANVAS_RGB565) != ESP_OK) {
+		ESP_LOGW("MAIN", "RGB canvas unavailable, drawing planes directly");
+	}
 
-    // Clear both buffers first time
-    memset((void*)fbA, 0, sizeof(fbA));
-    memset((void*)fbB, 0, sizeof(fbB));
+	ESP_ERROR_CHECK(irq_core_call(IRQ_CORE_GPIO, init_buttons, NULL));
 
-	init_buttons();
+	if (irq_core_call(IRQ_CORE_UART, install_uart_stream, NULL) != ESP_OK) {
+		ESP_LOGW("MAIN", "UART frame stream unavailable");
+	}
 
-    // Start refresh task (pin-driving) on core 0
-	xTaskCreatePinnedToCore(refresh_task, "refresh_task", 2048, NULL, 1, NULL, 0);
+    // Start refresh task (pin-driving) on its own core, away from the interrupts
+	xTaskCreatePinnedToCore(refresh_task, "refresh_task", 2048, NULL, 1, NULL, IRQ_CORE_REFRESH);
+	settings_set_flash_guard(&panel_flash_guard);
 
-	xTaskCreatePinnedToCore(drawing_task, "DrawTime", 4096, &rtc, 1, NULL, 1);
+	xTaskCreatePinnedToCore(drawing_task, "DrawTime", 4096, &rtc, 1, &drawing_handle, 1);
 	
-	xTaskCreatePinnedToCore(temp_task,      "TempTask",      1024, NULL, 2, NULL, 1);
+	temp_pipeline_init(on_temp_change, NULL);
+	xTaskCreatePinnedToCore(temp_task,      "TempTask",      2048, NULL, 2, NULL, 1);
 
 	xTaskCreatePinnedToCore(menu_task, "MenuTask", 4096, &rtc, 2, NULL, 1);
 
+	if (monitor_start() != ESP_OK) {
+		ESP_LOGW("MAIN", "Task monitor unavailable");
+	}
+	irq_core_dump();
 
+	// Waits for refresh_task's first measured pass, so an unreachable target is reported
+	led_panel_set_refresh_target(cfg.refresh_hz ? cfg.refresh_hz : REFRESH_TARGET_HZ);
+
+	// rtc lives on this stack: park the task instead of returning (it used to
+	// wake every tick for nothing)
     while (true) 
 	{
-        vTaskDelay(pdMS_TO_TICKS(1));
-
+        vTaskDelay(portMAX_DELAY);
     }
 }
 
@@ -0,0 +1,18 @@
+#pragma once
+#include <time.h>
+
+// Wall-clock timing for the bench_* programs. They print their numbers and
+// exit 0; they are built with the tests but not run by ctest.
+
+static inline double bench_now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// Keep a result alive so the timed loop is not optimised away
+static inline void bench_keep(const void *p)
+{
+    __asm__ volatile("" : : "r"(p) : "memory");
+}
@@ -0,0 +1,96 @@
+// Canvas conversion (user-034): a 64x32 frame of random colours through
+// canvas_convert_rgb565/888 against a per-pixel reference (the gamma and plane
+// packing set_pixel does), then the time per frame of each against drawing the
+// same frame with the real set_pixel.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "host_panel.h"
+#include "led_panel.h"
+#include "canvas_convert.h"
+
+#define W        64
+#define H        32
+#define N        (W * H)
+#define FRAMES   5000
+
+static canvas_luts_t luts;
+static uint8_t rgb[N * 3];
+static uint16_t px565[N];
+static uint8_t planes[COLOR_DEPTH][N] __attribute__((aligned(4)));
+static uint8_t ref[COLOR_DEPTH][N];
+
+static void ref_pixel(int i, int r8, int g8, int b8)
+{
+    uint8_t rQ = gamma_table[r8], gQ = gamma_table[g8], bQ = gamma_table[b8];
+    for (int p = 0; p < COLOR_DEPTH; p++)
+        ref[p][i] = (((rQ >> p) & 1) ? 0x01 : 0) | (((gQ >> p) & 1) ? 0x02 : 0) | (((bQ >> p) & 1) ? 0x04 : 0);
+}
+
+static int check(const char *what, uint8_t cover)
+{
+    int bad = 0;
+    for (int i = 0; i < N; i++) {
+        int any = 0;
+        for (int p = 0; p < COLOR_DEPTH; p++) any |= ref[p][i];
+        for (int p = 0; p < COLOR_DEPTH; p++)
+            bad += planes[p][i] != (ref[p][i] | (any ? cover : 0));
+    }
+    printf("%-6s %s\n", what, bad ? "DIFFER" : "match");
+    return bad;
+}
+
+int main(void)
+{
+    init_planes();
+    canvas_build_luts(&luts, gamma_table, COLOR_DEPTH);
+    uint8_t *const out[COLOR_DEPTH] = { planes[0], planes[1], planes[2] };
+
+    for (int i = 0; i < N * 3; i++) rgb[i] = rand();
+    int bad = 0;
+
+    for (int i = 0; i < N; i++) ref_pixel(i, rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+    canvas_convert_rgb888(&luts, rgb, N, out, COLOR_DEPTH, 0);
+    bad += check("rgb888", 0);
+
+    // 565 loses the low bits: the reference widens them back the way the LUTs do
+    for (int i = 0; i < N; i++) {
+        uint16_t c = px565[i] = canvas_rgb565(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+        int r = c >> 11, g = (c >> 5) & 63, b = c & 31;
+        ref_pixel(i, (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+    }
+    canvas_convert_rgb565(&luts, px565, N, out, COLOR_DEPTH, 0);
+    bad += check("rgb565", 0);
+    canvas_convert_rgb565(&luts, px565, N, out, COLOR_DEPTH, 0x08);
+    bad += check("cover", 0x08);
+
+    double t0 = bench_now_us();
+    for (int k = 0; k < FRAMES; k++) {
+        canvas_convert_rgb565(&luts, px565, N, out, COLOR_DEPTH, 0);
+        bench_keep(planes);
+    }
+    double t565 = (bench_now_us() - t0) / FRAMES;
+
+    t0 = bench_now_us();
+    for (int k = 0; k < FRAMES; k++) {
+        canvas_convert_rgb888(&luts, rgb, N, out, COLOR_DEPTH, 0);
+        bench_keep(planes);
+    }
+    double t888 = (bench_now_us() - t0) / FRAMES;
+
+    t0 = bench_now_us();
+    for (int k = 0; k < FRAMES; k++) {
+        for (int y = 0; y < H; y++)
+            for (int x = 0; x < W; x++) {
+                const uint8_t *c = rgb + (y * W + x) * 3;
+                set_pixel(x, y, c[0], c[1], c[2]);
+            }
+        bench_keep(back_planes[0]);
+    }
+    double tset = (bench_now_us() - t0) / FRAMES;
+
+    printf("%dx%d: rgb565 %.2f us/frame, rgb888 %.2f us/frame, set_pixel %.2f us/frame\n",
+           W, H, t565, t888, tset);
+    return bad != 0;
+}
@@ -0,0 +1,60 @@
+// Compositor (user-032): a TIME-like frame every iteration, logo in the
+// background layer and the clock digits in the content layer, against the old
+// way (clear, redraw the logo, redraw the digits, swap). 64x32, real led_panel.
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "host_panel.h"
+#include "compositor.h"
+#include "logo.h"
+
+#define FRAMES   20000
+
+static void draw_content(int i)
+{
+    char t[3] = { '0' + (i / 10) % 10, '0' + i % 10, 0 };
+    draw_text_2(2, 14, t, 255, 255, 255);
+    draw_text_2(34, 14, "42", 255, 255, 255);
+}
+
+int main(void)
+{
+    init_planes();
+    compositor_init();
+
+    compositor_begin(LAYER_BACKGROUND, true);
+    draw_bitmap_rgb(0, 0, logo_bitmap, LOGO_WIDTH, LOGO_HEIGHT);
+    compositor_end();
+
+    double t0 = bench_now_us();
+    for (int i = 0; i < FRAMES; i++) {
+        compositor_begin(LAYER_CONTENT, true);
+        draw_content(i);
+        compositor_end();
+        compositor_present();
+    }
+    double layered = (bench_now_us() - t0) / FRAMES;
+
+    static uint8_t composed[COLOR_DEPTH][64 * 32];
+    for (int p = 0; p < COLOR_DEPTH; p++) memcpy(composed[p], front_planes[p], PLANE_BYTES);
+
+    t0 = bench_now_us();
+    for (int i = 0; i < FRAMES; i++) {
+        clear_back_buffer();
+        draw_bitmap_rgb(0, 0, logo_bitmap, LOGO_WIDTH, LOGO_HEIGHT);
+        draw_content(i);
+        swap_buffers();
+    }
+    double full = (bench_now_us() - t0) / FRAMES;
+
+    // Both end on the same frame
+    int diff = 0;
+    for (int p = 0; p < COLOR_DEPTH; p++)
+        for (int i = 0; i < PLANE_BYTES; i++) diff += (composed[p][i] & 7) != (front_planes[p][i] & 7);
+
+    compositor_stats_t s;
+    compositor_get_stats(&s);
+    printf("%dx%d: layered %.2f us/frame, full redraw %.2f us/frame, base merges %lu, frames %s\n",
+           VIRT_WIDTH, VIRT_HEIGHT, layered, full, (unsigned long)s.base_merges, diff ? "DIFFER" : "match");
+    return diff != 0;
+}
@@ -0,0 +1,36 @@
+// Dithering (user-033): dither_quantize per swap on a 64x32 RGB888 frame (the
+// logo scene's size), the time dither_present() adds before each swap.
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "dither_quant.h"
+
+#define W        64
+#define H        32
+#define SWAPS    20000
+
+static dither_tables_t t;
+static uint8_t rgb[W * H * 3];
+static uint8_t planes[DITHER_OUT_BYTES][W * H] __attribute__((aligned(4)));
+
+int main(void)
+{
+    uint8_t *out[DITHER_OUT_BYTES];
+    for (int i = 0; i < DITHER_OUT_BYTES; i++) out[i] = planes[i];
+    for (int i = 0; i < W * H * 3; i++) rgb[i] = rand();
+
+    double t0 = bench_now_us();
+    dither_build_tables(&t, 2.2f);
+    double build = bench_now_us() - t0;
+
+    t0 = bench_now_us();
+    for (int k = 0; k < SWAPS; k++) {
+        dither_quantize(&t, rgb, W, H, out);
+        bench_keep(planes);
+    }
+    double swap = (bench_now_us() - t0) / SWAPS;
+
+    printf("%dx%d: dither_quantize %.2f us per swap (%d sub-frames x %d planes), tables %.0f us once\n",
+           W, H, swap, DITHER_SUBFRAMES, DITHER_DEPTH, build);
+    return 0;
+}
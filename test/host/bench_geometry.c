@@ -0,0 +1,87 @@
+// Runtime geometry (user-037): the virtual -> physical map built by init_planes()
+// against the divisions it replaces, checked for every pixel and timed over a
+// full frame, plus the real set_pixel. The geometry locks once the planes exist,
+// so each one runs in its own child process.
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench.h"
+#include "host_panel.h"
+#include "led_panel.h"
+
+#define FRAMES   2000
+
+static const panel_geometry_t geoms[] = {
+    { .panel_width = 64,  .panel_height = 32, .scan = 8,  .n_hor = 1, .n_ver = 1 },
+    { .panel_width = 64,  .panel_height = 32, .scan = 8,  .n_hor = 2, .n_ver = 1 },
+    { .panel_width = 64,  .panel_height = 64, .scan = 32, .n_hor = 1, .n_ver = 1 },
+    { .panel_width = 32,  .panel_height = 16, .scan = 8,  .n_hor = 4, .n_ver = 2 },
+    { .panel_width = 128, .panel_height = 64, .scan = 32, .n_hor = 1, .n_ver = 1 },
+};
+
+// The mapping as documented above led_panel_pixel_index(), divisions at runtime
+static uint32_t div_index(int x, int y)
+{
+    int panel = (y / PANEL_HEIGHT) * N_HOR + x / PANEL_WIDTH;
+    int chain = panel / PANELS_PER_CHAIN;
+    int phys_x = (panel % PANELS_PER_CHAIN) * PANEL_WIDTH + x % PANEL_WIDTH;
+    int phys_y = chain * PANEL_HEIGHT + y % PANEL_HEIGHT;
+    return (uint32_t)(phys_y * PHY_WIDTH + phys_x);
+}
+
+static int run(const panel_geometry_t *g)
+{
+    if (led_panel_set_geometry(g) != ESP_OK || init_planes() != ESP_OK) return 1;
+
+    int bad = 0;
+    for (int y = 0; y < VIRT_HEIGHT; y++)
+        for (int x = 0; x < VIRT_WIDTH; x++) bad += led_panel_pixel_index(x, y) != div_index(x, y);
+
+    uint8_t *pl = back_planes[0];
+    double t0 = bench_now_us();
+    for (int r = 0; r < FRAMES; r++) {
+        for (int y = 0; y < VIRT_HEIGHT; y++)
+            for (int x = 0; x < VIRT_WIDTH; x++) pl[led_panel_pixel_index(x, y)] = (x ^ y ^ r) & 7;
+        bench_keep(pl);
+    }
+    double lut = (bench_now_us() - t0) / FRAMES;
+
+    t0 = bench_now_us();
+    for (int r = 0; r < FRAMES; r++) {
+        for (int y = 0; y < VIRT_HEIGHT; y++)
+            for (int x = 0; x < VIRT_WIDTH; x++) pl[div_index(x, y)] = (x ^ y ^ r) & 7;
+        bench_keep(pl);
+    }
+    double dv = (bench_now_us() - t0) / FRAMES;
+
+    t0 = bench_now_us();
+    for (int r = 0; r < FRAMES; r++) {
+        for (int y = 0; y < VIRT_HEIGHT; y++)
+            for (int x = 0; x < VIRT_WIDTH; x++) set_pixel(x, y, x * 4, y * 4, r);
+        bench_keep(back_planes[0]);
+    }
+    double sp = (bench_now_us() - t0) / FRAMES;
+
+    printf("%3dx%-3d %dx%d: map %.2f us, runtime division %.2f us, set_pixel %.2f us per frame, map %s\n",
+           g->panel_width, g->panel_height, g->n_hor, g->n_ver, lut, dv, sp, bad ? "DIFFERS" : "matches");
+    return bad != 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(geoms) / sizeof(geoms[0]); i++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            int rc = run(&geoms[i]);
+            fflush(stdout);
+            _exit(rc);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    return failed;
+}
@@ -0,0 +1,50 @@
+// Glyph lookup (user-041): glyph_lookup(utf8_next()) over a 42-character
+// scroller line against the direct index draw_char used before (c - 32, '?'
+// outside ASCII), ASCII-only and with Spanish characters.
+#include <stdio.h>
+#include "bench.h"
+#include "glyph_map.h"
+
+#define REPS   1000000
+
+static const char ascii[]   = "MIERCOLES 21 DE OCTUBRE 2026   23*C  12:34";
+static const char spanish[] = "MIÉRCOLES 21 DE AÑO NUEVO 2026  ¡23°C!  Sí";
+
+static uint8_t glyph[64];
+
+static int by_index(const char *s)
+{
+    int n = 0;
+    for (; *s; s++) {
+        char c = *s;
+        if (c < 32 || c > 126) c = '?';
+        glyph[n++] = c - 32;
+    }
+    return n;
+}
+
+static int by_map(const char *s)
+{
+    int n = 0;
+    while (*s) glyph[n++] = glyph_lookup(utf8_next(&s));
+    return n;
+}
+
+static double ns_per_char(int (*f)(const char *), const char *s)
+{
+    int chars = 0;
+    double t0 = bench_now_us();
+    for (int r = 0; r < REPS; r++) {
+        bench_keep(s);
+        chars += f(s);
+        bench_keep(glyph);
+    }
+    return (bench_now_us() - t0) * 1000 / chars;
+}
+
+int main(void)
+{
+    printf("direct index %.2f ns/char, glyph map %.2f ns/char (ASCII line), %.2f ns/char (Spanish line)\n",
+           ns_per_char(by_index, ascii), ns_per_char(by_map, ascii), ns_per_char(by_map, spanish));
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Scan fast paths (user-048): the real refresh_task on host_panel's virtual
+// clock, a shifted row costing 0.2 µs per column, for each scene at 1/8 and
+// 1/16 scan. The pass with the fast paths is measured; the same pass scanning
+// every row is refresh stats' pass_full_us. Light per lit pixel is OE duty over
+// pass length and should not move. Each run is a child process (the geometry
+// locks, refresh_task never returns).
+//
+//   bench_scan [scene [scan]]    clock, clock+temp, text, logo, white, gray, black
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "host_panel.h"
+#include "led_panel.h"
+#include "logo.h"
+
+static const char *const scenes[] = { "clock", "clock+temp", "text", "logo", "white", "gray", "black" };
+
+static void draw_scene(const char *sc)
+{
+    if (!strcmp(sc, "clock")) {
+        draw_text_2(2, 14, "12", 255, 255, 255);
+        draw_text_2(34, 14, "34", 255, 255, 255);
+        draw_text_5(51, 16, "#$", 255, 255, 255);
+    } else if (!strcmp(sc, "clock+temp")) {
+        draw_text_2(2, 2, "12", 255, 255, 255);
+        draw_text_2(34, 2, "34", 255, 255, 255);
+        draw_text_6(20, 26, "21.5", 255, 120, 0);
+        draw_text_6(60, 26, "$", 255, 120, 0);
+    } else if (!strcmp(sc, "text")) {
+        draw_text(8, 8, "MENU", 255, 0, 0);
+    } else if (!strcmp(sc, "logo")) {
+        draw_bitmap_rgb(0, 0, logo_bitmap, LOGO_WIDTH, LOGO_HEIGHT);
+    } else if (!strcmp(sc, "white") || !strcmp(sc, "gray")) {
+        int v = sc[0] == 'w' ? 255 : 100;
+        for (int y = 0; y < VIRT_HEIGHT; y++)
+            for (int x = 0; x < VIRT_WIDTH; x++) set_pixel(x, y, v, v, v);
+    }
+}
+
+static void run(const char *sc, int scan)
+{
+    const panel_geometry_t g = { .panel_width = 64, .panel_height = 32, .scan = scan, .n_hor = 1, .n_ver = 1 };
+    if (led_panel_set_geometry(&g) != ESP_OK) return;
+    init_pins();
+    init_oe_pwm();
+    init_planes();
+    set_global_brightness(100);
+    host_panel_shift_us = SCAN_COLS * N_CHAINS / 5;
+
+    clear_back_buffer();
+    draw_scene(sc);
+    swap_buffers();
+
+    host_panel_start_refresh();
+    host_panel_sleep_ms(300);
+
+    led_refresh_stats_t rs;
+    led_panel_get_refresh_stats(&rs);
+    if (rs.idle_waits) {
+        // A black frame: after the passes before its plan, a wait per tick
+        printf("%-10s 1/%-2d scan stopped after %u passes, %u idle waits\n", sc, scan, rs.passes, rs.idle_waits);
+        return;
+    }
+    printf("%-10s 1/%-2d every row %5u us %5.0f Hz | fast %5u us %5.0f Hz (%.2fx) duty %3u/256 "
+           "skipped %4.1f merged %4.1f per pass | light %.4f -> %.4f\n",
+           sc, scan, rs.pass_full_us, 1e6 / rs.pass_full_us, rs.pass_us, 1e6 / rs.pass_us,
+           (double)rs.pass_full_us / rs.pass_us, rs.duty_scale,
+           rs.fast_passes ? (double)rs.rows_skipped / rs.fast_passes : 0,
+           rs.fast_passes ? (double)rs.rows_merged / rs.fast_passes : 0,
+           256.0 / rs.pass_full_us, (double)rs.duty_scale / rs.pass_us);
+}
+
+static void run_child(const char *sc, int scan)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        run(sc, scan);
+        fflush(stdout);
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        run_child(argv[1], argc > 2 ? atoi(argv[2]) : 8);
+        return 0;
+    }
+    for (int scan = 8; scan <= 16; scan *= 2)
+        for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) run_child(scenes[i], scan);
+    return 0;
+}
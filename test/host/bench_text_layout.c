@@ -0,0 +1,91 @@
+// Layout cache (user-039): the TIME scene's three strings (clock, temperature,
+// scrolling date) formatted and drawn every frame against text_layout_t, which
+// formats only when the key changes, on the real draw_text/draw_glyphs. Also
+// checks that TEXT_ALIGN_CENTER puts each day name where the TEMPERATURE
+// scene's old pos_day table did.
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "host_panel.h"
+#include "led_panel.h"
+#include "text_layout.h"
+
+#define FRAMES   200000
+
+static const char *dias[] = {
+    "DOMINGO", "LUNES", "MARTES", "MIÉRCOLES", "JUEVES", "VIERNES", "SÁBADO"
+};
+static const char *meses[] = {
+    "ENERO", "FEBRERO", "MARZO", "ABRIL", "MAYO", "JUNIO",
+    "JULIO", "AGOSTO", "SEPTIEMBRE", "OCTUBRE", "NOVIEMBRE", "DICIEMBRE"
+};
+static const int old_pos_day[7] = { 7, 14, 10, 0, 10, 7, 10 };
+
+static const int h = 10, m = 42, temp = 23, day = 3, mon = 10, yr = 2026, wd = 5;
+
+static void frame_formatted(int f)
+{
+    char bt[16], bp[16], bd[64];
+    snprintf(bt, sizeof bt, "%02d:%02d:%02d", h, m, (f / 50) % 60);
+    draw_text(4, 1, bt, 255, 255, 255);
+    snprintf(bp, sizeof bp, "%d*C", temp);
+    draw_text(20, 22, bp, 255, 255, 255);
+    snprintf(bd, sizeof bd, "%s %d %s %04d", dias[wd], day, meses[mon - 1], yr);
+    draw_text(63 - f % 300, 12, bd, 255, 255, 255);
+}
+
+static void frame_cached(int f)
+{
+    static text_layout_t tt, tp, td;
+    char b[64];
+    uint32_t k = (h << 16) | (m << 8) | (f / 50) % 60;
+    if (text_layout_stale(&tt, k)) {
+        snprintf(b, sizeof b, "%02d:%02d:%02d", h, m, (f / 50) % 60);
+        text_layout_set(&tt, k, b, TEXT_ADVANCE, TEXT_ALIGN_LEFT, 4, 0);
+    }
+    draw_glyphs(tt.x, 1, tt.glyph, tt.len, 255, 255, 255);
+    if (text_layout_stale(&tp, temp)) {
+        snprintf(b, sizeof b, "%d*C", temp);
+        text_layout_set(&tp, temp, b, TEXT_ADVANCE, TEXT_ALIGN_LEFT, 20, 0);
+    }
+    draw_glyphs(tp.x, 22, tp.glyph, tp.len, 255, 255, 255);
+    uint32_t dk = (yr << 12) | (mon << 8) | (day << 3) | wd;
+    if (text_layout_stale(&td, dk)) {
+        snprintf(b, sizeof b, "%s %d %s %04d", dias[wd], day, meses[mon - 1], yr);
+        text_layout_set(&td, dk, b, TEXT_ADVANCE, TEXT_ALIGN_LEFT, 0, 0);
+    }
+    draw_glyphs(63 - f % 300, 12, td.glyph, td.len, 255, 255, 255);
+}
+
+int main(void)
+{
+    init_planes();
+
+    double t0 = bench_now_us();
+    for (int f = 0; f < FRAMES; f++) {
+        frame_formatted(f);
+        bench_keep(back_planes[0]);
+    }
+    double formatted = (bench_now_us() - t0) / FRAMES;
+
+    t0 = bench_now_us();
+    for (int f = 0; f < FRAMES; f++) {
+        frame_cached(f);
+        bench_keep(back_planes[0]);
+    }
+    double cached = (bench_now_us() - t0) / FRAMES;
+
+    int bad = 0;
+    for (int i = 0; i < 7; i++) {
+        text_layout_t l;
+        text_layout_set(&l, i, dias[i], TEXT_ADVANCE, TEXT_ALIGN_CENTER, 0, 64);
+        if (l.x != 1 + old_pos_day[i]) {
+            printf("%s at x=%d, pos_day had %d\n", dias[i], l.x, 1 + old_pos_day[i]);
+            bad++;
+        }
+    }
+
+    printf("TIME scene: formatted %.2f us/frame, cached %.2f us/frame (%.0f%% less), day centring %s\n",
+           formatted, cached, 100 * (1 - cached / formatted), bad ? "DIFFERS" : "matches");
+    return bad != 0;
+}
@@ -0,0 +1,123 @@
+// Transitions (user-042): every kind at 65 progress points against a per-pixel
+// reference, and the worst frame time over those points, on single panel rows
+// (64x32, 128x32, 256x64) and on a 2x2 wall of 64x32 on one chain, where slide
+// and wipe go through the segment table.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "transition.h"
+
+#define DEPTH    3
+#define REPS     2000
+
+static const char *const kind_name[TRANSITION_KINDS] = { "", "slide", "wipe", "dissolve", "fade" };
+
+// Virtual -> plane offset, as led_panel.c maps it (one chain)
+static int pw, ph, n_hor, phy_w;
+
+static uint32_t offset(int x, int y)
+{
+    int panel = (y / ph) * n_hor + x / pw;
+    return (uint32_t)((y % ph) * phy_w + panel * pw + x % pw);
+}
+
+static uint8_t expect(transition_kind_t k, fx_t pr, int vw, int vh, const uint8_t *rank,
+                      uint8_t *const *f, uint8_t *const *t, int p, int x, int y)
+{
+    uint32_t i = offset(x, y);
+    switch (k) {
+    case TRANSITION_SLIDE: {
+        int s = (int)(((int64_t)pr * vw) >> FX_SHIFT);
+        return x < vw - s ? f[p][offset(x + s, y)] : t[p][offset(x - (vw - s), y)];
+    }
+    case TRANSITION_WIPE:
+        return y < (int)(((int64_t)pr * vh) >> FX_SHIFT) ? t[p][i] : f[p][i];
+    case TRANSITION_DISSOLVE:
+        return rank[i] < (int)(((int64_t)pr * 128) >> FX_SHIFT) ? t[p][i] : f[p][i];
+    case TRANSITION_FADE: {
+        int steps = 2 * DEPTH, st = (int)(((int64_t)pr * steps) >> FX_SHIFT);
+        uint8_t *const *src = st <= DEPTH ? f : t;
+        int sh = st <= DEPTH ? st : steps - st;
+        return p + sh < DEPTH ? src[p + sh][i] : 0;
+    }
+    default:
+        return t[p][i];
+    }
+}
+
+static int run(int panel_w, int panel_h, int hor, int ver)
+{
+    pw = panel_w;
+    ph = panel_h;
+    n_hor = hor;
+    phy_w = pw * hor * ver;
+    const int vw = pw * hor, vh = ph * ver, n = phy_w * ph;
+
+    uint8_t *rank = aligned_alloc(4, n);
+    transition_build_ranks(rank, n, 1234);
+    uint8_t *from[DEPTH], *to[DEPTH], *out[DEPTH];
+    for (int p = 0; p < DEPTH; p++) {
+        from[p] = aligned_alloc(4, n);
+        to[p] = aligned_alloc(4, n);
+        out[p] = aligned_alloc(4, n);
+        for (int i = 0; i < n; i++) {
+            from[p][i] = rand() & 7;
+            to[p][i] = rand() & 7;
+        }
+    }
+
+    uint32_t *seg = malloc(vh * hor * sizeof(uint32_t));
+    uint8_t *line = malloc(2 * vw);
+    transition_rows_t rows = { .width = vw, .height = vh, .seg_width = pw, .seg = seg, .line = line };
+    bool segmented = transition_build_rows(&rows, phy_w, offset);
+    const transition_geom_t g = {
+        .width = phy_w, .height = ph, .depth = DEPTH, .rank = rank, .rows = segmented ? &rows : NULL,
+    };
+
+    printf("%dx%d (%dx%d of %dx%d%s)\n", vw, vh, hor, ver, pw, ph, segmented ? ", segment table" : "");
+    int failed = 0;
+    for (int k = 1; k < TRANSITION_KINDS; k++) {
+        int bad = 0;
+        double worst = 0;
+        for (int s = 0; s <= 64; s++) {
+            fx_t pr = s * (FX_ONE / 64);
+            for (int p = 0; p < DEPTH; p++) memcpy(out[p], to[p], n);
+            transition_apply(&g, k, pr, from, out);
+            for (int p = 0; p < DEPTH; p++)
+                for (int y = 0; y < vh; y++)
+                    for (int x = 0; x < vw; x++)
+                        bad += out[p][offset(x, y)] != expect(k, pr, vw, vh, rank, from, to, p, x, y);
+
+            double t0 = bench_now_us();
+            for (int r = 0; r < REPS; r++) {
+                transition_apply(&g, k, pr, from, out);
+                bench_keep(out[0]);
+            }
+            double us = (bench_now_us() - t0) / REPS;
+            if (us > worst) worst = us;
+        }
+        printf("  %-8s 65 progress points %s, worst frame %.2f us\n", kind_name[k], bad ? "DIFFER" : "match", worst);
+        failed |= bad != 0;
+    }
+
+    for (int p = 0; p < DEPTH; p++) {
+        free(from[p]);
+        free(to[p]);
+        free(out[p]);
+    }
+    free(rank);
+    free(seg);
+    free(line);
+    return failed;
+}
+
+int main(void)
+{
+    int failed = 0;
+    failed |= run(64, 32, 1, 1);
+    failed |= run(128, 32, 1, 1);
+    failed |= run(256, 64, 1, 1);
+    failed |= run(64, 32, 2, 2);
+    return failed;
+}
@@ -0,0 +1,153 @@
+#include "host_panel.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "led_panel.h"
+#include "driver/ledc.h"
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "freertos/semphr.h"
+#include "soc/gpio_struct.h"
+
+gpio_dev_t GPIO;
+bool stop_flag;
+
+int host_panel_shift_us;
+volatile uint32_t host_panel_lit_rows;
+
+// ------------ virtual clock ------------
+
+static int64_t vnow;
+
+int64_t esp_timer_get_time(void)
+{
+    return __atomic_add_fetch(&vnow, 1, __ATOMIC_RELAXED);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / (portTICK_PERIOD_MS * 1000));
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    usleep(ticks * portTICK_PERIOD_MS * 1000);
+}
+
+void host_panel_sleep_ms(int ms)
+{
+    usleep(ms * 1000);
+}
+
+// ------------ LEDC, GPIO, heap ------------
+
+static uint32_t pending_duty;
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *c) { return ESP_OK; }
+esp_err_t ledc_channel_config(const ledc_channel_config_t *c) { return ESP_OK; }
+esp_err_t ledc_set_duty(ledc_mode_t m, ledc_channel_t c, uint32_t duty) { pending_duty = duty; return ESP_OK; }
+
+// A row lights when its duty is applied: charge the shift of the next one
+esp_err_t ledc_update_duty(ledc_mode_t m, ledc_channel_t c)
+{
+    if (pending_duty) {
+        __atomic_add_fetch(&vnow, host_panel_shift_us, __ATOMIC_RELAXED);
+        host_panel_lit_rows++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t *c) { return ESP_OK; }
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level) { return ESP_OK; }
+int esp_cpu_get_core_id(void) { return 0; }
+const char *esp_err_to_name(esp_err_t err) { return "error"; }
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) { return calloc(n, size); }
+void heap_caps_free(void *p) { free(p); }
+bool esp_ptr_internal(const void *p) { return true; }
+bool esp_ptr_in_iram(const void *p) { return true; }
+
+// ------------ semaphores and notifications ------------
+
+static SemaphoreHandle_t new_sem(int count)
+{
+    sem_t *s = malloc(sizeof(*s));
+    sem_init(s, 0, count);
+    return (SemaphoreHandle_t)s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) { return new_sem(0); }
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return new_sem(1); }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t h, TickType_t wait) { sem_wait((sem_t *)h); return pdTRUE; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t h) { sem_post((sem_t *)h); return pdTRUE; }
+
+static sem_t notify;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    sem_init(&notify, 0, 0);
+    return (TaskHandle_t)&notify;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t h) { sem_post((sem_t *)h); return pdTRUE; }
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) { sem_wait(&notify); return 1; }
+
+// ------------ gptimer: a thread firing the alarm every alarm_count µs ------------
+
+struct gptimer_t {
+    gptimer_alarm_cb_t cb;
+    uint64_t period;
+    volatile bool run;
+    pthread_t thread;
+};
+
+static void *timer_thread(void *arg)
+{
+    struct gptimer_t *t = arg;
+    int64_t next = esp_timer_get_time() + (int64_t)t->period;
+    while (t->run) {
+        while (esp_timer_get_time() < next) sched_yield();
+        next += (int64_t)t->period;
+        if (t->run) t->cb(t, NULL, NULL);
+    }
+    return NULL;
+}
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *c, gptimer_handle_t *h) { *h = calloc(1, sizeof(**h)); return ESP_OK; }
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t t, const gptimer_event_callbacks_t *c, void *arg) { t->cb = c->on_alarm; return ESP_OK; }
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t t, const gptimer_alarm_config_t *a) { t->period = a->alarm_count; return ESP_OK; }
+esp_err_t gptimer_enable(gptimer_handle_t t) { return ESP_OK; }
+esp_err_t gptimer_set_raw_count(gptimer_handle_t t, uint64_t v) { return ESP_OK; }
+
+esp_err_t gptimer_start(gptimer_handle_t t)
+{
+    t->run = true;
+    pthread_create(&t->thread, NULL, timer_thread, t);
+    return ESP_OK;
+}
+
+esp_err_t gptimer_stop(gptimer_handle_t t)
+{
+    t->run = false;
+    pthread_join(t->thread, NULL);
+    return ESP_OK;
+}
+
+// ------------ refresh_task ------------
+
+static void *refresh_thread(void *arg)
+{
+    refresh_task(NULL);
+    return NULL;
+}
+
+void host_panel_start_refresh(void)
+{
+    pthread_t th;
+    pthread_create(&th, NULL, refresh_thread, NULL);
+}
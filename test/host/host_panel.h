@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+
+// Host runtime for the real led_panel component: FreeRTOS semaphores, task
+// notifications and the gptimer on pthreads, LEDC/GPIO as no-ops, esp_timer on a
+// virtual clock (every read is 1 µs later, a lit row costs host_panel_shift_us).
+// Used by the bench_* programs; refresh_task runs on its own thread.
+
+extern int host_panel_shift_us;          // virtual time charged per lit row (the next row's shift)
+extern volatile uint32_t host_panel_lit_rows;
+
+/**
+ * @brief Run refresh_task on a thread (init_pins/init_oe_pwm/init_planes done)
+ */
+void host_panel_start_refresh(void);
+
+/**
+ * @brief Wait ms of wall time (the virtual clock runs with the refresh thread)
+ */
+void host_panel_sleep_ms(int ms);
@@ -0,0 +1,13 @@
+#pragma once
+#include "esp_err.h"
+typedef struct i2c_master_bus_t *i2c_master_bus_handle_t;
+typedef struct i2c_master_dev_t *i2c_master_dev_handle_t;
+typedef enum { I2C_NUM_0 } i2c_port_num_t;
+typedef enum { I2C_CLK_SRC_DEFAULT } i2c_clock_source_t;
+typedef struct { i2c_clock_source_t clk_source; int i2c_port; int sda_io_num; int scl_io_num; int glitch_ignore_cnt; int intr_priority; struct { unsigned enable_internal_pullup:1; } flags; } i2c_master_bus_config_t;
+typedef struct { int device_address; uint32_t scl_speed_hz; } i2c_device_config_t;
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *, i2c_master_bus_handle_t *);
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t, const i2c_device_config_t *, i2c_master_dev_handle_t *);
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t, const uint8_t *, size_t, int);
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t, uint8_t *, size_t, int);
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t, const uint8_t *, size_t, uint8_t *, size_t, int);
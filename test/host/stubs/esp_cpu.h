@@ -0,0 +1,4 @@
+#pragma once
+#include "esp_err.h"
+uint32_t esp_cpu_get_cycle_count(void);
+int esp_cpu_get_core_id(void);
@@ -0,0 +1,7 @@
+#pragma once
+#include "esp_err.h"
+#define ESP_INTR_FLAG_IRAM (1<<10)
+#define ESP_INTR_FLAG_LEVEL1 (1<<1)
+#define ESP_INTR_FLAG_LEVEL3 (1<<3)
+#include <stdio.h>
+esp_err_t esp_intr_dump(FILE *stream);
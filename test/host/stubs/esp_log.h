@@ -0,0 +1,9 @@
+#pragma once
+#include "esp_err.h"
+#define ESP_HOST_LOG(l, t, ...) ((void)(t), printf("%c (%s) ", l, t), printf(__VA_ARGS__), printf("\n"))
+#define ESP_LOGE(t, ...) ESP_HOST_LOG('E', t, __VA_ARGS__)
+#define ESP_LOGW(t, ...) ESP_HOST_LOG('W', t, __VA_ARGS__)
+#define ESP_LOGI(t, ...) ESP_HOST_LOG('I', t, __VA_ARGS__)
+#define ESP_LOGD(t, ...) ESP_HOST_LOG('D', t, __VA_ARGS__)
+#define ESP_LOGV(t, ...) ESP_HOST_LOG('V', t, __VA_ARGS__)
+#define ESP_EARLY_LOGE(t, ...) ESP_HOST_LOG('E', t, __VA_ARGS__)
@@ -0,0 +1,6 @@
+#pragma once
+#include "esp_err.h"
+bool esp_ptr_external_ram(const void *);
+bool esp_ptr_internal(const void *);
+bool esp_ptr_in_iram(const void *);
+bool esp_ptr_in_dram(const void *);
@@ -0,0 +1,4 @@
+#pragma once
+#include "esp_err.h"
+void esp_rom_delay_us(uint32_t us);
+int esp_rom_printf(const char *fmt, ...);
@@ -0,0 +1,30 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+typedef void (*TaskFunction_t)(void *);
+typedef struct tskTaskControlBlock *TaskHandle_t;
+void vTaskDelay(TickType_t);
+void vTaskDelayUntil(TickType_t *, TickType_t);
+BaseType_t xTaskDelayUntil(TickType_t *, TickType_t);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *, BaseType_t);
+BaseType_t xTaskCreate(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *);
+typedef enum { eNoAction, eSetBits, eIncrement, eSetValueWithOverwrite } eNotifyAction;
+BaseType_t xTaskNotify(TaskHandle_t, uint32_t, eNotifyAction);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t, uint32_t, eNotifyAction, BaseType_t *);
+BaseType_t xTaskNotifyWait(uint32_t, uint32_t, uint32_t *, TickType_t);
+BaseType_t xTaskNotifyGive(TaskHandle_t);
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xPortGetCoreID(void);
+const char *pcTaskGetName(TaskHandle_t);
+typedef enum { eRunning, eReady, eBlocked, eSuspended, eDeleted } eTaskState;
+typedef struct { TaskHandle_t xHandle; const char *pcTaskName; UBaseType_t xTaskNumber; eTaskState eCurrentState; UBaseType_t uxCurrentPriority; UBaseType_t uxBasePriority; uint32_t ulRunTimeCounter; StackType_t *pxStackBase; uint32_t usStackHighWaterMark; BaseType_t xCoreID; } TaskStatus_t;
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *, UBaseType_t, uint32_t *);
+void vTaskDelete(TaskHandle_t);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+uint32_t ulTaskNotifyValueClear(TaskHandle_t, uint32_t);
+BaseType_t xTaskGetCoreID(TaskHandle_t);
+void vTaskSuspend(TaskHandle_t);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t);
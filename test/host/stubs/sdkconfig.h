@@ -0,0 +1,5 @@
+#pragma once
+#define CONFIG_LEDC_CTRL_FUNC_IN_IRAM 1
+#define CONFIG_GPTIMER_ISR_CACHE_SAFE 1
+#define CONFIG_ESP_TIMER_ISR_AFFINITY_CPU1 1
+#define CONFIG_ESP_TIMER_TASK_AFFINITY_CPU1 1
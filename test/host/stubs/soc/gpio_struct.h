@@ -0,0 +1,4 @@
+#pragma once
+#include <stdint.h>
+typedef struct { volatile uint32_t out; volatile uint32_t out_w1ts; volatile uint32_t out_w1tc; volatile uint32_t in; } gpio_dev_t;
+extern gpio_dev_t GPIO;
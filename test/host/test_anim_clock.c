@@ -0,0 +1,110 @@
+// anim_clock.c: a scroller driven by frames 5..50 ms apart with 0.5..3.5 ms of
+// drawing stays on its ideal line at every frame time (constant velocity under
+// jitter), stalls move it by exactly the time lost, the scan-out lead follows
+// the drawing time and ignores outliers; blink and progress edges.
+#include <stdlib.h>
+#include "host_test.h"
+#include "anim_clock.h"
+
+#define SPEED   (-10)           // px/s, the date scroller
+
+static int64_t llabs64(int64_t v) { return v < 0 ? -v : v; }
+
+static void test_constant_velocity(void)
+{
+    anim_clock_t c = { 0 };
+    anim_linear_t a;
+    int64_t t = 1000000;
+
+    anim_clock_begin_frame(&c, t);
+    const int64_t t0 = anim_clock_now(&c);
+    anim_linear_start(&a, t0, FX_FROM_INT(63), SPEED);
+
+    int64_t prev_t = t0;
+    fx_t prev_x = FX_FROM_INT(63);
+    int64_t max_err = 0, max_step_err = 0;
+    long frames = 0;
+
+    while (t < 1000000 + 600 * 1000000LL) {          // 10 minutes
+        t += 5000 + rand() % 45000;                  // 5..50 ms between frames
+        int64_t work = 500 + rand() % 3000;          // drawing and present
+        if (frames % 1000 == 999) t += 300000;       // now and then a stall
+
+        anim_clock_begin_frame(&c, t);
+        int64_t ft = anim_clock_now(&c);
+        fx_t x = anim_linear_at(&a, ft);
+
+        // On the ideal line at the frame time, to a 1/65536 px rounding
+        int64_t ideal = FX_FROM_INT(63) * 1000000LL + (int64_t)SPEED * (ft - t0) * FX_ONE;
+        int64_t err = llabs64((int64_t)x * 1000000 - ideal);
+        if (err > max_err) max_err = err;
+
+        // Frame to frame: the step is the speed times the time between frames,
+        // however uneven those are
+        int64_t step_err = llabs64((int64_t)(x - prev_x) * 1000000 - (int64_t)SPEED * (ft - prev_t) * FX_ONE);
+        if (step_err > max_step_err) max_step_err = step_err;
+        CHECK(ft > prev_t);
+
+        prev_t = ft;
+        prev_x = x;
+        anim_clock_end_frame(&c, t + work);
+        frames++;
+    }
+    CHECK(frames > 20000);
+    CHECK(max_err < 1000000);            // under one 16.16 unit
+    CHECK(max_step_err < 2000000);
+
+    // The lead tracks the drawing time (0.5..3.5 ms, mean 2 ms)
+    CHECK(c.lead_us > 1000 && c.lead_us < 3000);
+}
+
+static void test_lead(void)
+{
+    anim_clock_t c = { 0 };
+    int64_t t = 0;
+    for (int i = 0; i < 100; i++) {
+        anim_clock_begin_frame(&c, t);
+        CHECK_EQ(anim_clock_now(&c), t + c.lead_us);
+        anim_clock_end_frame(&c, t + 4000);
+        t += 20000;
+    }
+    CHECK(c.lead_us > 3900 && c.lead_us <= 4000);
+
+    // One frame stuck for a second moves the estimate by at most 1/8 of LEAD_MAX_US
+    anim_clock_begin_frame(&c, t);
+    anim_clock_end_frame(&c, t + 1000000);
+    CHECK(c.lead_us < 4000 + 50000 / 8 + 1);
+
+    // A clock that went backwards does not make the lead negative
+    anim_clock_begin_frame(&c, t);
+    for (int i = 0; i < 100; i++) anim_clock_end_frame(&c, t - 5000);
+    CHECK(c.lead_us >= 0);
+}
+
+static void test_blink_and_progress(void)
+{
+    CHECK(anim_blink_on(0, 0, 1000000, 500000));
+    CHECK(!anim_blink_on(500000, 0, 1000000, 500000));
+    CHECK(anim_blink_on(1000000, 0, 1000000, 500000));
+    CHECK(!anim_blink_on(-1, 0, 1000000, 500000));           // before the anchor
+    CHECK(anim_blink_on(-600000, 0, 1000000, 500000));
+
+    CHECK_EQ(anim_progress(0, 100, 1000), 0);
+    CHECK_EQ(anim_progress(600, 100, 1000), FX_ONE / 2);
+    CHECK_EQ(anim_progress(1100, 100, 1000), FX_ONE);
+    CHECK_EQ(anim_progress(2000, 100, 0), FX_ONE);
+
+    // Hours from the start, no overflow in the 64-bit product
+    anim_linear_t a;
+    anim_linear_start(&a, 0, 0, 1);
+    CHECK_EQ(anim_linear_at(&a, 3600 * 1000000LL), FX_FROM_INT(3600));
+}
+
+int main(void)
+{
+    srand(40);
+    test_constant_velocity();
+    test_lead();
+    test_blink_and_progress();
+    return host_test_done("test_anim_clock");
+}
@@ -0,0 +1,242 @@
+// button_fsm.c on its own (long press, auto-repeat, late timers) and buttons.c
+// on fake GPIO interrupts and esp_timer one-shots driven by a virtual clock
+// (bouncing contacts, glitches, press/long/repeat/release sequences).
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "buttons.h"
+#include "esp_timer.h"
+
+// ------------ virtual clock and esp_timer ------------
+
+struct esp_timer {
+    esp_timer_cb_t cb;
+    void *arg;
+    int64_t due;              // 0 = stopped
+};
+
+static struct esp_timer timers[2 * BUTTONS_MAX];
+static int n_timers;
+static int64_t now_us;
+
+int64_t esp_timer_get_time(void) { return now_us; }
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *a, esp_timer_handle_t *h)
+{
+    *h = &timers[n_timers++];
+    (*h)->cb = a->callback;
+    (*h)->arg = a->arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t h, uint64_t us)
+{
+    if (h->due) return ESP_ERR_INVALID_STATE;
+    h->due = now_us + (int64_t)us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t h)
+{
+    if (!h->due) return ESP_ERR_INVALID_STATE;
+    h->due = 0;
+    return ESP_OK;
+}
+
+// Fire every one-shot due up to t, in time order
+static void run_until(int64_t t)
+{
+    for (;;) {
+        struct esp_timer *next = NULL;
+        for (int i = 0; i < n_timers; i++) {
+            if (timers[i].due && timers[i].due <= t && (!next || timers[i].due < next->due)) next = &timers[i];
+        }
+        if (!next) break;
+        now_us = next->due;
+        next->due = 0;
+        next->cb(next->arg);
+    }
+    now_us = t;
+}
+
+// ------------ GPIO and queue ------------
+
+#define PIN   GPIO_NUM_4
+
+static int level = 1;         // active low, idle high
+static bool intr_enabled;
+static gpio_isr_t isr;
+static void *isr_arg;
+
+esp_err_t gpio_install_isr_service(int flags) { return ESP_OK; }
+esp_err_t gpio_config(const gpio_config_t *c) { intr_enabled = true; return ESP_OK; }
+int gpio_get_level(gpio_num_t pin) { return level; }
+esp_err_t gpio_intr_enable(gpio_num_t pin) { intr_enabled = true; return ESP_OK; }
+esp_err_t gpio_intr_disable(gpio_num_t pin) { intr_enabled = false; return ESP_OK; }
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t fn, void *arg)
+{
+    isr = fn;
+    isr_arg = arg;
+    return ESP_OK;
+}
+
+// The pin changes at time t (timers due before it run first)
+static void edge(int64_t t, int l)
+{
+    run_until(t);
+    if (l == level) return;
+    level = l;
+    if (intr_enabled) isr(isr_arg);
+}
+
+static button_event_t events[64];
+static int n_events;
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t size) { return (QueueHandle_t)events; }
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait)
+{
+    if (n_events == (int)(sizeof(events) / sizeof(events[0]))) return pdFALSE;
+    memcpy(&events[n_events++], item, sizeof(button_event_t));
+    return pdTRUE;
+}
+
+static int count(button_event_type_t type)
+{
+    int n = 0;
+    for (int i = 0; i < n_events; i++) n += events[i].type == type;
+    return n;
+}
+
+#define MS   1000
+
+// ------------ tests ------------
+
+static void test_fsm(void)
+{
+    const button_timing_t t = { .long_us = 1000 * MS, .repeat_delay_us = 400 * MS, .repeat_rate_us = 100 * MS };
+    button_fsm_t f;
+    button_fsm_out_t out;
+
+    button_fsm_reset(&f);
+    button_fsm_level(&f, &t, true, 0, &out);
+    CHECK_EQ(out.count, 1);
+    CHECK_EQ(out.events[0], BUTTON_EVT_PRESS);
+    CHECK_EQ(out.next_deadline_us, 400 * MS);        // repeat comes before long
+
+    // A press that is still down is not a second press
+    button_fsm_level(&f, &t, true, 10 * MS, &out);
+    CHECK_EQ(out.count, 0);
+
+    int repeats = 0, longs = 0;
+    int64_t deadline = out.next_deadline_us;
+    while (deadline && deadline <= 1500 * MS) {
+        button_fsm_timer(&f, &t, deadline, &out);
+        for (int i = 0; i < out.count; i++) {
+            repeats += out.events[i] == BUTTON_EVT_REPEAT;
+            longs += out.events[i] == BUTTON_EVT_LONG;
+        }
+        CHECK(out.next_deadline_us > deadline);
+        deadline = out.next_deadline_us;
+    }
+    CHECK_EQ(longs, 1);
+    CHECK_EQ(repeats, 12);                           // 400, 500 .. 1500 ms
+
+    // A timer 1 s late: one repeat, then back on the 100 ms grid
+    button_fsm_timer(&f, &t, deadline + 1000 * MS + 30 * MS, &out);
+    CHECK_EQ(out.count, 1);
+    CHECK_EQ(out.events[0], BUTTON_EVT_REPEAT);
+    CHECK_EQ(out.next_deadline_us, deadline + 1100 * MS);
+
+    button_fsm_level(&f, &t, false, 3000 * MS, &out);
+    CHECK_EQ(out.count, 1);
+    CHECK_EQ(out.events[0], BUTTON_EVT_RELEASE);
+    CHECK_EQ(out.next_deadline_us, 0);
+
+    // Long only, no repeat; a spurious timer after release does nothing
+    const button_timing_t lo = { .long_us = 800 * MS };
+    button_fsm_level(&f, &lo, true, 0, &out);
+    CHECK_EQ(out.next_deadline_us, 800 * MS);
+    button_fsm_timer(&f, &lo, 799 * MS, &out);
+    CHECK_EQ(out.count, 0);
+    button_fsm_timer(&f, &lo, 800 * MS, &out);
+    CHECK_EQ(out.count, 1);
+    CHECK_EQ(out.events[0], BUTTON_EVT_LONG);
+    CHECK_EQ(out.next_deadline_us, 0);
+    button_fsm_level(&f, &lo, false, 900 * MS, &out);
+    button_fsm_timer(&f, &lo, 2000 * MS, &out);
+    CHECK_EQ(out.count, 0);
+}
+
+// Contact bounce: n random edges within ms milliseconds, settling at l
+static int64_t bounce(int64_t t, int l, int n, int ms)
+{
+    for (int i = 0; i < n; i++) {
+        t += 1 + rand() % (ms * MS / n);
+        edge(t, (i & 1) ? l : !l);
+    }
+    t += 100;
+    edge(t, l);
+    return t;
+}
+
+static void test_driver(void)
+{
+    const button_timing_t t = { .long_us = 1000 * MS, .repeat_delay_us = 500 * MS, .repeat_rate_us = 100 * MS };
+
+    CHECK_EQ(buttons_init(), ESP_OK);
+    CHECK_EQ(buttons_add(0, PIN, &t), ESP_OK);
+    CHECK_EQ(buttons_add(0, PIN, &t), ESP_ERR_INVALID_STATE);
+
+    // Bouncy short press and release: one event each, time of the settled sample
+    for (int k = 0; k < 50; k++) {
+        n_events = 0;
+        int64_t start = now_us + 50 * MS;
+        int64_t settled = bounce(start, 0, 7, 8);
+        run_until(settled + 200 * MS);
+        CHECK_EQ(n_events, 1);
+        CHECK_EQ(events[0].type, BUTTON_EVT_PRESS);
+        CHECK(events[0].time_us >= start + BUTTON_DEBOUNCE_MS * MS);
+        CHECK(events[0].time_us <= settled + 2 * BUTTON_DEBOUNCE_MS * MS);
+        CHECK(buttons_is_pressed(0));
+
+        bounce(now_us, 1, 5, 6);
+        run_until(now_us + 200 * MS);
+        CHECK_EQ(n_events, 2);
+        CHECK_EQ(events[1].type, BUTTON_EVT_RELEASE);
+        CHECK(!buttons_is_pressed(0));
+        if (host_test_failures) return;
+    }
+
+    // A glitch shorter than the debounce window is not a press
+    n_events = 0;
+    edge(now_us + 10 * MS, 0);
+    edge(now_us + 5 * MS, 1);
+    run_until(now_us + 500 * MS);
+    CHECK_EQ(n_events, 0);
+
+    // Held 1.5 s: press, repeats from 500 ms every 100 ms, one long at 1 s, release
+    n_events = 0;
+    int64_t down = now_us + 10 * MS;
+    edge(down, 0);
+    run_until(down + 1500 * MS + BUTTON_DEBOUNCE_MS * MS / 2);
+    edge(now_us, 1);
+    run_until(now_us + 200 * MS);
+    CHECK_EQ(events[0].type, BUTTON_EVT_PRESS);
+    CHECK_EQ(count(BUTTON_EVT_LONG), 1);
+    CHECK_EQ(count(BUTTON_EVT_REPEAT), 11);           // 500 .. 1500 ms after the press
+    CHECK_EQ(events[n_events - 1].type, BUTTON_EVT_RELEASE);
+    for (int i = 1; i < n_events; i++) CHECK(events[i].time_us >= events[i - 1].time_us);
+
+    // No timer left running while idle
+    for (int i = 0; i < n_timers; i++) CHECK_EQ(timers[i].due, 0);
+}
+
+int main(void)
+{
+    srand(7);
+    test_fsm();
+    test_driver();
+    return host_test_done("test_buttons");
+}
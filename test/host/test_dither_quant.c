@@ -0,0 +1,116 @@
+// dither_quant.c: every level averages exactly over DITHER_SUBFRAMES, each
+// phase's pattern is a running accumulator that is back at its Bayer phase
+// after one cycle (the next swap continues it seamlessly), level 0 and the
+// top level never change, and dither_quantize packs R/G/B into the plane bits
+// with the phase of each pixel's Bayer cell.
+#include <stdlib.h>
+#include "host_test.h"
+#include "dither_quant.h"
+
+#define TOP   (DITHER_LEVELS - 1)
+
+static dither_tables_t t;
+
+static int shown(int level, int phase, int s)
+{
+    const uint8_t *b = (const uint8_t *)t.pattern[level][phase];
+    int q = 0;
+    for (int p = 0; p < DITHER_DEPTH; p++) q |= b[s * DITHER_DEPTH + p] << p;
+    return q;
+}
+
+static void test_levels(void)
+{
+    CHECK_EQ(t.level[0], 0);
+    CHECK_EQ(t.level[255], TOP);
+    for (int v = 1; v < 256; v++) CHECK(t.level[v] >= t.level[v - 1]);
+
+    for (int level = 0; level < DITHER_LEVELS; level++) {
+        for (int phase = 0; phase < DITHER_SUBFRAMES; phase++) {
+            int sum = 0;
+            for (int s = 0; s < DITHER_SUBFRAMES; s++) {
+                int q = shown(level, phase, s);
+                // Never more than one step from the level
+                CHECK(q == level >> DITHER_FRAC_BITS || q == (level >> DITHER_FRAC_BITS) + 1);
+                sum += q;
+            }
+            CHECK_EQ(sum, level);
+        }
+    }
+}
+
+static void test_phase_cycle(void)
+{
+    const int frac_mask = DITHER_SUBFRAMES - 1;
+    for (int level = 0; level < DITHER_LEVELS; level++) {
+        for (int phase = 0; phase < DITHER_SUBFRAMES; phase++) {
+            // One accumulator run over three cycles: each cycle is the table's
+            // pattern for the same phase, so the accumulator came back to it
+            int acc = phase;
+            for (int cycle = 0; cycle < 3; cycle++) {
+                for (int s = 0; s < DITHER_SUBFRAMES; s++) {
+                    acc += level & frac_mask;
+                    int q = (level >> DITHER_FRAC_BITS) + (acc >> DITHER_FRAC_BITS);
+                    acc &= frac_mask;
+                    CHECK_EQ(shown(level, phase, s), q);
+                }
+                CHECK_EQ(acc, phase);
+            }
+        }
+    }
+
+    // The ends do not flicker, whatever the phase
+    for (int phase = 0; phase < DITHER_SUBFRAMES; phase++)
+        for (int s = 0; s < DITHER_SUBFRAMES; s++) {
+            CHECK_EQ(shown(0, phase, s), 0);
+            CHECK_EQ(shown(TOP, phase, s), (1 << DITHER_DEPTH) - 1);
+        }
+}
+
+static void test_quantize(void)
+{
+    enum { W = 16, H = 16 };        // every 8-bit value once per channel
+    static uint8_t rgb[W * H * 3];
+    static uint8_t planes[DITHER_OUT_BYTES][W * H];
+    uint8_t *out[DITHER_OUT_BYTES];
+    for (int i = 0; i < DITHER_OUT_BYTES; i++) out[i] = planes[i];
+
+    for (int i = 0; i < W * H; i++) {
+        rgb[i * 3 + 0] = i;
+        rgb[i * 3 + 1] = 255 - i;
+        rgb[i * 3 + 2] = (i * 7) & 255;
+    }
+    dither_quantize(&t, rgb, W, H, out);
+
+    static const uint8_t bayer4[4][4] = {
+        {  0,  8,  2, 10 },
+        { 12,  4, 14,  6 },
+        {  3, 11,  1,  9 },
+        { 15,  7, 13,  5 },
+    };
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++) {
+            int i = y * W + x;
+            int phase = bayer4[y & 3][x & 3] >> (4 - DITHER_FRAC_BITS);
+            for (int c = 0; c < 3; c++) {
+                int level = t.level[rgb[i * 3 + c]], sum = 0;
+                for (int s = 0; s < DITHER_SUBFRAMES; s++) {
+                    int q = 0;
+                    for (int p = 0; p < DITHER_DEPTH; p++) q |= ((planes[s * DITHER_DEPTH + p][i] >> c) & 1) << p;
+                    CHECK_EQ(q, shown(level, phase, s));
+                    sum += q;
+                }
+                CHECK_EQ(sum, level);
+            }
+            for (int k = 0; k < DITHER_OUT_BYTES; k++) CHECK((planes[k][i] & ~7) == 0);
+        }
+}
+
+int main(void)
+{
+    dither_build_tables(&t, 2.2f);
+    test_levels();
+    test_phase_cycle();
+    test_quantize();
+    return host_test_done("test_dither_quant");
+}
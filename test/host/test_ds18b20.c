@@ -0,0 +1,373 @@
+// ds18b20.c against a simulated 1-Wire bus: ROM search over random device
+// sets, MATCH_ROM scratchpad reads, CRC and stuck-bus rejection, conversion
+// polling, resolution writes.
+//
+// The bus sees only the driver's GPIO calls and delays. A slot starts when the
+// master pulls the line low; 480 µs low is a reset. Every device decides at the
+// falling edge whether it holds the line low for this slot (wired-AND), and at
+// the rising edge reads the master's bit (low for less than 15 µs = 1).
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "ds18b20.h"
+#include "esp_rom_sys.h"
+
+#define MAX_FAKE   12
+
+typedef enum { D_IDLE, D_ROM_CMD, D_SEARCH, D_MATCH, D_FUNC_CMD, D_TX, D_RX_SCRATCH, D_CONVERT } dev_state_t;
+
+typedef struct {
+    uint8_t rom[8];
+    uint8_t sp[9];
+    int16_t temp_q4;          // next conversion result
+    bool corrupt;             // send a scratchpad with a bad CRC
+    dev_state_t st;
+    int bit;
+    uint8_t byte;
+    int phase;                // search: 0 bit, 1 complement, 2 master's choice
+    bool match;
+    int64_t conv_done_us;
+} fake_dev_t;
+
+static fake_dev_t devs[MAX_FAKE];
+static int n_devs;
+static bool stuck_low;
+static int64_t conv_us = 100000;
+
+static int64_t now_us;
+static int master_level = 1;
+static int64_t fall_us;
+static int bus_drive = 1;     // what the devices hold the line at in this slot
+
+// ------------ fake devices ------------
+
+static int rom_bit(const fake_dev_t *d, int i) { return (d->rom[i / 8] >> (i % 8)) & 1; }
+
+static void set_scratchpad(fake_dev_t *d)
+{
+    int res = 9 + ((d->sp[4] >> 5) & 3);
+    int16_t t = d->temp_q4 | (int16_t)((1 << (12 - res)) - 1);   // undefined low bits: ones
+    d->sp[0] = (uint8_t)t;
+    d->sp[1] = (uint8_t)(t >> 8);
+    d->sp[8] = ds18b20_crc8(d->sp, 8);
+    if (d->corrupt) d->sp[0] ^= 0x10;
+}
+
+static void add_dev(const uint8_t rom[8], int16_t temp_q4)
+{
+    fake_dev_t *d = &devs[n_devs++];
+    memset(d, 0, sizeof(*d));
+    memcpy(d->rom, rom, 8);
+    d->temp_q4 = temp_q4;
+    static const uint8_t por[9] = { 0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0 };
+    memcpy(d->sp, por, sizeof(por));
+    d->sp[8] = ds18b20_crc8(d->sp, 8);
+}
+
+static void make_rom(uint8_t rom[8], uint8_t family, bool close)
+{
+    rom[0] = family;
+    for (int i = 1; i < 7; i++) rom[i] = close ? (uint8_t)(rand() & 1) : (uint8_t)rand();
+    rom[7] = ds18b20_crc8(rom, 7);
+}
+
+static int slot_out(const fake_dev_t *d)
+{
+    switch (d->st) {
+    case D_SEARCH:
+        if (d->phase == 0) return rom_bit(d, d->bit);
+        if (d->phase == 1) return !rom_bit(d, d->bit);
+        return 1;
+    case D_TX:
+        return d->bit < 72 ? (d->sp[d->bit / 8] >> (d->bit % 8)) & 1 : 1;
+    case D_CONVERT:
+        return now_us >= d->conv_done_us;
+    default:
+        return 1;
+    }
+}
+
+// Shift a received bit in, true when a byte is complete
+static bool rx_bit(fake_dev_t *d, int b)
+{
+    d->byte = (uint8_t)((d->byte >> 1) | (b << 7));
+    return (++d->bit % 8) == 0;
+}
+
+static void slot_end(fake_dev_t *d, int b)
+{
+    switch (d->st) {
+    case D_ROM_CMD:
+        if (!rx_bit(d, b)) break;
+        d->bit = 0;
+        d->phase = 0;
+        d->match = true;
+        d->st = d->byte == 0xF0 ? D_SEARCH : d->byte == 0x55 ? D_MATCH :
+                d->byte == 0xCC ? D_FUNC_CMD : D_IDLE;
+        break;
+    case D_SEARCH:
+        if (d->phase < 2) { d->phase++; break; }
+        d->phase = 0;
+        if (b != rom_bit(d, d->bit)) d->st = D_IDLE;
+        else if (++d->bit == 64) d->st = D_IDLE;
+        break;
+    case D_MATCH:
+        if (b != rom_bit(d, d->bit)) d->match = false;
+        if (++d->bit == 64) {
+            d->bit = 0;
+            d->st = d->match ? D_FUNC_CMD : D_IDLE;
+        }
+        break;
+    case D_FUNC_CMD:
+        if (!rx_bit(d, b)) break;
+        d->bit = 0;
+        if (d->byte == 0x44) {
+            d->st = D_CONVERT;
+            d->conv_done_us = now_us + conv_us;
+            set_scratchpad(d);
+        } else if (d->byte == 0xBE) {
+            d->st = D_TX;
+        } else if (d->byte == 0x4E) {
+            d->st = D_RX_SCRATCH;
+        } else {
+            d->st = D_IDLE;
+        }
+        break;
+    case D_TX:
+        d->bit++;
+        break;
+    case D_RX_SCRATCH:
+        if (!rx_bit(d, b)) break;
+        d->sp[2 + d->bit / 8 - 1] = d->byte;          // TH, TL, config
+        if (d->bit == 24) {
+            d->sp[8] = ds18b20_crc8(d->sp, 8);
+            d->st = D_IDLE;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// ------------ IDF fakes ------------
+
+void esp_rom_delay_us(uint32_t us) { now_us += us; }
+void vTaskDelay(TickType_t ticks) { now_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000; }
+TickType_t xTaskGetTickCount(void) { return (TickType_t)(now_us / (portTICK_PERIOD_MS * 1000)); }
+const char *esp_err_to_name(esp_err_t err) { return "error"; }
+esp_err_t gpio_reset_pin(gpio_num_t pin) { return ESP_OK; }
+esp_err_t gpio_set_pull_mode(gpio_num_t pin, gpio_pull_mode_t mode) { return ESP_OK; }
+
+esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode)
+{
+    if (mode == GPIO_MODE_INPUT && master_level == 0) return gpio_set_level(pin, 1);   // released
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    if (!level && master_level) {
+        fall_us = now_us;
+        bus_drive = 1;
+        for (int i = 0; i < n_devs; i++) bus_drive &= slot_out(&devs[i]);
+    } else if (level && !master_level) {
+        int64_t low = now_us - fall_us;
+        if (low >= 480) {
+            for (int i = 0; i < n_devs; i++) {
+                devs[i].st = D_ROM_CMD;
+                devs[i].bit = 0;
+            }
+            bus_drive = n_devs ? 0 : 1;                 // presence pulse
+        } else {
+            for (int i = 0; i < n_devs; i++) slot_end(&devs[i], low < 15);
+        }
+    }
+    master_level = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin)
+{
+    if (stuck_low) return 0;
+    return master_level & bus_drive;
+}
+
+// ------------ tests ------------
+
+static void reset_bus(void)
+{
+    n_devs = 0;
+    stuck_low = false;
+    conv_us = 100000;
+}
+
+static bool found(const ds18b20_t *s, const uint8_t rom[8])
+{
+    for (int i = 0; i < s->count; i++) {
+        if (!memcmp(s->rom[i], rom, 8)) return true;
+    }
+    return false;
+}
+
+static void test_search_random(void)
+{
+    for (int trial = 0; trial < 600; trial++) {
+        reset_bus();
+        int n = 1 + rand() % DS18B20_MAX_DEVICES;
+        bool close = trial % 3 == 0;          // serials differing in single bits: deep discrepancies
+        while (n_devs < n) {
+            uint8_t rom[8];
+            make_rom(rom, 0x28, close);
+            bool dup = false;
+            for (int i = 0; i < n_devs; i++) dup |= !memcmp(devs[i].rom, rom, 8);
+            if (!dup) add_dev(rom, 0);
+        }
+
+        ds18b20_t s = { .pin = GPIO_NUM_27, .resolution = 12 };
+        CHECK_EQ(ds18b20_search(&s), ESP_OK);
+        CHECK_EQ(s.count, n);
+        for (int i = 0; i < n; i++) CHECK(found(&s, devs[i].rom));
+        if (host_test_failures) return;
+    }
+}
+
+static void test_search_limits(void)
+{
+    uint8_t rom[8];
+
+    // More devices than table entries: the first DS18B20_MAX_DEVICES, all real
+    reset_bus();
+    while (n_devs < DS18B20_MAX_DEVICES + 3) {
+        make_rom(rom, 0x28, false);
+        add_dev(rom, 0);
+    }
+    ds18b20_t s = { .pin = GPIO_NUM_27 };
+    CHECK_EQ(ds18b20_search(&s), ESP_OK);
+    CHECK_EQ(s.count, DS18B20_MAX_DEVICES);
+    for (int i = 0; i < s.count; i++) {
+        bool real = false;
+        for (int d = 0; d < n_devs; d++) real |= !memcmp(devs[d].rom, s.rom[i], 8);
+        CHECK(real);
+    }
+
+    // A foreign family on the bus is skipped, the probes behind it still found
+    reset_bus();
+    for (int i = 0; i < 3; i++) {
+        make_rom(rom, 0x28, false);
+        add_dev(rom, 0);
+    }
+    make_rom(rom, 0x10, false);
+    add_dev(rom, 0);
+    CHECK_EQ(ds18b20_search(&s), ESP_OK);
+    CHECK_EQ(s.count, 3);
+    CHECK(!found(&s, devs[3].rom));
+
+    // Empty bus
+    reset_bus();
+    CHECK_EQ(ds18b20_search(&s), ESP_ERR_NOT_FOUND);
+    CHECK_EQ(s.count, 0);
+
+    // DQ shorted to ground: presence on every reset, zeros everywhere
+    reset_bus();
+    stuck_low = true;
+    CHECK(ds18b20_search(&s) != ESP_OK);
+    CHECK_EQ(s.count, 0);
+}
+
+static void test_scratchpad(void)
+{
+    static const int16_t temps[] = { 401, -162, 85 * 16 };   // 25.0625, -10.125, 85 °C
+    uint8_t rom[8];
+    int16_t q4;
+
+    reset_bus();
+    for (int i = 0; i < 3; i++) {
+        make_rom(rom, 0x28, false);
+        add_dev(rom, temps[i]);
+    }
+    ds18b20_t s;
+    CHECK_EQ(ds18b20_init(&s, GPIO_NUM_27), ESP_OK);
+    CHECK_EQ(s.count, 3);
+
+    CHECK_EQ(ds18b20_start_conversion(&s), ESP_OK);
+    CHECK_EQ(ds18b20_wait_conversion(&s), ESP_OK);
+    for (int i = 0; i < s.count; i++) {
+        int d = 0;
+        while (memcmp(devs[d].rom, s.rom[i], 8)) d++;
+        CHECK_EQ(ds18b20_read_scratchpad_fixed(&s, i, &q4), ESP_OK);
+        CHECK_EQ(q4, temps[d]);
+    }
+    CHECK_EQ(ds18b20_read_scratchpad_fixed(&s, 3, &q4), ESP_ERR_INVALID_ARG);
+
+    // 9 bits: the three undefined fraction bits are dropped
+    CHECK_EQ(ds18b20_set_resolution(&s, 9), ESP_OK);
+    for (int d = 0; d < n_devs; d++) CHECK_EQ(devs[d].sp[4], 0x1F);
+    CHECK_EQ(ds18b20_start_conversion(&s), ESP_OK);
+    CHECK_EQ(ds18b20_wait_conversion(&s), ESP_OK);
+    for (int i = 0; i < s.count; i++) {
+        int d = 0;
+        while (memcmp(devs[d].rom, s.rom[i], 8)) d++;
+        CHECK_EQ(ds18b20_read_scratchpad_fixed(&s, i, &q4), ESP_OK);
+        CHECK_EQ(q4, temps[d] & ~7);
+    }
+
+    // Bad CRC
+    devs[1].corrupt = true;
+    CHECK_EQ(ds18b20_start_conversion(&s), ESP_OK);
+    CHECK_EQ(ds18b20_wait_conversion(&s), ESP_OK);
+    for (int i = 0; i < s.count; i++) {
+        esp_err_t want = memcmp(devs[1].rom, s.rom[i], 8) ? ESP_OK : ESP_ERR_INVALID_CRC;
+        CHECK_EQ(ds18b20_read_scratchpad_fixed(&s, i, &q4), want);
+    }
+
+    // Shorted DQ: nine zero bytes carry a valid CRC but are not a reading
+    stuck_low = true;
+    CHECK_EQ(ds18b20_read_scratchpad_fixed(&s, 0, &q4), ESP_ERR_INVALID_CRC);
+}
+
+static void test_blocking_readers(void)
+{
+    uint8_t rom[8];
+    float f;
+    int16_t t;
+
+    reset_bus();
+    make_rom(rom, 0x28, false);
+    add_dev(rom, -168);                       // -10.5 °C
+    ds18b20_t s;
+    CHECK_EQ(ds18b20_init(&s, GPIO_NUM_27), ESP_OK);
+
+    conv_us = 700000;                         // 12 bits: polled over many ticks
+    int64_t t0 = now_us;
+    CHECK_EQ(ds18b20_read_temperature(&s, &f), ESP_OK);
+    CHECK(f == -10.5f);
+    CHECK(now_us - t0 >= conv_us);
+    CHECK_EQ(ds18b20_read_temperature_int(&s, &t), ESP_OK);
+    CHECK_EQ(t, -10);                         // toward zero
+
+    devs[0].corrupt = true;
+    CHECK_EQ(ds18b20_read_temperature(&s, &f), ESP_ERR_INVALID_CRC);
+    CHECK_EQ(ds18b20_read_temperature_int(&s, &t), ESP_ERR_INVALID_CRC);
+    devs[0].corrupt = false;
+
+    // Never finishes: give up after twice the datasheet time
+    conv_us = 10 * 1000000;
+    t0 = now_us;
+    CHECK_EQ(ds18b20_read_temperature_int(&s, &t), ESP_ERR_TIMEOUT);
+    CHECK(now_us - t0 < 2 * 1000000);
+
+    // Unplugged
+    n_devs = 0;
+    CHECK_EQ(ds18b20_read_temperature_int(&s, &t), ESP_ERR_NOT_FOUND);
+    CHECK(!s.present);
+}
+
+int main(void)
+{
+    srand(1);
+    test_search_random();
+    test_search_limits();
+    test_scratchpad();
+    test_blocking_readers();
+    return host_test_done("test_ds18b20");
+}
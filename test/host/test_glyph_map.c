@@ -0,0 +1,127 @@
+// glyph_map.c and the UTF-8 decoder: ASCII keeps its c - 32 index, the
+// Spanish glyphs and the degree sign map where font6x9_ext.h has them, blocks
+// without glyphs share one table; malformed, truncated and overlong sequences
+// give U+FFFD and skip a byte; text_layout_set truncates on whole characters.
+#include <string.h>
+#include "host_test.h"
+#include "glyph_map.h"
+#include "text_layout.h"
+
+static void test_blocks(void)
+{
+    for (uint32_t c = 0; c < 0x80; c++)
+        CHECK_EQ(glyph_lookup(c), c >= 32 && c <= 126 ? c - 32 : GLYPH_FALLBACK);
+
+    // The 16 extra glyphs, each once, in GLYPH_EXT_FIRST..
+    static const uint32_t ext[GLYPH_EXT_COUNT] = {
+        0xC1, 0xC9, 0xCD, 0xD3, 0xDA, 0xD1, 0xDC,       // Á É Í Ó Ú Ñ Ü
+        0xE1, 0xE9, 0xED, 0xF3, 0xFA, 0xF1, 0xFC,       // á é í ó ú ñ ü
+        0xA1, 0xBF,                                     // ¡ ¿
+    };
+    for (int i = 0; i < GLYPH_EXT_COUNT; i++) CHECK_EQ(glyph_lookup(ext[i]), GLYPH_EXT_FIRST + i);
+    CHECK_EQ(glyph_lookup(0xB0), '*' - 32);             // ° is font6x9's ring
+
+    // Everything else in range is the fallback, and nothing points past the font
+    int mapped = 0;
+    for (uint32_t c = 0x80; c < GLYPH_MAP_LIMIT; c++) {
+        uint8_t g = glyph_lookup(c);
+        CHECK(g < GLYPH_EXT_FIRST + GLYPH_EXT_COUNT);
+        if (g != GLYPH_FALLBACK) mapped++;
+    }
+    CHECK_EQ(mapped, GLYPH_EXT_COUNT + 1);
+    CHECK_EQ(glyph_lookup(GLYPH_MAP_LIMIT), GLYPH_FALLBACK);
+    CHECK_EQ(glyph_lookup(0x1F600), GLYPH_FALLBACK);
+
+    // Blocks without glyphs share one table
+    for (int b = 4; b < GLYPH_MAP_LIMIT >> 6; b++) CHECK(glyph_map_blocks[b] == glyph_map_blocks[4]);
+}
+
+// Decode all of s, the code points into cp[]; returns how many
+static int decode(const char *s, uint32_t *cp)
+{
+    int n = 0;
+    while (*s) cp[n++] = utf8_next(&s);
+    return n;
+}
+
+static void test_utf8(void)
+{
+    uint32_t cp[16];
+
+    CHECK_EQ(decode("A\xC3\xB1\xE2\x82\xAC\xF0\x9F\x98\x80", cp), 4);     // A ñ € 😀
+    CHECK_EQ(cp[0], 'A');
+    CHECK_EQ(cp[1], 0xF1);
+    CHECK_EQ(cp[2], 0x20AC);
+    CHECK_EQ(cp[3], 0x1F600);
+
+    // A lone continuation byte, a lead byte without its continuation, a
+    // sequence cut by the terminator: one U+FFFD per bad byte, nothing skipped
+    CHECK_EQ(decode("\x80" "A", cp), 2);
+    CHECK_EQ(cp[0], 0xFFFD);
+    CHECK_EQ(cp[1], 'A');
+    CHECK_EQ(decode("\xC3" "A", cp), 2);
+    CHECK_EQ(cp[0], 0xFFFD);
+    CHECK_EQ(cp[1], 'A');
+    CHECK_EQ(decode("\xE2\x82", cp), 2);
+    CHECK_EQ(cp[0], 0xFFFD);
+    CHECK_EQ(cp[1], 0xFFFD);
+    CHECK_EQ(decode("\xFF\xFE", cp), 2);
+    CHECK_EQ(cp[0], 0xFFFD);
+
+    // Overlong forms of 'A' and '/' never decode to ASCII
+    static const char *const overlong[] = {
+        "\xC1\x81", "\xC0\xAF", "\xE0\x81\x81", "\xE0\x80\xAF", "\xF0\x80\x81\x81", "\xF0\x80\x80\xAF",
+    };
+    for (size_t i = 0; i < sizeof(overlong) / sizeof(overlong[0]); i++) {
+        int n = decode(overlong[i], cp);
+        CHECK_EQ(n, (int)strlen(overlong[i]));
+        for (int k = 0; k < n; k++) CHECK_EQ(cp[k], 0xFFFD);
+    }
+
+    // Past U+10FFFF
+    CHECK_EQ(decode("\xF4\x90\x80\x80", cp), 4);
+    CHECK_EQ(cp[0], 0xFFFD);
+}
+
+static void test_layout_truncation(void)
+{
+    text_layout_t l;
+    char s[160];
+
+    // 2-byte characters: 31 of them fit in TEXT_LAYOUT_MAX - 1 bytes, never half of one
+    s[0] = 0;
+    for (int i = 0; i < 70; i++) strcat(s, "\xC3\xA9");
+    text_layout_set(&l, 1, s, 7, TEXT_ALIGN_LEFT, 0, 0);
+    CHECK_EQ(l.len, 31);
+    CHECK_EQ(strlen(l.text), 62);
+    for (int i = 0; i < l.len; i++) CHECK_EQ(l.glyph[i], glyph_lookup(0xE9));
+
+    // 62 ASCII then a 2-byte character that would end at byte 64: left out
+    memset(s, 'x', 62);
+    strcpy(s + 62, "\xC3\xB1yz");
+    text_layout_set(&l, 2, s, 7, TEXT_ALIGN_LEFT, 0, 0);
+    CHECK_EQ(l.len, 62);
+    CHECK_EQ(strlen(l.text), 62);
+    CHECK_EQ(l.width, 62 * 7 - 1);
+
+    // Exactly TEXT_LAYOUT_MAX - 1 ASCII characters fit
+    memset(s, 'x', 70);
+    s[70] = 0;
+    text_layout_set(&l, 3, s, 7, TEXT_ALIGN_LEFT, 0, 0);
+    CHECK_EQ(l.len, TEXT_LAYOUT_MAX - 1);
+    CHECK_EQ(strlen(l.text), TEXT_LAYOUT_MAX - 1);
+
+    // Glyphs per character, not per byte
+    text_layout_set(&l, 4, "MI\xC3\x89RCOLES", 7, TEXT_ALIGN_CENTER, 0, 64);
+    CHECK_EQ(l.len, 9);
+    CHECK_EQ(l.glyph[2], GLYPH_EXT_FIRST + 1);
+    CHECK_EQ(l.x, 1);
+}
+
+int main(void)
+{
+    test_blocks();
+    test_utf8();
+    test_layout_truncation();
+    return host_test_done("test_glyph_map");
+}
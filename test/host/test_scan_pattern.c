@@ -0,0 +1,135 @@
+// scan_pattern.c + hub75_bits: a random plane emitted for every scan pattern the
+// way refresh_task does (shift map, staged LUT indices, GPIO set words, address
+// words), then decoded by panel models written independently of the descriptor:
+// the old refresh_task formulas for folded 1/8 panels, straight row/column
+// addressing for 1/16 and 1/32. One and two chains.
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "scan_pattern.h"
+#include "hub75_bits.h"
+
+#define MAX_W   (64 * 3)
+#define MAX_H   (64 * 2)
+
+// Where the panel lights shifted column col of address row (upper half)
+typedef void (*panel_model_t)(int w, int h, int row, int col, int *x, int *y);
+
+// 1/8 on 32 rows, as refresh_task shifted it before the descriptors: per panel
+// a run for rows 8..15 (and 24..31), then one for rows 0..7 (and 16..23)
+static void model_folded8(int w, int h, int row, int col, int *x, int *y)
+{
+    int run = col / w;
+    *x = (run / 2) * w + col % w;
+    *y = (run % 2) ? row : row + h / 4;
+}
+
+static void model_straight(int w, int h, int row, int col, int *x, int *y)
+{
+    *x = col;
+    *y = row;
+}
+
+static const uint8_t chain_pins[2][HUB75_DATA_PINS] = {
+    { 2, 4, 5, 18, 19, 25 },
+    { 21, 22, 27, 16, 1, 3 },
+};
+
+// Inverse of hub75_lut_build: three data bits of pins[first..first + 2]
+static uint8_t pins_value(uint32_t word, const uint8_t *pins)
+{
+    return ((word >> pins[0]) & 1) | (((word >> pins[1]) & 1) << 1) | (((word >> pins[2]) & 1) << 2);
+}
+
+static void test_pattern(int n, int w, int h, int panels, int chains, panel_model_t model)
+{
+    scan_pattern_t pat;
+    CHECK_EQ(scan_pattern_folded(&pat, n, h), 0);
+    CHECK_EQ(scan_validate(&pat, w, h), 0);
+
+    // Framebuffer: chain k owns rows [k * h, (k + 1) * h), panels side by side
+    const int stride = w * panels, rows = h * chains;
+    static uint8_t plane[MAX_W * MAX_H], shown[MAX_W * MAX_H];
+    static uint8_t lit[MAX_W * MAX_H];
+    for (int i = 0; i < stride * rows; i++) plane[i] = rand() & 7;
+    memset(shown, 0, sizeof(shown));
+    memset(lit, 0, sizeof(lit));
+
+    static scan_col_t map[MAX_W * 4];
+    static uint32_t col_off[MAX_W * 4];
+    int cols = scan_build_map(&pat, w, h, panels, map, MAX_W * 4);
+    CHECK(cols > 0);
+    if (cols <= 0) return;
+    for (int c = 0; c < cols; c++) col_off[c] = map[c].y_offset * stride + map[c].fb_x;
+
+    hub75_lut_t lut[2];
+    for (int k = 0; k < chains; k++) hub75_lut_build(&lut[k], chain_pins[k]);
+
+    const uint32_t lines[SCAN_MAX_ADDR_BITS] = { 1u << 15, 1u << 26, 1u << 23, 1u << 17, 1u << 0 };
+    uint32_t set[64], clr[64];
+    scan_build_addr(&pat, lines, set, clr);
+
+    static uint8_t st[MAX_W * 4 * 2];
+    for (int row = 0; row < pat.addr_rows; row++) {
+        // Address lines: the row number on A..E, every used line either set or cleared
+        int addr = 0;
+        uint32_t used = 0;
+        for (int b = 0; b < pat.addr_bits; b++) {
+            addr |= ((set[row] & lines[b]) != 0) << b;
+            used |= lines[b];
+        }
+        CHECK_EQ(addr, row);
+        CHECK_EQ(set[row] | clr[row], used);
+        CHECK_EQ(set[row] & clr[row], 0);
+
+        hub75_stage_row(st, plane + row * stride, col_off, cols, chains, h * stride, pat.lower_offset * stride);
+
+        for (int c = 0; c < cols; c++) {
+            int x, y;
+            model(w, h, row, c, &x, &y);
+            for (int k = 0; k < chains; k++) {
+                uint32_t word = lut[k].set[st[c * chains + k]];
+                CHECK_EQ(word & ~lut[k].mask, 0);
+                int upper = (k * h + y) * stride + x, lower = upper + (h / 2) * stride;
+                lit[upper]++;
+                lit[lower]++;
+                shown[upper] = pins_value(word, &chain_pins[k][0]);
+                shown[lower] = pins_value(word, &chain_pins[k][3]);
+            }
+        }
+    }
+
+    // Every LED lit exactly once per scan cycle, with its framebuffer colour
+    int wrong = 0;
+    for (int i = 0; i < stride * rows; i++) wrong += lit[i] != 1 || shown[i] != plane[i];
+    CHECK_EQ(wrong, 0);
+}
+
+static void test_invalid(void)
+{
+    scan_pattern_t pat;
+    CHECK_EQ(scan_pattern_folded(&pat, 12, 32), -1);
+    CHECK_EQ(scan_pattern_folded(&pat, 16, 24), -1);
+
+    // A descriptor built for another panel height drives some rows twice
+    CHECK_EQ(scan_pattern_folded(&pat, 16, 32), 0);
+    CHECK_EQ(scan_validate(&pat, 64, 64), -1);
+
+    static scan_col_t map[8];
+    CHECK_EQ(scan_pattern_folded(&pat, 16, 32), 0);
+    CHECK_EQ(scan_build_map(&pat, 64, 32, 1, map, 8), -1);     // map too small
+}
+
+int main(void)
+{
+    srand(35);
+    test_pattern(8, 64, 32, 1, 1, model_folded8);
+    test_pattern(8, 64, 32, 3, 1, model_folded8);
+    test_pattern(8, 64, 32, 2, 2, model_folded8);
+    test_pattern(16, 64, 32, 2, 1, model_straight);
+    test_pattern(16, 64, 32, 1, 2, model_straight);
+    test_pattern(32, 64, 64, 1, 1, model_straight);
+    test_pattern(32, 64, 64, 2, 2, model_straight);
+    test_invalid();
+    return host_test_done("test_scan_pattern");
+}
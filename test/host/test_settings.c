@@ -0,0 +1,321 @@
+// settings.c on an in-memory backend: a broken NVS still leaves the defaults
+// readable, a burst of setters is one commit after the quiet time (the real
+// commit task on a thread, a tick is 100 µs here), an unchanged value is not
+// written again, the legacy u8 keys are migrated once, short blobs keep the
+// defaults of the fields they lack and an unknown version is not trusted.
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "host_test.h"
+
+// The load and commit steps are static: test them in place
+#include "settings.c"
+
+#define TICK_US   100
+
+// ------------ FreeRTOS on pthreads ------------
+
+struct tskTaskControlBlock {
+    pthread_mutex_t m;
+    pthread_cond_t cv;
+    uint32_t count;
+    TaskFunction_t fn;
+    pthread_t thread;
+};
+
+static __thread struct tskTaskControlBlock *self;
+
+static void *task_thread(void *arg)
+{
+    self = arg;
+    self->fn(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *h)
+{
+    struct tskTaskControlBlock *t = calloc(1, sizeof(*t));
+    pthread_mutex_init(&t->m, NULL);
+    pthread_cond_init(&t->cv, NULL);
+    t->fn = fn;
+    *h = t;
+    pthread_create(&t->thread, NULL, task_thread, t);
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t)
+{
+    pthread_mutex_lock(&t->m);
+    t->count++;
+    pthread_cond_signal(&t->cv);
+    pthread_mutex_unlock(&t->m);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+{
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    long long ns = until.tv_nsec + (long long)wait * TICK_US * 1000;
+    until.tv_sec += ns / 1000000000;
+    until.tv_nsec = ns % 1000000000;
+
+    pthread_mutex_lock(&self->m);
+    while (self->count == 0) {
+        if (wait == portMAX_DELAY) pthread_cond_wait(&self->cv, &self->m);
+        else if (pthread_cond_timedwait(&self->cv, &self->m, &until) != 0) break;
+    }
+    uint32_t n = self->count;
+    self->count = clear ? 0 : (n ? n - 1 : 0);
+    pthread_mutex_unlock(&self->m);
+    return n;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    pthread_mutex_t *m = malloc(sizeof(*m));
+    pthread_mutex_init(m, NULL);
+    return (SemaphoreHandle_t)m;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait)
+{
+    pthread_mutex_lock((pthread_mutex_t *)s);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    pthread_mutex_unlock((pthread_mutex_t *)s);
+    return pdTRUE;
+}
+
+const char *esp_err_to_name(esp_err_t err) { return "error"; }
+
+// ------------ NVS: the partition does not come up ------------
+
+static int nvs_inits;
+
+esp_err_t nvs_flash_init(void) { nvs_inits++; return ESP_FAIL; }
+esp_err_t nvs_flash_erase(void) { return ESP_FAIL; }
+esp_err_t nvs_open(const char *ns, nvs_open_mode_t mode, nvs_handle_t *h) { return ESP_FAIL; }
+esp_err_t nvs_get_blob(nvs_handle_t h, const char *key, void *out, size_t *len) { return ESP_FAIL; }
+esp_err_t nvs_set_blob(nvs_handle_t h, const char *key, const void *data, size_t len) { return ESP_FAIL; }
+esp_err_t nvs_get_u8(nvs_handle_t h, const char *key, uint8_t *v) { return ESP_FAIL; }
+esp_err_t nvs_commit(nvs_handle_t h) { return ESP_FAIL; }
+void nvs_close(nvs_handle_t h) {}
+
+// ------------ in-memory backend ------------
+
+static uint8_t mem[128];
+static size_t mem_len;          // 0 = no blob yet
+static int saves;
+static uint8_t legacy[3];       // brightness, mode, format; 0 = key absent
+
+static esp_err_t mem_load_blob(void *blob, size_t *len)
+{
+    if (!mem_len) return ESP_ERR_NOT_FOUND;
+    if (*len > mem_len) *len = mem_len;
+    memcpy(blob, mem, *len);
+    return ESP_OK;
+}
+
+static esp_err_t mem_save_blob(const void *blob, size_t len)
+{
+    memcpy(mem, blob, len);
+    mem_len = len;
+    saves++;
+    return ESP_OK;
+}
+
+static esp_err_t mem_load_legacy_u8(const char *key, uint8_t *value)
+{
+    int i = !strcmp(key, "brightness") ? 0 : !strcmp(key, "mode") ? 1 : !strcmp(key, "format") ? 2 : -1;
+    if (i < 0 || !legacy[i]) return ESP_ERR_NOT_FOUND;
+    *value = legacy[i];
+    return ESP_OK;
+}
+
+static const settings_backend_t mem_backend = {
+    .load_blob      = mem_load_blob,
+    .save_blob      = mem_save_blob,
+    .load_legacy_u8 = mem_load_legacy_u8,
+};
+
+static const settings_blob_t *saved(void) { return (const settings_blob_t *)mem; }
+
+// Store a blob of len bytes (header included) with the given version
+static void put_blob(uint16_t version, const settings_t *data, size_t len)
+{
+    settings_blob_t b = { .version = version, .size = sizeof(settings_t), .data = *data };
+    memcpy(mem, &b, len);
+    mem_len = len;
+}
+
+// Load through the backend as settings_init does, without starting a task
+static void load(void)
+{
+    backend = &mem_backend;
+    dirty = false;
+    memset(&stored, 0, sizeof(stored));
+    load_settings();
+}
+
+static void sleep_ticks(int ticks) { usleep(ticks * TICK_US); }
+
+// ------------ tests ------------
+
+static void test_nvs_failure(void)
+{
+    // First thing at boot: no task, no mutex yet
+    CHECK(settings_init(NULL) != ESP_OK);
+    CHECK_EQ(nvs_inits, 1);
+
+    settings_t s = settings_get();
+    CHECK_EQ(s.brightness, defaults.brightness);
+    CHECK_EQ(s.mode, defaults.mode);
+    CHECK_EQ(s.format, defaults.format);
+
+    settings_stats_t st;
+    settings_get_stats(&st);             // must not wait on a missing mutex
+    CHECK_EQ(st.commits, 0);
+
+    // Setters keep working in RAM; nothing to write to
+    settings_set_brightness(5);
+    CHECK_EQ(settings_get().brightness, 5);
+    CHECK_EQ(settings_flush(), ESP_ERR_INVALID_STATE);
+}
+
+static void test_short_and_unknown_blobs(void)
+{
+    settings_t d = { .brightness = 7, .mode = 2, .format = 1, .panel_width = 128, .refresh_hz = 240 };
+
+    // The full current layout
+    put_blob(SETTINGS_VERSION, &d, sizeof(settings_blob_t));
+    load();
+    CHECK_EQ(current.brightness, 7);
+    CHECK_EQ(current.panel_width, 128);
+    CHECK_EQ(current.refresh_hz, 240);
+    CHECK(!dirty);
+
+    // An older, shorter layout of the same version: only brightness stored
+    put_blob(SETTINGS_VERSION, &d, offsetof(settings_blob_t, data) + 1);
+    load();
+    CHECK_EQ(current.brightness, 7);
+    CHECK_EQ(current.mode, defaults.mode);
+    CHECK_EQ(current.panel_width, 0);
+    CHECK(!dirty);
+
+    // size in the header shorter than the bytes read: the header wins
+    put_blob(SETTINGS_VERSION, &d, sizeof(settings_blob_t));
+    ((settings_blob_t *)mem)->size = 2;
+    load();
+    CHECK_EQ(current.brightness, 7);
+    CHECK_EQ(current.mode, 2);
+    CHECK_EQ(current.format, defaults.format);
+
+    // Shorter than the header
+    put_blob(SETTINGS_VERSION, &d, 3);
+    memset(legacy, 0, sizeof(legacy));
+    load();
+    CHECK(!memcmp(&current, &defaults, sizeof(current)));
+    CHECK(dirty);
+
+    // A version this firmware does not know: defaults, rewritten on the next commit
+    put_blob(SETTINGS_VERSION + 1, &d, sizeof(settings_blob_t));
+    load();
+    CHECK(!memcmp(&current, &defaults, sizeof(current)));
+    CHECK(dirty);
+    saves = 0;
+    CHECK_EQ(commit(), ESP_OK);
+    CHECK_EQ(saves, 1);
+    CHECK_EQ(saved()->version, SETTINGS_VERSION);
+    CHECK_EQ(saved()->data.brightness, defaults.brightness);
+}
+
+static void test_legacy_migration(void)
+{
+    mem_len = 0;
+    legacy[0] = 3;      // brightness
+    legacy[1] = 1;      // mode
+    legacy[2] = 0;      // format absent: default
+    load();
+    CHECK_EQ(current.brightness, 3);
+    CHECK_EQ(current.mode, 1);
+    CHECK_EQ(current.format, defaults.format);
+    CHECK(dirty);
+
+    // The first commit creates the blob, even with values equal to the defaults
+    saves = 0;
+    CHECK_EQ(commit(), ESP_OK);
+    CHECK_EQ(saves, 1);
+    CHECK_EQ(mem_len, sizeof(settings_blob_t));
+    CHECK_EQ(saved()->data.brightness, 3);
+
+    // From then on the blob is read and the legacy keys are ignored
+    legacy[0] = 9;
+    load();
+    CHECK_EQ(current.brightness, 3);
+    CHECK(!dirty);
+}
+
+static void test_debounced_commit(void)
+{
+    settings_t d = defaults;
+    put_blob(SETTINGS_VERSION, &d, sizeof(settings_blob_t));
+    stats = (settings_stats_t){ 0 };
+    saves = 0;
+    dirty = false;
+    CHECK_EQ(settings_init(&mem_backend), ESP_OK);
+    sleep_ticks(3 * pdMS_TO_TICKS(SETTINGS_COMMIT_DELAY_MS));
+    CHECK_EQ(saves, 0);                  // loaded blob is what flash holds
+
+    // A burst of menu presses, each well inside the quiet time
+    for (int i = 1; i <= 10; i++) {
+        settings_set_brightness(i);
+        settings_set_mode(i % 5);
+        sleep_ticks(pdMS_TO_TICKS(SETTINGS_COMMIT_DELAY_MS) / 10);
+    }
+    CHECK_EQ(saves, 0);
+    sleep_ticks(3 * pdMS_TO_TICKS(SETTINGS_COMMIT_DELAY_MS));
+
+    settings_stats_t st;
+    settings_get_stats(&st);
+    CHECK_EQ(saves, 1);
+    CHECK_EQ(st.commits, 1);
+    CHECK_EQ(saved()->data.brightness, 10);
+    CHECK_EQ(saved()->data.mode, 0);
+
+    // Setting what is already stored wakes the task but writes nothing
+    settings_set_brightness(10);
+    sleep_ticks(3 * pdMS_TO_TICKS(SETTINGS_COMMIT_DELAY_MS));
+    settings_get_stats(&st);
+    CHECK_EQ(saves, 1);
+    CHECK_EQ(st.skipped, 1);
+
+    // A change and back again before the quiet time ends: nothing to write either
+    settings_set_format(1);
+    settings_set_format(0);
+    sleep_ticks(3 * pdMS_TO_TICKS(SETTINGS_COMMIT_DELAY_MS));
+    settings_get_stats(&st);
+    CHECK_EQ(saves, 1);
+    CHECK_EQ(st.skipped, 2);
+
+    // flush writes at once
+    settings_set_refresh_hz(960);
+    CHECK_EQ(settings_flush(), ESP_OK);
+    CHECK_EQ(saves, 2);
+    CHECK_EQ(saved()->data.refresh_hz, 960);
+}
+
+int main(void)
+{
+    test_nvs_failure();
+    test_short_and_unknown_blobs();
+    test_legacy_migration();
+    test_debounced_commit();
+    return host_test_done("test_settings");
+}
@@ -0,0 +1,159 @@
+// temp_pipeline.c: median spike rejection, EMA seeding and step response,
+// display hysteresis at degree edges, bands, trend, invalid samples and the
+// change callback.
+#include <string.h>
+#include "host_test.h"
+#include "temp_pipeline.h"
+
+static int changes;
+static temp_reading_t last_change;
+
+static void on_change(const temp_reading_t *r, void *arg)
+{
+    changes++;
+    last_change = *r;
+}
+
+static temp_reading_t push(int16_t q4)
+{
+    temp_reading_t r;
+    temp_pipeline_push(q4, true);
+    temp_pipeline_get(&r);
+    return r;
+}
+
+static void start(void)
+{
+    temp_pipeline_init(on_change, NULL);
+    changes = 0;
+}
+
+static void test_seed_and_spike(void)
+{
+    start();
+    temp_reading_t r = push(21 * 16 + 8);        // 21.5 °C
+    CHECK(r.valid);
+    CHECK_EQ(r.filtered_q4, 21 * 16 + 8);        // seeded, no ramp from zero
+    CHECK_EQ(r.display_c, 21);
+    CHECK_EQ(r.band, TEMP_BAND_WARM);
+    CHECK_EQ(changes, 1);
+
+    for (int i = 0; i < 6; i++) push(21 * 16 + 8);
+    r = push(60 * 16);                           // one bad conversion
+    CHECK_EQ(r.filtered_q4, 21 * 16 + 8);
+    r = push(21 * 16 + 8);
+    CHECK_EQ(r.filtered_q4, 21 * 16 + 8);
+    CHECK_EQ(changes, 1);
+
+    // Two spikes in a window of five still lose the median
+    push(-40 * 16);
+    push(-40 * 16);
+    r = push(21 * 16 + 8);
+    CHECK_EQ(r.filtered_q4, 21 * 16 + 8);
+    CHECK_EQ(changes, 1);
+}
+
+static void test_step_response(void)
+{
+    start();
+    for (int i = 0; i < TEMP_PIPE_WINDOW; i++) push(20 * 16);
+
+    // Step to 30.5 °C: the median passes it after half a window, the EMA then
+    // closes the gap by 1/2^EMA_SHIFT per sample, never overshooting
+    const int16_t target = 30 * 16 + 8;
+    int16_t prev = 20 * 16;
+    int settled = -1;
+    for (int i = 0; i < 40; i++) {
+        temp_reading_t r = push(target);
+        CHECK(r.filtered_q4 >= prev);
+        CHECK(r.filtered_q4 <= target);
+        if (settled < 0 && r.filtered_q4 == target) settled = i;
+        prev = r.filtered_q4;
+    }
+    CHECK(settled > TEMP_PIPE_WINDOW / 2);
+    CHECK(settled < 30);
+    CHECK_EQ(last_change.display_c, 30);
+    CHECK_EQ(last_change.band, TEMP_BAND_HOT);
+}
+
+static void test_hysteresis(void)
+{
+    start();
+    for (int i = 0; i < 20; i++) push(19 * 16 + 12);        // 19.75
+    CHECK_EQ(last_change.display_c, 19);
+    int before = changes;
+
+    // Noise around the 20.0 edge, within TEMP_PIPE_HYST_Q4: no flicker
+    static const int16_t noise[] = { 319, 322, 318, 321, 323, 320, 317, 322, 321, 319 };
+    for (int k = 0; k < 5; k++) {
+        for (unsigned i = 0; i < sizeof(noise) / sizeof(noise[0]); i++) {
+            temp_reading_t r = push(noise[i]);
+            CHECK_EQ(r.display_c, 19);
+        }
+    }
+    CHECK_EQ(changes, before);
+
+    // Clearly past the edge: the digit and the band change together, once
+    for (int i = 0; i < 20; i++) push(20 * 16 + TEMP_PIPE_HYST_Q4 + 4);
+    CHECK_EQ(changes, before + 1);
+    CHECK_EQ(last_change.display_c, 20);
+    CHECK_EQ(last_change.band, TEMP_BAND_WARM);
+
+    // Back just under 20.0 but inside the hysteresis: stays 20
+    for (int i = 0; i < 20; i++) push(20 * 16 - TEMP_PIPE_HYST_Q4 + 1);
+    CHECK_EQ(last_change.display_c, 20);
+    CHECK_EQ(changes, before + 1);
+}
+
+static void test_trend(void)
+{
+    start();
+    temp_reading_t r;
+    for (int i = 0; i < 10; i++) r = push(15 * 16);
+    CHECK_EQ(r.trend, TEMP_TREND_FLAT);
+    for (int i = 0; i < 10; i++) r = push((int16_t)(15 * 16 + 4 * i));
+    CHECK_EQ(r.trend, TEMP_TREND_UP);
+    for (int i = 0; i < 30; i++) r = push(15 * 16 + 36);
+    CHECK_EQ(r.trend, TEMP_TREND_FLAT);
+    for (int i = 0; i < 10; i++) r = push((int16_t)(15 * 16 + 36 - 4 * i));
+    CHECK_EQ(r.trend, TEMP_TREND_DOWN);
+}
+
+static void test_invalid_and_limits(void)
+{
+    start();
+    for (int i = 0; i < 10; i++) push(5 * 16);
+    CHECK_EQ(last_change.band, TEMP_BAND_COLD);
+
+    temp_pipeline_push(0, false);
+    CHECK_EQ(changes, 2);
+    CHECK(!last_change.valid);
+    temp_pipeline_push(0, false);
+    CHECK_EQ(changes, 2);                           // still invalid: no news
+
+    // The probe comes back: the window restarts and the first sample seeds it
+    temp_reading_t r = push(12 * 16);
+    CHECK(r.valid);
+    CHECK_EQ(r.filtered_q4, 12 * 16);
+    CHECK_EQ(r.band, TEMP_BAND_COOL);
+    CHECK_EQ(changes, 3);
+
+    start();
+    r = push(-30 * 16);
+    CHECK_EQ(r.display_c, TEMP_PIPE_MIN_C);        // one minus digit on the display
+    CHECK_EQ(r.filtered_q4, -30 * 16);
+
+    uint32_t seq = r.seq;
+    r = push(-30 * 16);
+    CHECK_EQ(r.seq, seq + 1);
+}
+
+int main(void)
+{
+    test_seed_and_spike();
+    test_step_response();
+    test_hysteresis();
+    test_trend();
+    test_invalid_and_limits();
+    return host_test_done("test_temp_pipeline");
+}
@@ -0,0 +1,131 @@
+// transition.c: slide and wipe checked in virtual coordinates on walls whose
+// planes are not the screen row for row (2x2 panels on one chain, 2x1 split
+// over two chains), against the plain row path on a single panel row; dissolve
+// and fade end points.
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "transition.h"
+
+#define DEPTH   2
+#define PW      16      // panel
+#define PH      8
+
+// Wall: n_hor x n_ver panels over chains, mapped like led_panel.c set_pixel
+static int n_hor, n_ver, chains, per_chain, phy_w, phy_h;
+
+static uint32_t offset(int x, int y)
+{
+    int panel = (y / PH) * n_hor + x / PW;
+    int chain = panel / per_chain;
+    return (uint32_t)((chain * PH + y % PH) * phy_w + (panel % per_chain) * PW + x % PW);
+}
+
+static void wall(int h, int v, int c)
+{
+    n_hor = h;
+    n_ver = v;
+    chains = c;
+    per_chain = h * v / c;
+    phy_w = per_chain * PW;
+    phy_h = c * PH;
+}
+
+static uint8_t from_buf[DEPTH][4 * PW * PH], to_buf[DEPTH][4 * PW * PH];
+static uint8_t *from[DEPTH] = { from_buf[0], from_buf[1] };
+static uint8_t *to[DEPTH] = { to_buf[0], to_buf[1] };
+
+// Distinct values per scene, pixel and plane
+static uint8_t old_px(int x, int y, int p) { return (uint8_t)(1 + x + 3 * y + 50 * p) | 0x80; }
+static uint8_t new_px(int x, int y, int p) { return (uint8_t)(1 + x + 3 * y + 50 * p) & 0x7F; }
+
+static void fill(int vw, int vh)
+{
+    for (int p = 0; p < DEPTH; p++)
+        for (int y = 0; y < vh; y++)
+            for (int x = 0; x < vw; x++) {
+                from[p][offset(x, y)] = old_px(x, y, p);
+                to[p][offset(x, y)] = new_px(x, y, p);
+            }
+}
+
+static void test_wall(int h, int v, int c)
+{
+    wall(h, v, c);
+    const int vw = h * PW, vh = v * PH;
+    static uint32_t seg[64];
+    static uint8_t line[2 * 4 * PW];
+    transition_rows_t rows = { .width = vw, .height = vh, .seg_width = PW, .seg = seg, .line = line };
+    bool segmented = transition_build_rows(&rows, phy_w, offset);
+    CHECK_EQ(segmented, per_chain != h);     // a chain holding more or less than one panel row
+
+    const transition_geom_t g = {
+        .width = phy_w, .height = phy_h, .depth = DEPTH, .rows = segmented ? &rows : NULL,
+    };
+
+    for (int step = 0; step <= 8; step++) {
+        fx_t progress = step * FX_ONE / 8;
+
+        // SLIDE: the new scene enters from the right, the old one leaves left
+        fill(vw, vh);
+        transition_apply(&g, TRANSITION_SLIDE, progress, from, to);
+        int shift = (int)(((int64_t)progress * vw) >> FX_SHIFT);
+        for (int p = 0; p < DEPTH; p++)
+            for (int y = 0; y < vh; y++)
+                for (int x = 0; x < vw; x++) {
+                    uint8_t want = x < vw - shift ? old_px(x + shift, y, p) : new_px(x - (vw - shift), y, p);
+                    if (step == 8) want = new_px(x, y, p);
+                    CHECK_EQ(to[p][offset(x, y)], want);
+                    if (host_test_failures) return;
+                }
+
+        // WIPE: the new scene uncovers from the top of the whole wall
+        fill(vw, vh);
+        transition_apply(&g, TRANSITION_WIPE, progress, from, to);
+        int rows_new = step == 8 ? vh : (int)(((int64_t)progress * vh) >> FX_SHIFT);
+        for (int p = 0; p < DEPTH; p++)
+            for (int y = 0; y < vh; y++)
+                for (int x = 0; x < vw; x++) {
+                    CHECK_EQ(to[p][offset(x, y)], y < rows_new ? new_px(x, y, p) : old_px(x, y, p));
+                    if (host_test_failures) return;
+                }
+    }
+}
+
+static void test_dissolve_fade(void)
+{
+    wall(2, 2, 1);
+    static uint8_t rank[4 * PW * PH];
+    transition_build_ranks(rank, sizeof(rank), 42);
+    const transition_geom_t g = { .width = phy_w, .height = phy_h, .depth = DEPTH, .rank = rank };
+
+    // Every rank level used equally often
+    int count[128] = { 0 };
+    for (unsigned i = 0; i < sizeof(rank); i++) count[rank[i]]++;
+    for (int i = 0; i < 128; i++) CHECK_EQ(count[i], (int)sizeof(rank) / 128);
+
+    fill(2 * PW, 2 * PH);
+    transition_apply(&g, TRANSITION_DISSOLVE, 0, from, to);
+    CHECK(memcmp(to_buf, from_buf, sizeof(to_buf)) == 0);
+
+    fill(2 * PW, 2 * PH);
+    transition_apply(&g, TRANSITION_FADE, 0, from, to);
+    CHECK(memcmp(to_buf, from_buf, sizeof(to_buf)) == 0);
+
+    // Half way through a fade everything is black
+    fill(2 * PW, 2 * PH);
+    transition_apply(&g, TRANSITION_FADE, FX_ONE / 2, from, to);
+    for (int p = 0; p < DEPTH; p++)
+        for (int i = 0; i < phy_w * phy_h; i++) CHECK_EQ(to[p][i], 0);
+}
+
+int main(void)
+{
+    test_wall(4, 1, 1);     // one panel row, one chain: plain plane rows
+    test_wall(2, 2, 1);     // two panel rows on one chain
+    test_wall(2, 1, 2);     // one panel row split over two chains
+    test_wall(2, 2, 2);     // one panel row per chain: the planes are the screen again
+    test_wall(1, 4, 2);
+    test_dissolve_fade();
+    return host_test_done("test_transition");
+}
@@ -0,0 +1,274 @@
+// uart_stream.c's decoder on a loopback: frames built like
+// tools/uart_stream_send.py are fed in chunks of every size, slower than
+// UART_STREAM_IDLE_MS end to end, with the task's idle check between chunks.
+// Checks pixels, acks, swaps and when the panel is claimed and released.
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+
+// The decoder and the idle check are static: test them in place
+#include "uart_stream.c"
+
+// ------------ virtual clock, panel and port ------------
+
+#define W   64
+#define H   32
+
+led_geometry_t led_geom = { .virt_width = W, .virt_height = H };
+
+static int64_t now_us;
+int64_t esp_timer_get_time(void) { return now_us; }
+
+static uint16_t back[H][W], front[H][W];
+static int claims, releases, swaps;
+
+void set_pixel(int x, int y, int r8, int g8, int b8)
+{
+    back[y][x] = ((r8 >> 3) << 11) | ((g8 >> 2) << 5) | (b8 >> 3);
+}
+
+void swap_buffers(void)
+{
+    uint16_t t[H][W];
+    memcpy(t, front, sizeof(t));
+    memcpy(front, back, sizeof(t));
+    memcpy(back, t, sizeof(t));
+    swaps++;
+}
+
+void copy_front_to_back(void) { memcpy(back, front, sizeof(back)); }
+
+void copy_front_to_back_rect(int x, int y, int w, int h)
+{
+    for (int j = y; j < y + h; j++) memcpy(&back[j][x], &front[j][x], w * sizeof(back[0][0]));
+}
+bool led_panel_claim(TickType_t wait) { claims++; return true; }
+void led_panel_release(void) { releases++; }
+
+void led_panel_get_refresh_stats(led_refresh_stats_t *out) { memset(out, 0, sizeof(*out)); }
+void led_panel_reset_row_overrun(void) {}
+uint32_t led_panel_max_refresh_hz(void) { return 0; }
+void uart_capture_snapshot(void) {}
+void uart_capture_mirror(int fps) {}
+TickType_t uart_capture_poll(void) { return portMAX_DELAY; }
+void trace_dump(trace_write_t write, void *arg) {}
+void monitor_report(int minutes, monitor_write_t write, void *arg) {}
+
+// Acks the device sent back
+static uint8_t acks[64][5];
+static int n_acks;
+
+int uart_write_bytes(uart_port_t port, const void *data, size_t len)
+{
+    if (len == 5 && n_acks < 64) memcpy(acks[n_acks++], data, 5);
+    return (int)len;
+}
+
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t len, TickType_t wait) { return 0; }
+esp_err_t uart_flush_input(uart_port_t port) { return ESP_OK; }
+esp_err_t uart_driver_install(uart_port_t port, int rx, int tx, int n, QueueHandle_t *q, int flags) { return ESP_OK; }
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *cfg) { return ESP_OK; }
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) { return pdFALSE; }
+BaseType_t xQueueReset(QueueHandle_t q) { return pdTRUE; }
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *h, BaseType_t core) { return pdPASS; }
+
+// ------------ sender ------------
+
+static uint8_t wire[UART_STREAM_HDR_SIZE + W * H * 2 + 2];
+
+static uint16_t pattern(int x, int y, int k) { return (uint16_t)(x * 977 + y * 131 + k * 7919); }
+
+// One frame into wire[], pixels pattern(k) over the rect; returns its length
+static int build(int type, int flags, int seq, int x, int y, int w, int h, int k, bool bad_crc)
+{
+    uint8_t *p = wire;
+    *p++ = UART_STREAM_SYNC0;
+    *p++ = UART_STREAM_SYNC1;
+    *p++ = type;
+    *p++ = flags;
+    const int v[5] = { seq, x, y, w, h };
+    for (int i = 0; i < 5; i++) {
+        *p++ = v[i] & 0xFF;
+        *p++ = v[i] >> 8;
+    }
+    uint16_t crc = uart_stream_crc16(0xFFFF, &wire[2], 12);
+    *p++ = crc & 0xFF;
+    *p++ = crc >> 8;
+
+    uint8_t *px = p;
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) {
+            uint16_t c = pattern(i, j, k);
+            *p++ = c & 0xFF;
+            *p++ = c >> 8;
+        }
+    }
+    crc = uart_stream_crc16(0xFFFF, px, p - px) ^ (bad_crc ? 1 : 0);
+    *p++ = crc & 0xFF;
+    *p++ = crc >> 8;
+    return p - wire;
+}
+
+// Feed len bytes in chunks of 1..max, step_us apart, as uart_stream_task does
+static void send(const uint8_t *data, int len, int max, int64_t step_us)
+{
+    for (int i = 0; i < len; ) {
+        int n = 1 + rand() % max;
+        if (n > len - i) n = len - i;
+        now_us += step_us;
+        feed(data + i, n);
+        release_panel_if_idle();
+        i += n;
+    }
+}
+
+static bool shown(int x, int y, int w, int h, int k)
+{
+    for (int j = y; j < y + h; j++)
+        for (int i = x; i < x + w; i++)
+            if (front[j][i] != pattern(i, j, k)) return false;
+    return true;
+}
+
+static void check_ack(int seq, int status)
+{
+    CHECK(n_acks > 0);
+    if (!n_acks) return;
+    const uint8_t *a = acks[n_acks - 1];
+    CHECK_EQ(a[0], UART_STREAM_SYNC1);
+    CHECK_EQ(a[1], UART_STREAM_SYNC0);
+    CHECK_EQ(a[2] | (a[3] << 8), seq);
+    CHECK_EQ(a[4], status);
+}
+
+// ------------ tests ------------
+
+static void test_slow_first_frame(void)
+{
+    // The first frame of a session, 4 KB at 60 bytes per 400 ms: it takes ~30 s,
+    // each gap well under UART_STREAM_IDLE_MS, and last_rx_us starts stale
+    now_us = 100 * 1000000LL;
+    int len = build(UART_STREAM_FULL, 0, 1, 0, 0, W, H, 1, false);
+    send(wire, len, 60, 400 * 1000);
+
+    CHECK_EQ(claims, 1);
+    CHECK_EQ(releases, 0);
+    CHECK_EQ(stats.frames, 1);
+    CHECK_EQ(swaps, 1);
+    CHECK(shown(0, 0, W, H, 1));
+    check_ack(1, UART_STREAM_ACK_OK);
+
+    // Quiet between frames: the panel goes back once, after the idle time
+    now_us += UART_STREAM_IDLE_MS * 1000LL - 1000;
+    release_panel_if_idle();
+    CHECK_EQ(releases, 0);
+    now_us += 2000;
+    release_panel_if_idle();
+    CHECK_EQ(releases, 1);
+    CHECK(!uart_stream_active());
+}
+
+static void test_stall_mid_frame(void)
+{
+    // A sender that dies half way through a rect: the partial rect is dropped,
+    // nothing of it reaches the screen, then the panel goes back
+    int len = build(UART_STREAM_RECT, UART_STREAM_FLAG_PRESENT, 2, 8, 4, 20, 10, 2, false);
+    send(wire, len / 2, 32, 1000);
+    CHECK(uart_stream_active());
+    CHECK_EQ(claims, 2);
+
+    now_us += UART_STREAM_IDLE_MS * 1000LL + 1000;
+    release_panel_if_idle();
+    CHECK_EQ(stats.stalled, 1);
+    CHECK_EQ(releases, 2);
+    CHECK_EQ(rx.state, ST_SYNC0);
+    CHECK(shown(0, 0, W, H, 1));
+    CHECK(memcmp(back, front, sizeof(back)) == 0);
+
+    // The next sender starts clean
+    send(wire, len, 32, 1000);
+    CHECK_EQ(claims, 3);
+    CHECK_EQ(stats.presented, 2);
+    CHECK(shown(8, 4, 20, 10, 2));
+    CHECK(shown(0, 0, 8, H, 1));
+    check_ack(2, UART_STREAM_ACK_OK);
+}
+
+static void test_chunk_sizes(void)
+{
+    // Rects with noise between them, in chunks from 1 byte to several frames
+    static uint8_t stream[8 * sizeof(wire)];
+    static const int max_chunk[] = { 1, 2, 3, 17, 512, 4096 };
+    int seq = 10;
+
+    for (unsigned c = 0; c < sizeof(max_chunk) / sizeof(max_chunk[0]); c++) {
+        int n = 0, frames = stats.frames, bad = stats.bad_crc;
+        for (int f = 0; f < 6; f++) {
+            int x = rand() % W, y = rand() % H;
+            int w = 1 + rand() % (W - x), h = 1 + rand() % (H - y);
+            bool corrupt = f == 3;
+            int len = build(UART_STREAM_RECT, UART_STREAM_FLAG_PRESENT, seq, x, y, w, h, seq, corrupt);
+            seq++;
+            memcpy(stream + n, wire, len);
+            n += len;
+            stream[n++] = 0x00;                      // line noise the decoder must skip
+            stream[n++] = UART_STREAM_SYNC0;
+        }
+        send(stream, n, max_chunk[c], 5000);
+        CHECK_EQ(stats.frames, frames + 5);
+        CHECK_EQ(stats.bad_crc, bad + 1);
+        CHECK_EQ(stats.bad_header, 0);
+        CHECK(memcmp(back, front, sizeof(back)) == 0);
+    }
+    CHECK_EQ(stats.stalled, 1);
+    CHECK_EQ(claims - releases, 1);
+}
+
+static void test_bad_crc_keeps_pending_rects(void)
+{
+    // Two rects acked OK but not presented yet, a third one corrupted on the
+    // wire, then a present: the first two reach the screen, the bad one's area
+    // shows what was there before
+    uint16_t before[H][W];
+    memcpy(before, front, sizeof(before));
+    int presented = stats.presented;
+
+    int len = build(UART_STREAM_RECT, 0, 40, 0, 0, 16, 8, 40, false);
+    send(wire, len, 64, 1000);
+    check_ack(40, UART_STREAM_ACK_OK);
+    len = build(UART_STREAM_RECT, 0, 41, 40, 20, 10, 10, 41, false);
+    send(wire, len, 64, 1000);
+    check_ack(41, UART_STREAM_ACK_OK);
+
+    len = build(UART_STREAM_RECT, 0, 42, 16, 0, 24, 20, 42, true);
+    send(wire, len, 64, 1000);
+    check_ack(42, UART_STREAM_ACK_BAD_CRC);
+    CHECK_EQ(stats.presented, presented);
+
+    len = build(UART_STREAM_RECT, UART_STREAM_FLAG_PRESENT, 43, 60, 0, 4, 4, 43, false);
+    send(wire, len, 64, 1000);
+    check_ack(43, UART_STREAM_ACK_OK);
+    CHECK_EQ(stats.presented, presented + 1);
+
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++) {
+            uint16_t want = before[y][x];              // including the bad rect's area
+            if (x < 16 && y < 8) want = pattern(x, y, 40);
+            if (x >= 40 && x < 50 && y >= 20 && y < 30) want = pattern(x, y, 41);
+            if (x >= 60 && y < 4) want = pattern(x, y, 43);
+            CHECK_EQ(front[y][x], want);
+            if (host_test_failures) return;
+        }
+}
+
+int main(void)
+{
+    srand(31);
+    crc16_init_table();
+    test_slow_first_frame();
+    test_stall_mid_frame();
+    test_chunk_sizes();
+    test_bad_crc_keeps_pending_rects();
+    return host_test_done("test_uart_stream");
+}
@@ -0,0 +1,470 @@
+#!/usr/bin/env python3
+"""Predict refresh rate, frame memory and refresh CPU load of a panel wall.
+
+    python3 tools/capacity_plan.py --panel 64x32 --scan 16 --wall 4x3 --chains 2
+    python3 tools/capacity_plan.py --panels 1-16 --target 960 --calibrate monitor.log
+    python3 tools/capacity_plan.py --selftest
+
+The refresh side runs the firmware's own code. components/led_panel/
+refresh_model.c, with scan_pattern.c, row_plan.c and the row gather of
+hub75_bits.h, is compiled for the host ($CC or cc) and called through ctypes:
+the scan map gives the columns shifted per address, the fast-path planner the
+rows shifted for the chosen content, the governor the grid for a target rate.
+
+Loop costs are CPU cycles of an output backend. The GPIO bit-bang backend is
+the only one; its costs are estimates until calibrated. --calibrate takes a
+serial log with "#M timing" lines (UART_STREAM_CMD_MONITOR) from one or more
+installations and fits the shift cost per row and per column, and the staging
+cost per row and per byte, to them; the more geometries, the more is fitted.
+
+Memory follows the firmware's led_panel_alloc() calls: frames of at least
+PSRAM_BULK_FRAME_BYTES put the bulk buffers in PSRAM, the rest spills there
+when --internal-kb runs out. The "ram" and "psram"
+fields of the same "#M timing" line are what a device actually placed.
+"""
+import argparse
+import ctypes
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+LED = os.path.join(ROOT, "components", "led_panel")
+MODEL_SRCS = ["refresh_model.c", "scan_pattern.c", "row_plan.c"]
+
+# CPU cycles per operation of refresh_task's loop
+BACKENDS = {
+    "gpio": {
+        "mhz": 240,
+        "row": 1200,         # per shifted row: address, latch, OE off/on, timer reads
+        "col": 48,           # per shifted column: LUT, set/clear, clock
+        "chain_col": 8,      # per column, each further chain (one more LUT OR)
+        "stage_row": 240,    # per staged row: call, stats
+        "stage_byte": 10,    # per staged byte, planes in internal RAM
+        "psram_byte": 24,    # per staged byte, planes in PSRAM
+    },
+}
+
+TIMING = re.compile(r"#M timing panel (\d+)x(\d+) scan (\d+) panels (\d+) chains (\d+) depth (\d+) cols (\d+)"
+                    r"\s+shift (\d+) ns\s+stage (\d+) ns\s+ram (\d+) psram (\d+)")
+
+
+# ------------ firmware configuration ------------
+
+def header_defines(*paths):
+    """Integer #defines of the headers, expressions over earlier ones evaluated"""
+    values = {}
+    for path in paths:
+        with open(path) as f:
+            for line in f:
+                m = re.match(r"\s*#define\s+(\w+)\s+(.+?)\s*(//.*)?$", line)
+                if not m:
+                    continue
+                expr = re.sub(r"\b(\w+)\b", lambda w: str(values.get(w.group(1), w.group(1))), m.group(2))
+                if re.fullmatch(r"[\d\s()+\-*/<>]+", expr):
+                    values[m.group(1)] = int(eval(expr.replace("/", "//")))
+    return values
+
+
+def firmware_config():
+    cfg = header_defines(os.path.join(LED, "led_panel.h"), os.path.join(LED, "dither_quant.h"),
+                         os.path.join(ROOT, "main", "main.c"))
+    with open(os.path.join(LED, "compositor.h")) as f:
+        enum = re.search(r"typedef enum \{(.*?)COMPOSITOR_LAYERS", f.read(), re.S).group(1)
+    cfg["COMPOSITOR_LAYERS"] = len(re.findall(r"^\s*LAYER_\w+", enum, re.M))
+    return cfg
+
+
+# ------------ the firmware's refresh code, built for the host ------------
+
+class ScanPattern(ctypes.Structure):
+    _fields_ = [("name", ctypes.c_char * 6), ("addr_bits", ctypes.c_uint8), ("addr_rows", ctypes.c_uint8),
+                ("chunks", ctypes.c_uint8), ("lower_offset", ctypes.c_uint8), ("chunk_y", ctypes.c_int16 * 4)]
+
+
+class ScanCol(ctypes.Structure):
+    _fields_ = [("fb_x", ctypes.c_uint16), ("y_offset", ctypes.c_uint8)]
+
+
+class Pass(ctypes.Structure):
+    _fields_ = [("slots", ctypes.c_uint32), ("units", ctypes.c_uint32), ("repeat", ctypes.c_uint32),
+                ("slice_ns", ctypes.c_uint32), ("pass_ns", ctypes.c_uint32), ("busy_ns", ctypes.c_uint32),
+                ("late", ctypes.c_uint32), ("unmet", ctypes.c_bool)]
+
+
+def build_model(workdir):
+    lib = os.path.join(workdir, "librefresh_model.so")
+    cc = os.environ.get("CC", "cc")
+    cmd = [cc, "-O2", "-std=gnu11", "-shared", "-fPIC", "-I", LED, "-o", lib] + \
+          [os.path.join(LED, s) for s in MODEL_SRCS]
+    subprocess.run(cmd, check=True)
+    m = ctypes.CDLL(lib)
+    u8p, u32p = ctypes.POINTER(ctypes.c_uint8), ctypes.POINTER(ctypes.c_uint32)
+    m.scan_pattern_folded.argtypes = [ctypes.POINTER(ScanPattern), ctypes.c_int, ctypes.c_int]
+    m.scan_validate.argtypes = [ctypes.POINTER(ScanPattern), ctypes.c_int, ctypes.c_int]
+    m.scan_build_map.argtypes = [ctypes.POINTER(ScanPattern), ctypes.c_int, ctypes.c_int, ctypes.c_int,
+                                 ctypes.POINTER(ScanCol), ctypes.c_int]
+    m.refresh_model_plan.argtypes = [ctypes.POINTER(u8p), ctypes.c_int, ctypes.c_int, ctypes.c_uint32, u32p,
+                                     ctypes.c_int, ctypes.c_int, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_bool,
+                                     u8p, u8p]
+    m.refresh_model_pass.argtypes = [u8p, ctypes.c_int, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32,
+                                     ctypes.c_uint32, ctypes.POINTER(Pass)]
+    m.refresh_max_hz.argtypes = [ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32]
+    m.refresh_max_hz.restype = ctypes.c_uint32
+    return m
+
+
+class Wall:
+    """Derived sizes, as led_panel_set_geometry() computes them"""
+
+    def __init__(self, m, width, height, scan, n_hor, n_ver, chains, depth):
+        panels = n_hor * n_ver
+        if width % 4 or panels % chains:
+            raise ValueError("panel width must be a multiple of 4 and panels a multiple of chains")
+        self.pat = ScanPattern()
+        if m.scan_pattern_folded(ctypes.byref(self.pat), scan, height) or \
+                m.scan_validate(ctypes.byref(self.pat), width, height):
+            raise ValueError("scan 1/%d does not fit a %dx%d panel" % (scan, width, height))
+        self.width, self.height, self.scan, self.depth, self.chains = width, height, scan, depth, chains
+        self.n_hor, self.n_ver, self.panels = n_hor, n_ver, panels
+        self.per_chain = panels // chains
+        self.virt_w, self.virt_h = width * n_hor, height * n_ver
+        self.phy_w, self.phy_h = width * self.per_chain, height * chains
+        self.plane_bytes = self.phy_w * self.phy_h
+
+        cap = self.phy_w * self.pat.chunks
+        cmap = (ScanCol * cap)()
+        self.cols = m.scan_build_map(ctypes.byref(self.pat), width, height, self.per_chain, cmap, cap)
+        if self.cols <= 0:
+            raise ValueError("scan map does not fit")
+        self.col_off = (ctypes.c_uint32 * self.cols)(*[c.y_offset * self.phy_w + c.fb_x for c in cmap[:self.cols]])
+
+    def planes(self, content):
+        """Plane bytes of a test frame: every pixel at one level, or a ramp"""
+        top = (1 << self.depth) - 1
+        if content == "ramp":
+            # Level x % (top + 1): every plane differs and none is empty, nothing to skip or merge
+            row = [x % (top + 1) for x in range(self.phy_w)]
+        else:
+            level = {"white": top, "black": 0}.get(content)
+            if level is None:
+                level = int(content.split(":")[1])
+            row = [level] * self.phy_w
+        out = []
+        for p in range(self.depth):
+            bits = bytes(((v >> p) & 1) * 0x07 for v in row)
+            out.append((ctypes.c_uint8 * self.plane_bytes).from_buffer_copy(bits * self.phy_h))
+        return out
+
+    def plan(self, m, content, fast):
+        planes = self.planes(content)
+        arr = (ctypes.POINTER(ctypes.c_uint8) * self.depth)(
+            *[ctypes.cast(p, ctypes.POINTER(ctypes.c_uint8)) for p in planes])
+        stage = (ctypes.c_uint8 * (self.depth * self.cols * self.chains))()
+        units = (ctypes.c_uint8 * (self.depth * self.scan))()
+        m.refresh_model_plan(arr, self.depth, self.scan, self.phy_w, self.col_off, self.cols, self.chains,
+                             self.height * self.phy_w, self.pat.lower_offset * self.phy_w, fast, stage, units)
+        return units
+
+
+# ------------ costs ------------
+
+def costs_ns(costs, wall, psram):
+    ns = 1000.0 / costs["mhz"]
+    shift = (costs["row"] + wall.cols * (costs["col"] + (wall.chains - 1) * costs["chain_col"])) * ns
+    byte = costs["psram_byte"] if psram else costs["stage_byte"]
+    stage = (costs["stage_row"] + wall.cols * wall.chains * byte) * ns
+    return int(shift), int(stage)
+
+
+def solve(rows, y):
+    """Least squares for a few unknowns (normal equations, Gauss-Jordan)"""
+    n = len(rows[0])
+    a = [[sum(r[i] * r[j] for r in rows) for j in range(n)] + [sum(r[i] * v for r, v in zip(rows, y))]
+         for i in range(n)]
+    for i in range(n):
+        piv = max(range(i, n), key=lambda k: abs(a[k][i]))
+        a[i], a[piv] = a[piv], a[i]
+        if abs(a[i][i]) < 1e-9:
+            raise ValueError("calibration points do not tell the costs apart")
+        for k in range(n):
+            if k != i:
+                f = a[k][i] / a[i][i]
+                a[k] = [x - f * z for x, z in zip(a[k], a[i])]
+    return [a[i][n] / a[i][i] for i in range(n)]
+
+
+def calibrate(costs, lines):
+    """Fit the costs to "#M timing" lines; the last line per geometry counts"""
+    points = {}
+    for line in lines:
+        m = TIMING.search(line)
+        if m:
+            v = [int(g) for g in m.groups()]
+            points[tuple(v[:7])] = v
+    if not points:
+        raise SystemExit("no '#M timing' line to calibrate from")
+    c = dict(costs)
+    cyc = c["mhz"] / 1000.0
+
+    # Shift: row + cols * (col + (chains - 1) * chain_col), as many unknowns as the points allow
+    pts = [(v[6], v[4], v[7] * cyc) for v in points.values() if v[7]]
+    geoms = {(cols, chains) for cols, chains, _ in pts}
+    if len(geoms) >= 3 and len({ch for _, ch in geoms}) > 1:
+        c["row"], c["col"], c["chain_col"] = solve([[1, cols, cols * (ch - 1)] for cols, ch, _ in pts],
+                                                   [s for _, _, s in pts])
+    elif len({cols for cols, _ in geoms}) >= 2:
+        c["row"], c["col"] = solve([[1, cols] for cols, ch, _ in pts],
+                                   [s - cols * (ch - 1) * c["chain_col"] for cols, ch, s in pts])
+    elif pts:
+        c["col"] = sum((s - c["row"]) / (cols * (1 + (ch - 1) * c["chain_col"] / c["col"]))
+                       for cols, ch, s in pts) / len(pts)
+
+    # Staging, per byte from where the frames were (psram > 0: PSRAM)
+    for key, in_psram in (("stage_byte", False), ("psram_byte", True)):
+        st = [(v[6] * v[4], v[8] * cyc) for v in points.values() if v[8] and (v[10] > 0) == in_psram]
+        if len({b for b, _ in st}) >= 2:
+            c["stage_row"], c[key] = solve([[1, b] for b, _ in st], [s for _, s in st])
+        elif st:
+            c[key] = sum((s - c["stage_row"]) / b for b, s in st) / len(st)
+    for k in ("row", "col", "chain_col", "stage_row", "stage_byte", "psram_byte"):
+        c[k] = max(c[k], 0.0)          # noise on a near-zero cost
+    return c, sorted(points.values())
+
+
+# ------------ memory ------------
+
+def memory(cfg, wall, internal_budget):
+    """(name, bytes, in PSRAM, spilled) per buffer in allocation order, placed as led_panel_alloc()
+    places them: bulk buffers in PSRAM once a frame reaches PSRAM_BULK_FRAME_BYTES, and
+    whatever does not fit the internal budget in the other memory"""
+    d, pb, scan, cols, ch = wall.depth, wall.plane_bytes, wall.scan, wall.cols, wall.chains
+    frame = d * pb
+    bulk_psram = frame >= cfg["PSRAM_BULK_FRAME_BYTES"]
+    bufs = [
+        ("pixel map", wall.virt_w * 4 + wall.virt_h * 6 + wall.panels * 4, False),
+        ("frame buffer A", frame, True),
+        ("frame buffer B", frame, True),
+        ("scan map", cols * 4, False),
+        ("row stage", cols * ch, False),
+        ("scan list", d * scan * 4, False),
+    ]
+    if cfg.get("SCAN_FAST_PATHS", 1):
+        bufs += [("plan stage", d * cols * ch, False), ("plan units", d * scan, False),
+                 ("fast scan lists", 2 * d * scan * 4, False)]
+    flash = d * scan * cols * ch
+    if flash <= cfg["FLASH_SCAN_MAX_BYTES"]:
+        bufs.append(("flash scan frame", flash, False))
+    bufs += [("compositor layers", cfg["COMPOSITOR_LAYERS"] * frame, True),
+             ("compositor base", frame, True),
+             ("transition frame", frame, True),
+             ("dissolve order", pb, True),
+             ("dither canvas", 3 * pb, True),
+             ("dither sub-frames", 2 * pb * cfg["DITHER_OUT_BYTES"], True)]
+    if cfg.get("CONTENT_RGB_CANVAS"):
+        bufs.append(("RGB canvas", 2 * pb, True))
+    bufs += [("capture frame", frame, True), ("capture rows", d * wall.virt_w * wall.virt_h, True),
+             ("capture row", d * wall.virt_w, False), ("capture rle", d * wall.virt_w, False)]
+
+    placed, free = [], internal_budget
+    for name, b, bulk in bufs:
+        psram = bulk and bulk_psram
+        if not psram and b > free:
+            psram = True               # internal first, PSRAM when it runs out
+        if not psram:
+            free -= b
+        placed.append((name, b, psram, psram and not (bulk and bulk_psram)))
+    flash_scan = any(n == "flash scan frame" and not ps for n, _, ps, _ in placed)
+    return placed, flash_scan
+
+
+# ------------ report ------------
+
+def predict(m, cfg, costs, wall, content, target, internal_kb=160, fast=True):
+    bufs, flash_scan = memory(cfg, wall, internal_kb * 1024)
+    planes_psram = dict((n, ps) for n, _, ps, _ in bufs)["frame buffer A"]
+    shift_ns, stage_ns = costs_ns(costs, wall, planes_psram)
+    units = wall.plan(m, content, fast and cfg.get("SCAN_FAST_PATHS", 1))
+    full = wall.plan(m, content, False)
+    res = {}
+    for name, u, hz in (("free", units, 0), ("target", units, target), ("full", full, 0)):
+        p = Pass()
+        m.refresh_model_pass(u, len(u), shift_ns, stage_ns, cfg["BASE_US"], hz, ctypes.byref(p))
+        res[name] = p
+    full_units = sum(1 << p for p in range(wall.depth)) * wall.scan
+    max_hz = m.refresh_max_hz(wall.depth * wall.scan, full_units, shift_ns * 16 // 1000)
+    internal = sum(b for _, b, ps, _ in bufs if not ps)
+    psram = sum(b for _, b, ps, _ in bufs if ps)
+    return dict(shift_ns=shift_ns, stage_ns=stage_ns, bufs=bufs, planes_psram=planes_psram,
+                spilled=[n for n, _, _, sp in bufs if sp], flash_scan=flash_scan,
+                max_hz=max_hz, internal=internal, psram=psram, **res)
+
+
+def hz(p):
+    return 1e9 / p.pass_ns if p.pass_ns else 0
+
+
+def report(args, cfg, costs, wall, r):
+    print("wall %dx%d of %dx%d 1/%d panels (%d), %d chain(s) of %d, depth %d, %s backend at %d MHz" %
+          (wall.n_hor, wall.n_ver, wall.width, wall.height, wall.scan, wall.panels, wall.chains,
+           wall.per_chain, wall.depth, args.backend, costs["mhz"]))
+    print("  %d columns per address per chain; shift %.1f us/row, stage %.1f us/row (planes in %s)" %
+          (wall.cols, r["shift_ns"] / 1000, r["stage_ns"] / 1000, "PSRAM" if r["planes_psram"] else "internal RAM"))
+    full, free = r["full"], r["free"]
+    print("  every row:   %4d rows x %3d slices, pass %7.1f us = %6.0f Hz, core 0 %3.0f%% shifting/staging, "
+          "%d late" % (full.slots, full.units, full.pass_ns / 1000, hz(full),
+                        100.0 * full.busy_ns / full.pass_ns, full.late))
+    print("  %-11s  %4d rows x %3d slices, pass %7.1f us = %6.0f Hz, core 0 %3.0f%% shifting/staging, "
+          "%d late" % (args.content + ":", free.slots, free.units, free.pass_ns / 1000, hz(free),
+                        100.0 * free.busy_ns / free.pass_ns if free.pass_ns else 0, free.late))
+    print("  led_panel_max_refresh_hz(): %d Hz (shift time only, staging overlaps the slices)" % r["max_hz"])
+    if args.target:
+        t = r["target"]
+        if t.unmet:
+            print("  target %d Hz: NOT MET, runs at %.0f Hz with %.1f us slices" %
+                  (args.target, hz(t), t.slice_ns / 1000))
+        else:
+            print("  target %d Hz: %d pass(es) per period, slice %.1f us, core 0 %.0f%% shifting/staging" %
+                  (args.target, t.repeat, t.slice_ns / 1000, 100.0 * t.busy_ns / t.pass_ns))
+    print("  memory: %.1f KB internal, %.1f KB PSRAM%s" %
+          (r["internal"] / 1024, r["psram"] / 1024,
+           "" if r["flash_scan"] else "; frame too big for the flash-write scan, panel blanks during writes"))
+    if r["spilled"]:
+        print("  WARNING: over the %d KB of internal RAM, in PSRAM instead: %s" %
+              (args.internal_kb, ", ".join(r["spilled"])))
+    if args.memory:
+        for name, b, psram, _ in r["bufs"]:
+            print("    %-18s %8d  %s" % (name, b, "PSRAM" if psram else "internal"))
+
+
+def summary_header():
+    print("panels  cols  shift_us  full_Hz  content_Hz  max_target  target      internal_KB  psram_KB")
+
+
+def summary(args, wall, r):
+    t = ""
+    if args.target:
+        t = "unmet" if r["target"].unmet else "x%d %.1fus" % (r["target"].repeat, r["target"].slice_ns / 1000)
+    print("%6d  %4d  %8.1f  %7.0f  %10.0f  %10d  %-10s  %11.1f  %8.1f%s" %
+          (wall.panels, wall.cols, r["shift_ns"] / 1000, hz(r["full"]), hz(r["free"]), r["max_hz"], t,
+           r["internal"] / 1024, r["psram"] / 1024, "  spilled" if r["spilled"] else ""))
+
+
+def selftest():
+    with tempfile.TemporaryDirectory() as tmp:
+        m = build_model(tmp)
+        cfg = firmware_config()
+        costs = dict(BACKENDS["gpio"])
+        assert cfg["COMPOSITOR_LAYERS"] == 3 and cfg["BASE_US"] == 30, cfg
+
+        # The default sign: 64x32 1/8, 8 addresses in two folded runs
+        w = Wall(m, 64, 32, 8, 1, 1, 1, cfg["COLOR_DEPTH"])
+        assert w.cols == 128 and w.plane_bytes == 2048
+        r = predict(m, cfg, costs, w, "ramp", 0)
+        assert (r["full"].slots, r["full"].units) == (24, 56)
+        assert (r["free"].slots, r["free"].units) == (24, 56), "a ramp has nothing to skip or merge"
+        full = r["full"]
+        assert full.pass_ns == 24 * r["shift_ns"] + 56 * 30000, full.pass_ns
+        assert predict(m, cfg, costs, w, "white", 0)["free"].slots == 8, "saturated: one shift per row"
+        assert predict(m, cfg, costs, w, "black", 0)["free"].slots == 0
+        assert predict(m, cfg, costs, w, "level:2", 0)["free"].slots == 8, "one plane lit"
+
+        # On a grid the period is exact; an impossible target is flagged
+        t = predict(m, cfg, costs, w, "ramp", 240)["target"]
+        assert not t.unmet and t.repeat * 240 * t.pass_ns in range(999999000, 1000000001), (t.repeat, t.pass_ns)
+        assert predict(m, cfg, costs, w, "ramp", 5000)["target"].unmet
+
+        # Memory: 3 planes of 2 KB, bulk stays internal below PSRAM_BULK_FRAME_BYTES
+        bufs = dict((n, b) for n, b, _, _ in r["bufs"])
+        assert bufs["frame buffer A"] == 6144 and bufs["scan map"] == 512 and r["psram"] == 0
+        big = predict(m, cfg, costs, Wall(m, 64, 32, 16, 4, 4, 2, 3), "ramp", 0)
+        assert big["psram"] > 0 and not big["flash_scan"] and not big["spilled"]
+        two = predict(m, cfg, costs, Wall(m, 64, 32, 8, 2, 1, 1, 3), "ramp", 0, internal_kb=160)
+        assert "frame buffer A" not in two["spilled"] and "dither sub-frames" in two["spilled"], two["spilled"]
+
+        # Calibration: lines made with known costs give the costs back
+        truth = dict(costs, row=1500, col=60, stage_row=300, stage_byte=12)
+        lines = ["I (123) boot"]
+        for cols, ch in ((128, 1), (256, 1), (512, 1)):
+            wl = Wall(m, 64, 32, 8, cols // 128, 1, 1, 3)
+            s, st = costs_ns(truth, wl, False)
+            lines.append("#M timing panel 64x32 scan 8 panels %d chains %d depth 3 cols %d  shift %d ns  "
+                         "stage %d ns  ram 30000 psram 0" % (wl.panels, ch, wl.cols, s, st))
+        got, pts = calibrate(costs, lines)
+        assert len(pts) == 3
+        assert abs(got["row"] - 1500) < 10 and abs(got["col"] - 60) < 0.1, got
+        assert abs(got["stage_row"] - 300) < 10 and abs(got["stage_byte"] - 12) < 0.1, got
+
+        summary_header()
+        for n in (1, 2, 4, 8):
+            wl = Wall(m, 64, 32, 8, n, 1, 1, 3)
+            summary(argparse.Namespace(target=240), wl, predict(m, cfg, costs, wl, "ramp", 240))
+    print("PASS")
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--panel", default="64x32", help="panel WxH")
+    ap.add_argument("--scan", type=int, default=8, help="row addresses: 8, 16 or 32")
+    ap.add_argument("--wall", help="panels across x down, e.g. 4x3")
+    ap.add_argument("--panels", help="panels in one row, or a range A-B for a table")
+    ap.add_argument("--chains", type=int, default=1)
+    ap.add_argument("--depth", type=int, help="colour planes (default COLOR_DEPTH)")
+    ap.add_argument("--backend", default="gpio", choices=sorted(BACKENDS))
+    ap.add_argument("--cpu-mhz", type=int)
+    ap.add_argument("--content", default="ramp",
+                    help="ramp (every row of every plane shifted: worst case), white, black or level:N")
+    ap.add_argument("--target", type=int, default=0, help="refresh rate target, Hz (REFRESH_TARGET_HZ)")
+    ap.add_argument("--calibrate", help="serial log with '#M timing' lines")
+    ap.add_argument("--internal-kb", type=int, default=160, help="internal RAM free for the panel buffers")
+    ap.add_argument("--memory", action="store_true", help="list every buffer")
+    ap.add_argument("--selftest", action="store_true")
+    args = ap.parse_args()
+
+    if args.selftest:
+        return selftest()
+
+    cfg = firmware_config()
+    costs = dict(BACKENDS[args.backend])
+    if args.cpu_mhz:
+        costs["mhz"] = args.cpu_mhz
+    if args.calibrate:
+        with open(args.calibrate, errors="replace") as f:
+            costs, pts = calibrate(costs, f)
+        print("calibrated from %d geometr%s: row %.0f, column %.1f, chain column %.1f, staged row %.0f, "
+              "byte %.1f / %.1f (PSRAM) cycles" % (len(pts), "y" if len(pts) == 1 else "ies", costs["row"],
+                                                   costs["col"], costs["chain_col"], costs["stage_row"],
+                                                   costs["stage_byte"], costs["psram_byte"]))
+    depth = args.depth or cfg["COLOR_DEPTH"]
+    width, height = (int(v) for v in args.panel.lower().split("x"))
+
+    with tempfile.TemporaryDirectory() as tmp:
+        m = build_model(tmp)
+        try:
+            if args.panels and "-" in args.panels:
+                lo, hi = (int(v) for v in args.panels.split("-"))
+                summary_header()
+                for n in range(lo, hi + 1):
+                    if n % args.chains:
+                        continue
+                    wall = Wall(m, width, height, args.scan, n, 1, args.chains, depth)
+                    r = predict(m, cfg, costs, wall, args.content, args.target, args.internal_kb)
+                    summary(args, wall, r)
+                return 0
+            if args.wall:
+                n_hor, n_ver = (int(v) for v in args.wall.lower().split("x"))
+            else:
+                n_hor, n_ver = int(args.panels or 1), 1
+            wall = Wall(m, width, height, args.scan, n_hor, n_ver, args.chains, depth)
+        except ValueError as e:
+            ap.error(str(e))
+        r = predict(m, cfg, costs, wall, args.content, args.target, args.internal_kb)
+        report(args, cfg, costs, wall, r)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
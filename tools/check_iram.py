@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""Check the link map: the panel refresh path must not live in flash.
+
+    python3 tools/check_iram.py build/app-template.map
+    python3 tools/check_iram.py --selftest
+
+A settings commit writes flash with the cache off, and the refresh keeps going
+from a timer ISR meanwhile (led_panel_flash_begin). Any of its code in flash
+would crash that ISR; any of it in flash at other times stretches rows on cache
+misses. The top-level CMakeLists.txt runs this after every link and fails the
+build on a violation.
+
+Static functions have no symbol in the map. With -ffunction-sections every
+function not marked IRAM_ATTR is its own .text.<name> / .literal.<name> input
+section (data: .rodata.<name>), and its address says where it went: flash,
+or IRAM when a linker fragment maps it noflash (row_plan.c, refresh_model.c).
+"""
+import argparse
+import re
+import sys
+
+# object file -> (code that must be in IRAM, data that must be in DRAM)
+REFRESH = {
+    "led_panel.c.obj": (["refresh_task", "stage_row", "shift_row", "pass_planes", "update_oe_duty",
+                         "oe_off", "note_lit", "flash_scan_isr", "led_panel_swap_count",
+                         "plan_step", "pick_list"],
+                        ["gamma_table"]),
+    "row_plan.c.obj": (["row_plan_units", "all_zero"], []),
+    "refresh_model.c.obj": (["refresh_grid_plan", "refresh_duty_scale"], []),
+    "dither.c.obj": (["dither_frame_planes"], []),
+    "trace.c.obj": (["trace_event"], []),
+}
+# IDF functions the refresh calls (CONFIG_LEDC_CTRL_FUNC_IN_IRAM, CONFIG_ESP_TIMER_IN_IRAM)
+IDF_CODE = ["ledc_set_duty", "ledc_update_duty", "esp_timer_get_time"]
+
+RANGES = {
+    "esp32":   {"iram": (0x40080000, 0x400A0000), "dram": (0x3FFAE000, 0x40000000)},
+    "esp32s3": {"iram": (0x40370000, 0x403E0000), "dram": (0x3FC88000, 0x3FD00000)},
+}
+
+SECTION = re.compile(r"^ (\.\S+)(?:\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(\S+))?\s*$")
+CONT = re.compile(r"^\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(\S+)\s*$")
+SYMBOL = re.compile(r"^\s+(0x[0-9a-f]+)\s+([A-Za-z_]\w*)\s*$")
+
+
+def parse(lines):
+    """Input sections (name, addr, size, object) and global symbols {name: addr} of the link"""
+    sections, symbols = [], {}
+    it = iter(lines)
+    for line in it:
+        if line.startswith("Linker script and memory map"):
+            break                      # skip the discarded input sections
+    pending = None
+    for line in it:
+        line = line.rstrip("\n")
+        if pending:
+            m = CONT.match(line)
+            if m:
+                sections.append((pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3)))
+            pending = None
+            continue
+        m = SECTION.match(line)
+        if m:
+            if m.group(2):
+                sections.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)))
+            else:
+                pending = m.group(1)   # long name: address, size and object on the next line
+            continue
+        m = SYMBOL.match(line)
+        if m:
+            symbols[m.group(2)] = int(m.group(1), 16)
+    return sections, symbols
+
+
+def check(lines, target="esp32"):
+    """List of problems, empty when the refresh path is all in IRAM/DRAM"""
+    iram, dram = RANGES[target]["iram"], RANGES[target]["dram"]
+    sections, symbols = parse(lines)
+    problems = []
+
+    def in_range(addr, r):
+        return r[0] <= addr < r[1]
+
+    for obj, (code, data) in REFRESH.items():
+        mine = [s for s in sections if s[3].endswith("(" + obj + ")") and s[2] > 0]
+        if not mine:
+            problems.append("%s not in the map" % obj)
+            continue
+        for name, addr, size, _ in mine:
+            kind, _, fn = name[1:].partition(".")
+            if kind in ("text", "literal") and fn in code and not in_range(addr, iram):
+                problems.append("%s: %s in flash at 0x%08x" % (obj, fn, addr))
+            if kind == "rodata" and fn in data and not in_range(addr, dram):
+                problems.append("%s: %s in flash at 0x%08x" % (obj, fn, addr))
+        for fn in code:
+            if fn in symbols and not in_range(symbols[fn], iram):
+                problems.append("%s at 0x%08x, not IRAM" % (fn, symbols[fn]))
+        for d in data:
+            if d in symbols and not in_range(symbols[d], dram):
+                problems.append("%s at 0x%08x, not DRAM" % (d, symbols[d]))
+
+    for fn in IDF_CODE:
+        if fn not in symbols:
+            problems.append("%s not in the map" % fn)
+        elif not in_range(symbols[fn], iram):
+            problems.append("%s at 0x%08x, not IRAM (sdkconfig)" % (fn, symbols[fn]))
+    return problems
+
+
+def selftest():
+    good = """Discarded input sections
+
+ .text.refresh_task
+                0x00000000       0x20 esp-idf/led_panel/libled_panel.a(led_panel.c.obj)
+
+Linker script and memory map
+
+ .iram1.4       0x40080100      0x1a0 esp-idf/led_panel/libled_panel.a(led_panel.c.obj)
+                0x40080100                refresh_task
+ .iram1.5       0x400802a0       0x40 esp-idf/led_panel/libled_panel.a(led_panel.c.obj)
+ .text.draw_text
+                0x400d2000       0x40 esp-idf/led_panel/libled_panel.a(led_panel.c.obj)
+ .dram1.0       0x3ffb0000      0x100 esp-idf/led_panel/libled_panel.a(led_panel.c.obj)
+                0x3ffb0000                gamma_table
+ .text.row_plan_units
+                0x40080f00       0x60 esp-idf/led_panel/libled_panel.a(row_plan.c.obj)
+                0x40080f00                row_plan_units
+ .text.refresh_grid_plan
+                0x40080f60       0x80 esp-idf/led_panel/libled_panel.a(refresh_model.c.obj)
+                0x40080f60                refresh_grid_plan
+ .text.refresh_max_hz
+                0x400d3000       0x30 esp-idf/led_panel/libled_panel.a(refresh_model.c.obj)
+                0x400d3000                refresh_max_hz
+ .iram1.0       0x40081000       0x30 esp-idf/led_panel/libled_panel.a(dither.c.obj)
+                0x40081000                dither_frame_planes
+ .iram1.0       0x40081100       0x30 esp-idf/trace/libtrace.a(trace.c.obj)
+                0x40081100                trace_event
+ .iram1.2       0x40082000       0x80 esp-idf/esp_driver_ledc/libesp_driver_ledc.a(ledc.c.obj)
+                0x40082000                ledc_set_duty
+                0x40082040                ledc_update_duty
+ .iram1.1       0x40083000       0x20 esp-idf/esp_timer/libesp_timer.a(esp_timer.c.obj)
+                0x40083000                esp_timer_get_time
+""".splitlines(True)
+    assert check(good) == [], check(good)
+
+    bad = [l.replace(" .iram1.5       0x400802a0", " .text.stage_row 0x400d02a0")
+            .replace(" .dram1.0       0x3ffb0000", " .rodata.gamma_table\n                0x3f400000")
+            .replace("0x3ffb0000                gamma_table", "0x3f400000                gamma_table")
+            .replace("0x40082040                ledc_update_duty", "0x400d4040                ledc_update_duty")
+           for l in good]
+    got = check("".join(bad).splitlines(True))
+    for s in ("stage_row in flash", "gamma_table in flash", "gamma_table at 0x3f400000",
+              "ledc_update_duty at 0x400d4040"):
+        assert any(s in p for p in got), (s, got)
+    assert len(got) == 4, got
+    print("\n".join(got))
+    print("PASS")
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("map", nargs="?", help="linker map of the app (build/<project>.map)")
+    ap.add_argument("--target", default="esp32", choices=sorted(RANGES))
+    ap.add_argument("--selftest", action="store_true")
+    args = ap.parse_args()
+
+    if args.selftest:
+        return selftest()
+    if not args.map:
+        ap.error("give the map file")
+
+    with open(args.map, errors="replace") as f:
+        problems = check(f, args.target)
+    if problems:
+        print("check_iram: refresh path not in internal RAM:", file=sys.stderr)
+        for p in problems:
+            print("  " + p, file=sys.stderr)
+        return 1
+    print("check_iram: refresh path in IRAM/DRAM")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""Turn the sign's timeline trace (components/trace/trace.h) into Chrome trace JSON.
+
+    python3 tools/trace_to_chrome.py --port /dev/ttyUSB0 -o trace.json
+    python3 tools/trace_to_chrome.py monitor.log -o trace.json
+    python3 tools/trace_to_chrome.py --selftest
+
+With --port the dump is requested over the stream UART (UART_STREAM_CMD_TRACE);
+otherwise the "#T" lines are taken from a saved serial log. Open the JSON in
+chrome://tracing or ui.perfetto.dev: one process per core, one track per task.
+
+Also prints per-event counts and durations, and every drawing frame gap longer
+than --gap-ms with the spans of other tasks that overlap it (a slow frame next
+to the DS18B20 conversion or the 1-Wire reads shows up there).
+
+Needs pyserial for --port (pip install pyserial).
+"""
+import argparse
+import json
+import struct
+import sys
+import time
+
+CMD_SYNC = b"\xA5\x5A"
+CMD, CMD_TRACE = 3, 3
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def command(cmd, arg=0, seq=0):
+    fields = struct.pack("<BBHHHHH", CMD, 0, seq & 0xFFFF, cmd, arg, 0, 0)
+    return CMD_SYNC + fields + struct.pack("<H", crc16(fields))
+
+
+def parse(lines):
+    """Events of the last complete dump: (core, ts_us, ph, track, name, arg)"""
+    dumps = []
+    cur = None
+    for line in lines:
+        line = line.strip()
+        i = line.find("#T")
+        if i < 0:
+            continue
+        f = line[i:].split()
+        if f[0] == "#T-BEGIN":
+            cur = []
+        elif f[0] == "#T-END" and cur is not None:
+            dumps.append(cur)
+            cur = None
+        elif f[0] == "#T" and cur is not None and len(f) == 7:
+            cur.append((int(f[1]), int(f[2]), f[3], f[4], f[5], int(f[6])))
+    if not dumps:
+        raise SystemExit("no complete #T-BEGIN .. #T-END dump found")
+    return dumps[-1]
+
+
+def unwrap(events):
+    """32-bit µs timestamps -> µs from the first event (one shared clock for both cores)"""
+    if not events:
+        return []
+    ts = [e[1] for e in events]
+    lo = min(ts)
+    wrapped = max(ts) - lo > 1 << 31
+    out = []
+    for e in events:
+        t = e[1] + (1 << 32) if wrapped and e[1] < 1 << 31 else e[1]
+        out.append((e[0], t) + e[2:])
+    base = min(e[1] for e in out)
+    return sorted(((e[0], e[1] - base) + e[2:] for e in out), key=lambda e: e[1])
+
+
+def spans(events):
+    """Matched begin/end pairs per (core, track, name); ends without a begin are dropped"""
+    open_ = {}
+    out = []
+    for core, t, ph, track, name, arg in events:
+        key = (core, track, name)
+        if ph == "B":
+            open_.setdefault(key, []).append(t)
+        elif ph == "E" and open_.get(key):
+            out.append((core, track, name, open_[key].pop(), t))
+    return out
+
+
+def to_chrome(events):
+    trace = []
+    tids = {}
+    for core, t, ph, track, name, arg in events:
+        tid = tids.setdefault(track, len(tids) + 1)
+        ev = {"name": name, "ph": ph, "ts": t, "pid": core, "tid": tid}
+        if ph == "i":
+            ev["s"] = "t"
+            ev["args"] = {"value": arg}
+        trace.append(ev)
+    for core in sorted({e[0] for e in events}):
+        trace.append({"name": "process_name", "ph": "M", "pid": core, "args": {"name": "core %d" % core}})
+        for track, tid in tids.items():
+            trace.append({"name": "thread_name", "ph": "M", "pid": core, "tid": tid, "args": {"name": track}})
+    return {"traceEvents": trace, "displayTimeUnit": "ms"}
+
+
+def report(events, gap_ms):
+    sp = spans(events)
+    if not events:
+        print("empty trace")
+        return
+    length = events[-1][1] - events[0][1]
+    print("%d events over %.1f ms" % (len(events), length / 1000))
+
+    stats = {}
+    for core, track, name, b, e in sp:
+        s = stats.setdefault((track, name, core), [])
+        s.append(e - b)
+    for (track, name, core), d in sorted(stats.items()):
+        busy = 100.0 * sum(d) / length if length else 0
+        print("  %-12s %-8s core %d  n=%-5d mean %8.1f us  max %8.1f us  busy %5.1f%%" %
+              (track, name, core, len(d), sum(d) / len(d), max(d), busy))
+
+    frames = sorted(b for core, track, name, b, e in sp if name == "frame")
+    others = [s for s in sp if s[1] != "DrawTime"]
+    for a, b in zip(frames, frames[1:]):
+        if b - a > gap_ms * 1000:
+            hits = ["%s/%s %.1f ms" % (s[1], s[2], (s[4] - s[3]) / 1000)
+                    for s in others if s[3] < b and s[4] > a and s[2] != "pass"]
+            print("  frame gap %.1f ms at %.1f ms: %s" %
+                  ((b - a) / 1000, a / 1000, ", ".join(hits) or "no other task busy"))
+
+
+def read_serial(args):
+    import serial
+
+    ser = serial.Serial(args.port, args.baud, timeout=0.1)
+    ser.reset_input_buffer()
+    ser.write(command(CMD_TRACE))
+    data = bytearray()
+    deadline = time.monotonic() + args.timeout
+    while time.monotonic() < deadline and b"#T-END" not in data:
+        data += ser.read(ser.in_waiting or 1)
+    text = data.decode("ascii", "replace")
+    if args.save:
+        with open(args.save, "w") as f:
+            f.write(text)
+    return text.splitlines()
+
+
+def selftest():
+    # Two cores: refresh passes on core 0, frames, a long conversion and reads on core 1
+    lines = ["I (10) boot", "#T-BEGIN 2 0 0"]
+    t = (1 << 32) - 20000          # wraps during the trace
+    for i in range(40):
+        lines.append("#T 0 %d B refresh_task pass 0" % ((t + i * 2500) & 0xFFFFFFFF))
+        lines.append("#T 0 %d E refresh_task pass 0" % ((t + i * 2500 + 2400) & 0xFFFFFFFF))
+    frame_at = [0, 50000, 100000, 180000]
+    for f in frame_at:
+        lines.append("#T 1 %d B DrawTime frame 0" % ((t + f) & 0xFFFFFFFF))
+        lines.append("#T 1 %d E DrawTime frame 0" % ((t + f + 3000) & 0xFFFFFFFF))
+    lines.append("#T 1 %d B TempTask read 0" % ((t + 110000) & 0xFFFFFFFF))
+    lines.append("#T 1 %d E TempTask read 0" % ((t + 112000) & 0xFFFFFFFF))
+    lines.append("#T-END")
+
+    ev = unwrap(parse(lines))
+    sp = spans(ev)
+    assert ev[0][1] == 0 and all(a[1] <= b[1] for a, b in zip(ev, ev[1:]))
+    assert len(sp) == 40 + 4 + 1, len(sp)
+    assert [s[3] for s in sp if s[2] == "frame"] == frame_at
+    chrome = to_chrome(ev)
+    json.dumps(chrome)
+    report(ev, 60)
+    print("PASS")
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("log", nargs="?", help="serial log with a #T dump")
+    ap.add_argument("--port")
+    ap.add_argument("--baud", type=int, default=2000000)
+    ap.add_argument("--timeout", type=float, default=5)
+    ap.add_argument("--save", help="--port: also keep the raw dump here")
+    ap.add_argument("-o", "--output", default="trace.json")
+    ap.add_argument("--gap-ms", type=float, default=60, help="report drawing frame gaps longer than this")
+    ap.add_argument("--selftest", action="store_true")
+    args = ap.parse_args()
+
+    if args.selftest:
+        return selftest()
+    if args.port:
+        lines = read_serial(args)
+    elif args.log:
+        with open(args.log, errors="replace") as f:
+            lines = f.readlines()
+    else:
+        ap.error("give a log file or --port")
+
+    events = unwrap(parse(lines))
+    with open(args.output, "w") as f:
+        json.dump(to_chrome(events), f)
+    report(events, args.gap_ms)
+    print("wrote", args.output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,312 @@
+#!/usr/bin/env python3
+"""Capture what the sign is showing over UART (see components/uart_stream/uart_capture.h).
+
+    python3 tools/uart_capture.py --port /dev/ttyUSB0 --snapshot screen.png
+    python3 tools/uart_capture.py --port /dev/ttyUSB0 --mirror 10 --seconds 20 --gif sign.gif
+    python3 tools/uart_capture.py --selftest
+
+--snapshot asks for one frame and writes it as PNG. --mirror keeps the sign
+sending changed rows at the given fps, rebuilds every frame and writes them as an
+animated GIF (and/or --png-dir, one PNG per frame); the mirror is switched off
+again on exit. Pixels are the plane levels the firmware drew (after its gamma
+table), scaled to 0..255 and enlarged --scale times.
+
+Needs pyserial for the real port (pip install pyserial) and Pillow for --gif
+(pip install pillow). PNGs are written without Pillow.
+"""
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+CMD_SYNC = b"\xA5\x5A"
+CAP_SYNC = b"\x5A\xC3"
+CMD_HDR_SIZE = 16
+CAP_HDR_SIZE = 14
+CMD = 3
+CMD_SNAPSHOT, CMD_MIRROR = 1, 2
+FRAME, ROW, END = 1, 2, 3
+FLAG_KEY, FLAG_SNAPSHOT = 0x01, 0x02
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def command(cmd, arg=0, seq=0):
+    fields = struct.pack("<BBHHHHH", CMD, 0, seq & 0xFFFF, cmd, arg, 0, 0)
+    return CMD_SYNC + fields + struct.pack("<H", crc16(fields))
+
+
+def rle_decode(data, n):
+    out = bytearray()
+    for b in data:
+        out += bytes([b & 7]) * ((b >> 3) + 1)
+    if len(out) != n:
+        raise ValueError("row decodes to %d cells, expected %d" % (len(out), n))
+    return out
+
+
+def rle_encode(cells):
+    """Python copy of plane_rle_encode, used by --selftest"""
+    out = bytearray()
+    i = 0
+    while i < len(cells):
+        v = cells[i] & 7
+        run = 1
+        while i + run < len(cells) and run < 32 and cells[i + run] & 7 == v:
+            run += 1
+        out.append(((run - 1) << 3) | v)
+        i += run
+    return bytes(out)
+
+
+class Frame:
+    def __init__(self, width, height, depth, rows):
+        self.width, self.height, self.depth = width, height, depth
+        self.rows = rows            # y -> depth * width cells
+
+    def rgb(self):
+        """Row-major RGB bytes, levels scaled to 0..255"""
+        top = (1 << self.depth) - 1
+        w = self.width
+        out = bytearray(w * self.height * 3)
+        for y in range(self.height):
+            cells = self.rows[y]
+            o = y * w * 3
+            for x in range(w):
+                r = g = b = 0
+                for p in range(self.depth):
+                    c = cells[p * w + x]
+                    r |= (c & 1) << p
+                    g |= ((c >> 1) & 1) << p
+                    b |= ((c >> 2) & 1) << p
+                out[o:o + 3] = bytes((r * 255 // top, g * 255 // top, b * 255 // top))
+                o += 3
+        return out
+
+
+class Receiver:
+    """Rebuilds frames from the capture stream; text before a frame (the boot ROM
+    prints on UART0 before the app starts; the app itself has no console) is skipped"""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.rows = {}              # the picture so far, kept across mirror deltas
+        self.size = None
+        self.pending = None         # (seq, flags, width, height, depth) of the frame being received
+        self.frames = 0
+        self.errors = 0
+        self.wire = 0
+
+    def feed(self, data):
+        self.buf += data
+        frames = []
+        while True:
+            i = self.buf.find(CAP_SYNC)
+            if i < 0:
+                del self.buf[:max(0, len(self.buf) - 1)]
+                return frames
+            if len(self.buf) - i < CAP_HDR_SIZE:
+                del self.buf[:i]
+                return frames
+            hdr = self.buf[i:i + CAP_HDR_SIZE]
+            kind, flags, seq, a, b, depth, _, hcrc = struct.unpack("<BBHHHBBH", hdr[2:])
+            if crc16(hdr[2:12]) != hcrc:
+                del self.buf[:i + 1]
+                continue
+
+            end = i + CAP_HDR_SIZE
+            if kind == ROW:
+                end += b + 2
+                if len(self.buf) < end:
+                    del self.buf[:i]
+                    return frames
+            body = self.buf[i + CAP_HDR_SIZE:end]
+            del self.buf[:end]
+            self.wire += end - i
+
+            if kind == FRAME:
+                if (a, b, depth) != self.size:
+                    self.size = (a, b, depth)
+                    self.rows = {}
+                self.pending = (seq, flags)
+            elif kind == ROW and self.pending and self.pending[0] == seq:
+                w, h, d = self.size
+                payload, (pcrc,) = body[:-2], struct.unpack("<H", body[-2:])
+                if crc16(payload) != pcrc or a >= h:
+                    self.errors += 1
+                    continue
+                self.rows[a] = rle_decode(payload, d * w)
+            elif kind == END and self.pending and self.pending[0] == seq:
+                w, h, d = self.size
+                if len(self.rows) == h:
+                    frames.append((self.pending[1], Frame(w, h, d, dict(self.rows))))
+                    self.frames += 1
+                self.pending = None
+
+
+def scaled(frame, scale):
+    rgb = frame.rgb()
+    w, h = frame.width, frame.height
+    out = bytearray()
+    for y in range(h):
+        row = bytearray()
+        for x in range(w):
+            row += rgb[(y * w + x) * 3:(y * w + x) * 3 + 3] * scale
+        out += bytes(row) * scale
+    return w * scale, h * scale, out
+
+
+def write_png(path, frame, scale):
+    w, h, rgb = scaled(frame, scale)
+    raw = b"".join(b"\x00" + bytes(rgb[y * w * 3:(y + 1) * w * 3]) for y in range(h))
+
+    def chunk(tag, data):
+        return struct.pack(">I", len(data)) + tag + data + struct.pack(">I", zlib.crc32(tag + data) & 0xFFFFFFFF)
+
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", w, h, 8, 2, 0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(raw, 9)))
+        f.write(chunk(b"IEND", b""))
+
+
+def write_gif(path, frames, scale):
+    from PIL import Image
+
+    images = []
+    durations = []
+    for t, frame, dt in frames:
+        w, h, rgb = scaled(frame, scale)
+        images.append(Image.frombytes("RGB", (w, h), bytes(rgb)))
+        durations.append(max(20, int(dt * 1000)))
+    images[0].save(path, save_all=True, append_images=images[1:], duration=durations, loop=0)
+
+
+def run_serial(args):
+    import serial
+
+    ser = serial.Serial(args.port, args.baud, timeout=0.05)
+    rx = Receiver()
+    got = []
+    start = time.monotonic()
+
+    if args.snapshot:
+        ser.write(command(CMD_SNAPSHOT))
+        deadline = start + 3
+        while time.monotonic() < deadline and not got:
+            got = [f for flags, f in rx.feed(ser.read(ser.in_waiting or 1)) if flags & FLAG_SNAPSHOT]
+        if not got:
+            print("no snapshot received (%d bad rows)" % rx.errors)
+            return 1
+        write_png(args.snapshot, got[0], args.scale)
+        print("%s: %dx%d, %d bytes on the wire" % (args.snapshot, got[0].width, got[0].height, rx.wire))
+        return 0
+
+    ser.write(command(CMD_MIRROR, args.mirror))
+    last = None
+    try:
+        while time.monotonic() - start < args.seconds:
+            for flags, frame in rx.feed(ser.read(ser.in_waiting or 1)):
+                now = time.monotonic()
+                if last is not None:
+                    got[-1] = (got[-1][0], got[-1][1], now - last)
+                got.append((now, frame, 1.0 / args.mirror))
+                last = now
+                if args.png_dir:
+                    write_png(os.path.join(args.png_dir, "frame%05d.png" % len(got)), frame, args.scale)
+    finally:
+        ser.write(command(CMD_MIRROR, 0))
+
+    el = time.monotonic() - start
+    print("%d frames in %.1f s (%.1f fps), %.1f KiB/s, %d bad rows" %
+          (len(got), el, len(got) / el, rx.wire / el / 1024, rx.errors))
+    if args.gif and got:
+        write_gif(args.gif, got, args.scale)
+        print("wrote", args.gif)
+    return 0
+
+
+def run_selftest(args):
+    """Same wire format as uart_capture.c, built here and fed through the receiver"""
+    w, h, depth = args.width, args.height, 3
+
+    def picture(t):
+        cells = {}
+        for y in range(h):
+            row = bytearray(depth * w)
+            for x in range(w):
+                level = (7 if abs(x - (t * 3) % w) < 4 else 0, (y * 7) // h, 7 if y == t % h else 0)
+                for p in range(depth):
+                    row[p * w + x] = sum(((level[c] >> p) & 1) << c for c in range(3))
+            cells[y] = bytes(row)
+        return cells
+
+    def header(kind, flags, seq, a, b):
+        fields = struct.pack("<BBHHHBB", kind, flags, seq, a, b, depth, 0)
+        return CAP_SYNC + fields + struct.pack("<H", crc16(fields))
+
+    rx = Receiver()
+    sent = {}
+    raw = wire = 0
+    n = 30
+    for t in range(n):
+        pic = picture(t)
+        key = t % 10 == 0
+        out = header(FRAME, FLAG_KEY if key else 0, t, w, h)
+        for y in range(h):
+            if not key and sent.get(y) == pic[y]:
+                continue
+            sent[y] = pic[y]
+            enc = rle_encode(pic[y])
+            out += header(ROW, 0, t, y, len(enc)) + enc + struct.pack("<H", crc16(enc))
+            raw += len(pic[y])
+        out += header(END, 0, t, 0, 0)
+        wire += len(out)
+        frames = rx.feed(b"ets Jun  8 2016 00:22:57\r\n" + out)
+        if len(frames) != 1 or frames[0][1].rows != pic:
+            print("FAIL at frame", t)
+            return 1
+
+    print("selftest: %d frames of %dx%d rebuilt, %d cell bytes in %d wire bytes (%.1fx)" %
+          (n, w, h, raw, wire, raw / wire))
+    if args.snapshot:
+        write_png(args.snapshot, frames[0][1], args.scale)
+    print("PASS")
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--port")
+    ap.add_argument("--baud", type=int, default=2000000)
+    ap.add_argument("--snapshot", metavar="PNG", help="write one frame to this file")
+    ap.add_argument("--mirror", type=int, metavar="FPS", default=10)
+    ap.add_argument("--seconds", type=float, default=10)
+    ap.add_argument("--gif", help="mirror: animated GIF of every frame (needs Pillow)")
+    ap.add_argument("--png-dir", help="mirror: one PNG per frame in this directory")
+    ap.add_argument("--scale", type=int, default=8)
+    ap.add_argument("--width", type=int, default=64, help="selftest picture size")
+    ap.add_argument("--height", type=int, default=32)
+    ap.add_argument("--selftest", action="store_true")
+    args = ap.parse_args()
+
+    if args.selftest:
+        return run_selftest(args)
+    if not args.port:
+        ap.error("--port is required unless --selftest")
+    if not args.snapshot and not (args.gif or args.png_dir):
+        ap.error("give --snapshot, or --gif / --png-dir for the mirror")
+    return run_serial(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""Stream frames to the sign over UART (see components/uart_stream/uart_stream.h).
+
+    python3 tools/uart_stream_send.py --port /dev/ttyUSB0 --seconds 10
+    python3 tools/uart_stream_send.py --port /dev/ttyUSB0 --rect 16 8 --seconds 10
+    python3 tools/uart_stream_send.py --selftest
+
+Every frame is acknowledged by the device, so the reported fps is what the sign
+actually decoded and presented, not just what left the PC. --selftest runs the
+same encoder through a Python copy of the device decoder, no hardware needed.
+
+Needs pyserial for the real port (pip install pyserial).
+"""
+import argparse
+import math
+import struct
+import sys
+import time
+
+SYNC = b"\xA5\x5A"
+ACK_SYNC = b"\x5A\xA5"
+HDR_SIZE = 16
+FULL, RECT = 1, 2
+FLAG_PRESENT = 0x01
+ACK_NAMES = {0: "ok", 1: "bad header", 2: "bad crc"}
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def rgb565(r, g, b):
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+def encode(ftype, flags, seq, x, y, w, h, pixels):
+    """pixels: w*h RGB565 ints, row major"""
+    fields = struct.pack("<BBHHHHH", ftype, flags, seq & 0xFFFF, x, y, w, h)
+    payload = struct.pack("<%dH" % len(pixels), *pixels)
+    return (SYNC + fields + struct.pack("<H", crc16(fields)) +
+            payload + struct.pack("<H", crc16(payload)))
+
+
+def pattern(t, x0, y0, w, h):
+    """Moving rainbow, enough change per frame to see dropped frames"""
+    px = []
+    for y in range(y0, y0 + h):
+        for x in range(x0, x0 + w):
+            v = (x * 4 + y * 2 + t * 3) & 0xFF
+            r = int(127 + 127 * math.sin(v / 40.7))
+            g = int(127 + 127 * math.sin(v / 40.7 + 2.1))
+            b = int(127 + 127 * math.sin(v / 40.7 + 4.2))
+            px.append(rgb565(r, g, b))
+    return px
+
+
+class Decoder:
+    """Mirror of the device state machine, used by --selftest"""
+
+    def __init__(self, width, height):
+        self.width, self.height = width, height
+        self.buf = bytearray()
+        self.frames = 0
+        self.presented = 0
+        self.errors = 0
+
+    def feed(self, data):
+        self.buf += data
+        acks = []
+        while True:
+            i = self.buf.find(SYNC)
+            if i < 0 or len(self.buf) - i < HDR_SIZE:
+                return acks
+            hdr = self.buf[i:i + HDR_SIZE]
+            ftype, flags, seq, x, y, w, h, hcrc = struct.unpack("<BBHHHHHH", hdr[2:])
+            ok = crc16(hdr[2:14]) == hcrc and x + w <= self.width and y + h <= self.height
+            if ftype == FULL:
+                ok = ok and (x, y, w, h) == (0, 0, self.width, self.height)
+            if not ok:
+                self.errors += 1
+                del self.buf[:i + 1]
+                acks.append((seq, 1))
+                continue
+            end = i + HDR_SIZE + w * h * 2 + 2
+            if len(self.buf) < end:
+                return acks
+            payload = self.buf[i + HDR_SIZE:end - 2]
+            (pcrc,) = struct.unpack("<H", self.buf[end - 2:end])
+            del self.buf[:end]
+            if crc16(payload) != pcrc:
+                self.errors += 1
+                acks.append((seq, 2))
+                continue
+            self.frames += 1
+            if ftype == FULL or flags & FLAG_PRESENT:
+                self.presented += 1
+            acks.append((seq, 0))
+
+
+def frames(args):
+    seq = 0
+    t = 0
+    while True:
+        if args.rect:
+            # Sweep a small rect across the panel: the delta path
+            rw, rh = args.rect
+            cols = max(1, args.width // rw)
+            rows = max(1, args.height // rh)
+            cell = t % (cols * rows)
+            x, y = (cell % cols) * rw, (cell // cols) * rh
+            yield encode(RECT, FLAG_PRESENT, seq, x, y, rw, rh, pattern(t, x, y, rw, rh))
+        else:
+            yield encode(FULL, FLAG_PRESENT, seq, 0, 0, args.width, args.height,
+                         pattern(t, 0, 0, args.width, args.height))
+        seq += 1
+        t += 1
+
+
+def read_acks(ser, pending, stats):
+    data = ser.read(ser.in_waiting or 1)
+    stats["rx"] += data
+    while True:
+        i = stats["rx"].find(ACK_SYNC)
+        if i < 0 or len(stats["rx"]) - i < 5:
+            # keep a possible partial ack, drop log text before it
+            stats["rx"] = stats["rx"][-4:]
+            return
+        seq, status = struct.unpack("<HB", stats["rx"][i + 2:i + 5])
+        del stats["rx"][:i + 5]
+        if seq in pending:
+            pending.discard(seq)
+            stats[ACK_NAMES.get(status, "ok")] += 1
+
+
+def run_serial(args):
+    import serial
+
+    ser = serial.Serial(args.port, args.baud, timeout=0.05)
+    stats = {"ok": 0, "bad header": 0, "bad crc": 0, "rx": bytearray()}
+    pending = set()
+    sent_bytes = 0
+    start = time.monotonic()
+    last_report = start
+
+    for n, frame in enumerate(frames(args)):
+        seq = struct.unpack("<H", frame[4:6])[0]
+        # Keep at most --window frames in flight so the device ring buffer can't overflow
+        while len(pending) >= args.window:
+            read_acks(ser, pending, stats)
+            if time.monotonic() - start > args.seconds + 2:
+                break
+        ser.write(frame)
+        pending.add(seq)
+        sent_bytes += len(frame)
+        read_acks(ser, pending, stats)
+
+        now = time.monotonic()
+        if now - last_report >= 1.0:
+            el = now - start
+            print("%6.1fs  %6.1f fps acked  %7.1f KiB/s  errors %d/%d" %
+                  (el, stats["ok"] / el, sent_bytes / el / 1024, stats["bad header"], stats["bad crc"]))
+            last_report = now
+        if now - start >= args.seconds:
+            break
+
+    deadline = time.monotonic() + 0.5
+    while pending and time.monotonic() < deadline:
+        read_acks(ser, pending, stats)
+
+    el = time.monotonic() - start
+    print("sustained %.1f fps over %.1f s (%d ok, %d bad header, %d bad crc, %d unacked)" %
+          (stats["ok"] / el, el, stats["ok"], stats["bad header"], stats["bad crc"], len(pending)))
+
+
+def run_selftest(args):
+    dec = Decoder(args.width, args.height)
+    gen = frames(args)
+    start = time.monotonic()
+    n = 0
+    wire = 0
+    while time.monotonic() - start < min(args.seconds, 3):
+        frame = next(gen)
+        # corrupt every 50th frame to exercise the CRC path
+        if n % 50 == 49:
+            frame = frame[:-3] + bytes([frame[-3] ^ 0xFF]) + frame[-2:]
+        acks = dec.feed(frame)
+        wire += len(frame)
+        n += 1
+        assert len(acks) == 1, acks
+    el = time.monotonic() - start
+    bits_per_frame = wire * 10 / n
+    print("selftest: %d frames, %d decoded, %d rejected, encode+decode %.1f fps on this PC" %
+          (n, dec.frames, dec.errors, n / el))
+    print("wire limit at %d baud: %.1f fps" % (args.baud, args.baud / bits_per_frame))
+    expected_bad = n // 50
+    if dec.errors != expected_bad or dec.frames != n - expected_bad:
+        print("FAIL")
+        return 1
+    print("PASS")
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--port")
+    ap.add_argument("--baud", type=int, default=2000000)
+    ap.add_argument("--width", type=int, default=64)
+    ap.add_argument("--height", type=int, default=32)
+    ap.add_argument("--rect", type=int, nargs=2, metavar=("W", "H"), help="send W x H deltas instead of full frames")
+    ap.add_argument("--seconds", type=float, default=10)
+    ap.add_argument("--window", type=int, default=2, help="frames in flight before waiting for an ack")
+    ap.add_argument("--selftest", action="store_true")
+    args = ap.parse_args()
+
+    if args.selftest:
+        return run_selftest(args)
+    if not args.port:
+        ap.error("--port is required unless --selftest")
+    run_serial(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())